@@ -35,6 +35,7 @@ amr.mffile_nstreams           (def:  1)
 amr.plot_headerversion        (def:  Version_v1  (1) )
 amr.checkpoint_headerversion  (def:  Version_v1  (1) )
 amr.prereadFAHeaders          (def:  true)
+amr.readFAHeadersPerRank      (def:  false)
 amr.precreateDirectories      (def:  true)
 
 particles.particles_nfiles = 1024
@@ -2,11 +2,13 @@
 #include <cstdio>
 #include <list>
 #include <iostream>
+#include <fstream>
 #include <iomanip>
 #include <sstream>
 #include <iomanip>
 #include <limits>
 #include <cmath>
+#include <numeric>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -29,12 +31,14 @@
 #include <AMReX_PROB_AMR_F.H>
 #include <AMReX_Amr.H>
 #include <AMReX_ParallelDescriptor.H>
+#include <AMReX_ParallelReduce.H>
 #include <AMReX_Utility.H>
 #include <AMReX_DistributionMapping.H>
 #include <AMReX_FabSet.H>
 #include <AMReX_StateData.H>
 #include <AMReX_PlotFileUtil.H>
 #include <AMReX_Print.H>
+#include <AMReX_InSituReduction.H>
 
 #ifdef AMREX_USE_FBOXLIB_MG
 #include <mg_cpp_f.h>
@@ -113,6 +117,7 @@ namespace
     bool plot_files_output;
     int  checkpoint_nfiles;
     int  regrid_on_restart;
+    int  restart_max_level;
     int  use_efficient_regrid;
     int  plotfile_on_restart;
     int  insitu_on_restart;
@@ -121,6 +126,7 @@ namespace
     int  compute_new_dt_on_regrid;
     bool precreateDirectories;
     bool prereadFAHeaders;
+    bool readFAHeadersPerRank;
     VisMF::Header::Version plot_headerversion(VisMF::Header::Version_v1);
     VisMF::Header::Version checkpoint_headerversion(VisMF::Header::Version_v1);
 //}
@@ -148,6 +154,7 @@ Amr::Initialize ()
     plot_files_output        = true;
     checkpoint_nfiles        = 64;
     regrid_on_restart        = 0;
+    restart_max_level        = -1;
     use_efficient_regrid     = 0;
     plotfile_on_restart      = 0;
     insitu_on_restart        = 0;
@@ -156,6 +163,7 @@ Amr::Initialize ()
     compute_new_dt_on_regrid = 0;
     precreateDirectories     = true;
     prereadFAHeaders         = true;
+    readFAHeadersPerRank     = false;
     plot_headerversion       = VisMF::Header::Version_v1;
     checkpoint_headerversion = VisMF::Header::Version_v1;
 #ifdef BL_USE_SENSEI_INSITU
@@ -287,6 +295,7 @@ Amr::InitAmr ()
     // Check for command line flags.
     //
     pp.query("regrid_on_restart",regrid_on_restart);
+    pp.query("restart_max_level",restart_max_level);
     pp.query("use_efficient_regrid",use_efficient_regrid);
     pp.query("plotfile_on_restart",plotfile_on_restart);
     pp.query("insitu_on_restart",insitu_on_restart);
@@ -519,11 +528,29 @@ Amr::InitAmr ()
 
     loadbalance_max_fac = 1.5;
     pp.query("loadbalance_max_fac", loadbalance_max_fac);
+
+    loadbalance_with_measured_cost = 0;
+    pp.query("loadbalance_with_measured_cost", loadbalance_with_measured_cost);
+
+    loadbalance_cost_smoothing = 0.5;
+    pp.query("loadbalance_cost_smoothing", loadbalance_cost_smoothing);
+
+    loadbalance_threshold = 0.0;
+    pp.query("loadbalance_threshold", loadbalance_threshold);
+
+    lb_predicted_eff.resize(nlev, -1.0);
+    lb_dm.resize(nlev);
 }
 
 int
 Amr::initInSitu()
 {
+    if (InSituReduction::enabled())
+    {
+        const bool append = !restart_chkfile.empty() && restart_chkfile != "init";
+        insitu_reduction.reset(new InSituReduction(*this, append));
+    }
+
 #if defined(BL_USE_SENSEI_INSITU)
     insitu_bridge = new AmrInSituBridge;
     if (insitu_bridge->initialize())
@@ -538,6 +565,10 @@ Amr::initInSitu()
 int
 Amr::updateInSitu()
 {
+    if (insitu_reduction) {
+        insitu_reduction->update(*this);
+    }
+
 #if defined(BL_USE_SENSEI_INSITU)
     if (insitu_bridge && insitu_bridge->update(this))
     {
@@ -1463,20 +1494,50 @@ Amr::restart (const std::string& filename)
       if(faHeaderFileChars.size() > 0) {  // ---- headers were read
         std::string faFileCharPtrString(faHeaderFileChars.dataPtr());
         std::istringstream fais(faFileCharPtrString, std::istringstream::in);
-        while ( ! fais.eof()) {  // ---- read and broadcast each header
+        Vector<std::string> faHeaderFullNames;
+        while ( ! fais.eof()) {
           std::string faHeaderName;
           fais >> faHeaderName;
           if( ! fais.eof()) {
-            std::string faHeaderFullName(filename + '/' + faHeaderName + "_H");
-            Vector<char> &tempCharArray = faHeaderMap[faHeaderFullName];
-            ParallelDescriptor::ReadAndBcastFile(faHeaderFullName, tempCharArray);
-	    if(verbose > 2) {
-		amrex::Print() 
-		    << ":::: faHeaderName faHeaderFullName tempCharArray.size() = " << faHeaderName
-		    << "  " << faHeaderFullName << "  " << tempCharArray.size() << "\n";
-	    }
+            // ---- skip the levels that will not be restarted
+            int hlev(-1);
+            if(restart_max_level >= 0
+               && std::sscanf(faHeaderName.c_str(), "Level_%d/", &hlev) == 1
+               && hlev > restart_max_level)
+            {
+              continue;
+            }
+            faHeaderFullNames.push_back(filename + '/' + faHeaderName + "_H");
           }
         }
+        Vector<Vector<char> > faHeaders;
+        if(readFAHeadersPerRank) {
+          // ---- every rank reads the headers itself, with no broadcasts
+          faHeaders.resize(faHeaderFullNames.size());
+          for(int i(0); i < faHeaderFullNames.size(); ++i) {
+            std::ifstream iss(faHeaderFullNames[i].c_str(), std::ios::in | std::ios::binary);
+            if( ! iss.good()) {
+              amrex::FileOpenFailed(faHeaderFullNames[i]);
+            }
+            iss.seekg(0, std::ios::end);
+            const long fileLength(static_cast<std::streamoff>(iss.tellg()));
+            iss.seekg(0, std::ios::beg);
+            faHeaders[i].resize(fileLength + 1);
+            iss.read(faHeaders[i].dataPtr(), fileLength);
+            faHeaders[i][fileLength] = '\0';
+          }
+        } else {
+          // ---- the headers are read concurrently by all ranks
+          ParallelDescriptor::ReadAndBcastFiles(faHeaderFullNames, faHeaders);
+        }
+        for(int i(0); i < faHeaderFullNames.size(); ++i) {
+          faHeaderMap[faHeaderFullNames[i]].swap(faHeaders[i]);
+	  if(verbose > 2) {
+	      amrex::Print()
+		  << ":::: faHeaderFullName size = "
+		  << faHeaderFullNames[i] << "  " << faHeaderMap[faHeaderFullNames[i]].size() << "\n";
+	  }
+        }
         StateData::SetFAHeaderMapPtr(&faHeaderMap);
       }
     }
@@ -1524,6 +1585,17 @@ Amr::restart (const std::string& filename)
     is >> mx_lev;
     is >> finest_level;
 
+    // Restart only the coarse levels; the finer ones are rebuilt by a regrid.
+    const bool partial_restart = restart_max_level >= 0 && restart_max_level < finest_level;
+    if (partial_restart)
+    {
+        if (verbose > 0) {
+            amrex::Print() << "Restarting levels 0 to " << restart_max_level
+                           << " of " << finest_level << "\n";
+        }
+        finest_level = restart_max_level;
+    }
+
     Vector<Box> inputs_domain(max_level+1);
     for (int lev = 0; lev <= max_level; ++lev)
     {
@@ -1598,12 +1670,12 @@ Amr::restart (const std::string& filename)
            }
        }
 
-       if (regrid_on_restart && max_level > 0)
+       if ((regrid_on_restart || partial_restart) && max_level > 0)
        {
            if (regrid_int[0] > 0) {
                level_count[0] = regrid_int[0];
 	   } else {
-               amrex::Error("restart: can't have regrid_on_restart and regrid_int <= 0");
+               amrex::Error("restart: can't have regrid_on_restart or restart_max_level and regrid_int <= 0");
 	   }
        }
 
@@ -1666,11 +1738,11 @@ Amr::restart (const std::string& filename)
        for (int i(0)            ; i <= max_level; ++i) { is >> level_count[i]; }
        for (int i(max_level + 1); i <= mx_lev   ; ++i) { is >> int_dummy; }
 
-       if (regrid_on_restart && max_level > 0) {
+       if ((regrid_on_restart || partial_restart) && max_level > 0) {
            if (regrid_int[0] > 0)  {
                level_count[0] = regrid_int[0];
 	   } else {
-               amrex::Error("restart: can't have regrid_on_restart and regrid_int <= 0");
+               amrex::Error("restart: can't have regrid_on_restart or restart_max_level and regrid_int <= 0");
 	   }
        }
 
@@ -1941,6 +2013,76 @@ Amr::timeStep (int  level,
     BL_PROFILE("Amr::timeStep()");
     BL_COMM_PROFILE_NAMETAG("Amr::timeStep TOP");
 
+    prepareAdvance(level,time,stop_time);
+
+#ifdef USE_PERILLA
+    }
+    perilla::syncAllWorkerThreads();
+#endif
+
+    BL_PROFILE_REGION_START("amr_level.advance");
+    Real dt_new = amr_level[level]->advance(time,dt_level[level],iteration,niter);
+    BL_PROFILE_REGION_STOP("amr_level.advance");
+
+#ifdef USE_PERILLA
+    perilla::syncWorkerThreads();
+    if(perilla::isMasterThread())
+    {
+#endif
+
+    finishAdvance(level,time,iteration,dt_new);
+
+#ifdef USE_PERILLA
+    }
+    perilla::syncAllWorkerThreads();
+#endif
+
+    //
+    // Advance grids at higher level.
+    //
+    if (level < finest_level)
+    {
+        const int lev_fine = level+1;
+
+        if (sub_cycle)
+        {
+            const int ncycle = n_cycle[lev_fine];
+
+            BL_COMM_PROFILE_NAMETAG("Amr::timeStep timeStep subcycle");
+            for (int i = 1; i <= ncycle; i++)
+                timeStep(lev_fine,time+(i-1)*dt_level[lev_fine],i,ncycle,stop_time);
+        }
+        else
+        {
+            BL_COMM_PROFILE_NAMETAG("Amr::timeStep timeStep nosubcycle");
+            timeStep(lev_fine,time,1,1,stop_time);
+        }
+    }
+
+#ifdef USE_PERILLA
+    perilla::syncAllWorkerThreads();
+#endif
+
+    amr_level[level]->post_timestep(iteration);
+
+#ifdef USE_PERILLA
+    perilla::syncAllWorkerThreads();
+    if(perilla::isMasterThread())
+    {
+#endif
+    // Set this back to negative so we know whether we are in fact in this routine
+    which_level_being_advanced = -1;
+#ifdef USE_PERILLA
+    }
+    perilla::syncAllWorkerThreads();
+#endif
+}
+
+void
+Amr::prepareAdvance (int  level,
+                     Real time,
+                     Real stop_time)
+{
     // This is used so that the AmrLevel functions can know which level is being advanced 
     //      when regridding is called with possible lbase > level.
     which_level_being_advanced = level;
@@ -2045,7 +2187,8 @@ memcheck.report();
         delete metadataChanged;
 #endif
 
-        if (max_level == 0 && loadbalance_level0_int > 0 && loadbalance_with_workestimates)
+        if (max_level == 0 && loadbalance_level0_int > 0 &&
+            (loadbalance_with_workestimates || loadbalance_with_measured_cost))
         {
             if (level_steps[0] == 1 || level_count[0] >= loadbalance_level0_int) {
                 LoadBalanceLevel0(time);
@@ -2070,24 +2213,18 @@ memcheck.report();
 	amrex::Print() << "[Level " << level << " step " << level_steps[level]+1 << "] "
 		       << "ADVANCE with dt = " << dt_level[level] << "\n";
     }
+}
 
-#ifdef USE_PERILLA
-    }
-    perilla::syncAllWorkerThreads();
-#endif
-
-    BL_PROFILE_REGION_START("amr_level.advance");
-    Real dt_new = amr_level[level]->advance(time,dt_level[level],iteration,niter);
-    BL_PROFILE_REGION_STOP("amr_level.advance");
-
-#ifdef USE_PERILLA
-    perilla::syncWorkerThreads();
-    if(perilla::isMasterThread())
-    {
-#endif
-
+void
+Amr::finishAdvance (int  level,
+                    Real time,
+                    int  iteration,
+                    Real dt_new)
+{
     dt_min[level] = iteration == 1 ? dt_new : std::min(dt_min[level],dt_new);
 
+    amr_level[level]->updateCostEstimate(loadbalance_cost_smoothing);
+
     level_steps[level]++;
     level_count[level]++;
 
@@ -2120,51 +2257,6 @@ memcheck.report();
 //        getLevel(level).initPerilla(cumtime);
 #endif
     }
-
-#ifdef USE_PERILLA
-    }
-    perilla::syncAllWorkerThreads();
-#endif
-
-    //
-    // Advance grids at higher level.
-    //
-    if (level < finest_level)
-    {
-        const int lev_fine = level+1;
-
-        if (sub_cycle)
-        {
-            const int ncycle = n_cycle[lev_fine];
-
-            BL_COMM_PROFILE_NAMETAG("Amr::timeStep timeStep subcycle");
-            for (int i = 1; i <= ncycle; i++)
-                timeStep(lev_fine,time+(i-1)*dt_level[lev_fine],i,ncycle,stop_time);
-        }
-        else
-        {
-            BL_COMM_PROFILE_NAMETAG("Amr::timeStep timeStep nosubcycle");
-            timeStep(lev_fine,time,1,1,stop_time);
-        }
-    }
-
-#ifdef USE_PERILLA
-    perilla::syncAllWorkerThreads();
-#endif
-
-    amr_level[level]->post_timestep(iteration);
-
-#ifdef USE_PERILLA
-    perilla::syncAllWorkerThreads();
-    if(perilla::isMasterThread())
-    {
-#endif
-    // Set this back to negative so we know whether we are in fact in this routine
-    which_level_being_advanced = -1;
-#ifdef USE_PERILLA
-    }
-    perilla::syncAllWorkerThreads();
-#endif
 }
 
 Real
@@ -2353,7 +2445,11 @@ Amr::coarseTimeStep (Real stop_time)
 
 #else
     //synchronous
-    timeStep(0,cumtime,1,1,stop_time);
+    if (subcycle_scheduler) {
+        subcycle_scheduler->run(cumtime,stop_time);
+    } else {
+        timeStep(0,cumtime,1,1,stop_time);
+    }
 #endif
 
 #ifdef USE_PERILLA_PTHREADS
@@ -2671,7 +2767,8 @@ Amr::regrid (int  lbase,
     grid_places(lbase,time,new_finest, new_grid_places);
 
     bool regrid_level_zero = (!initial) && (lbase == 0)
-        && ( loadbalance_with_workestimates || (new_grid_places[0] != amr_level[0]->boxArray()));
+        && ( loadbalance_with_workestimates || loadbalance_with_measured_cost
+             || (new_grid_places[0] != amr_level[0]->boxArray()));
 
     const int start = regrid_level_zero ? 0 : lbase+1;
 
@@ -2728,7 +2825,7 @@ Amr::regrid (int  lbase,
         // Construct skeleton of new level.
         //
 
-        if (loadbalance_with_workestimates && !initial) {
+        if ((loadbalance_with_workestimates || loadbalance_with_measured_cost) && !initial) {
             new_dmap[lev] = makeLoadBalanceDistributionMap(lev, time, new_grid_places[lev]);
         }
         else if (new_dmap[lev].empty()) {
@@ -2829,7 +2926,7 @@ Amr::regrid (int  lbase,
 }
 
 DistributionMapping
-Amr::makeLoadBalanceDistributionMap (int lev, Real time, const BoxArray& ba) const
+Amr::makeLoadBalanceDistributionMap (int lev, Real time, const BoxArray& ba)
 {
     BL_PROFILE("makeLoadBalanceDistributionMap()");
 
@@ -2841,8 +2938,87 @@ Amr::makeLoadBalanceDistributionMap (int lev, Real time, const BoxArray& ba) con
 
     const int work_est_type = amr_level[0]->WorkEstType();
 
-    if (work_est_type < 0) {
+    Real navg = static_cast<Real>(ba.size()) / static_cast<Real>(ParallelDescriptor::NProcs());
+    int nmax = std::max(std::round(loadbalance_max_fac*navg), std::ceil(navg));
+
+    Vector<Real> measured_cost;
+    if (loadbalance_with_measured_cost && amr_level[lev]) {
+        measured_cost = amr_level[lev]->costEstimate();
+    }
+
+    if (!measured_cost.empty())
+    {
+        const BoxArray& oldba = boxArray(lev);
+        const DistributionMapping& olddm = DistributionMap(lev);
+
+        if (verbose && lb_predicted_eff[lev] > 0.0 && DistributionMapping::SameRefs(olddm, lb_dm[lev]))
+        {
+            // The efficiency actually achieved in the last step, not the smoothed one.
+            const Vector<Real> last_cost = amr_level[lev]->lastMeasuredCost();
+            if (!last_cost.empty()) {
+                amrex::Print() << "  Level " << lev << " load balance efficiency: predicted "
+                               << lb_predicted_eff[lev] << ", measured "
+                               << DistributionMapping::efficiency(olddm, last_cost) << "\n";
+            }
+        }
+
+        const Vector<Real>& cost = (ba == oldba) ? measured_cost
+                                                 : estimateCost(oldba, measured_cost, ba);
+
+        DistributionMapping dmtmp;
+        if (ba == oldba) {
+            dmtmp = olddm;
+        } else {
+            // The current map carried over to the new boxes: each new box
+            // goes to the owner of the old box it overlaps most, and a box
+            // that overlaps none to where the default map puts it.
+            Vector<int> pmap = DistributionMapping(ba).ProcessorMap();
+            std::vector< std::pair<int,Box> > isects;
+            for (int i = 0, N = ba.size(); i < N; ++i)
+            {
+                long nmost = 0;
+                oldba.intersections(ba[i], isects);
+                for (const auto& is : isects)
+                {
+                    if (is.second.numPts() > nmost) {
+                        nmost = is.second.numPts();
+                        pmap[i] = olddm[is.first];
+                    }
+                }
+            }
+            dmtmp.define(std::move(pmap));
+        }
+
+        if (DistributionMapping::strategy() == DistributionMapping::SFC) {
+            newdm = DistributionMapping::makeSFC(cost, ba);
+        } else {
+            newdm = DistributionMapping::makeKnapSack(cost, nmax);
+        }
+
+        const Real old_eff = DistributionMapping::efficiency(dmtmp, cost);
+        const Real new_eff = DistributionMapping::efficiency(newdm, cost);
+
         if (verbose) {
+            amrex::Print() << "  Level " << lev << " predicted load balance efficiency: current "
+                           << old_eff << ", new " << new_eff << "\n";
+        }
+
+        if (new_eff < old_eff*(1.0+loadbalance_threshold))
+        {
+            if (verbose) {
+                amrex::Print() << "  Level " << lev << " keeps its distribution map\n";
+            }
+            newdm = dmtmp;
+            lb_predicted_eff[lev] = old_eff;
+        }
+        else
+        {
+            lb_predicted_eff[lev] = new_eff;
+        }
+        lb_dm[lev] = newdm;
+    }
+    else if (work_est_type < 0) {
+        if (verbose && loadbalance_with_workestimates) {
             amrex::Print() << "\nAMREX WARNING: work estimates type does not exist!\n\n";
         }
         newdm.define(ba);
@@ -2859,9 +3035,6 @@ Amr::makeLoadBalanceDistributionMap (int lev, Real time, const BoxArray& ba) con
         MultiFab workest(ba, dmtmp, 1, 0, MFInfo(), FArrayBoxFactory());
         AmrLevel::FillPatch(*amr_level[lev], workest, 0, time, work_est_type, 0, 1, 0);
 
-        Real navg = static_cast<Real>(ba.size()) / static_cast<Real>(ParallelDescriptor::NProcs());
-        int nmax = std::max(std::round(loadbalance_max_fac*navg), std::ceil(navg));
-
         newdm = DistributionMapping::makeKnapSack(workest, nmax);
     }
     else
@@ -2872,6 +3045,43 @@ Amr::makeLoadBalanceDistributionMap (int lev, Real time, const BoxArray& ba) con
     return newdm;
 }
 
+Vector<Real>
+Amr::estimateCost (const BoxArray& oldba, const Vector<Real>& oldcost, const BoxArray& ba)
+{
+    BL_PROFILE("Amr::estimateCost()");
+
+    // Spread the measured cost of every old box uniformly over its cells
+    // and sum it over the new boxes.  Cells not covered by the old boxes
+    // are charged the average cost per cell.
+    const Real avg = std::accumulate(oldcost.begin(), oldcost.end(), 0.0)
+        / static_cast<Real>(oldba.numPts());
+
+    Vector<Real> cost(ba.size(), 0.0);
+
+    const int nprocs = ParallelContext::NProcsSub();
+    const int myproc = ParallelContext::MyProcSub();
+
+    std::vector< std::pair<int,Box> > isects;
+
+    for (int i = myproc; i < ba.size(); i += nprocs)
+    {
+        const Box& bx = ba[i];
+        long ncovered = 0;
+        oldba.intersections(bx, isects);
+        for (const auto& is : isects)
+        {
+            const long npts = is.second.numPts();
+            cost[i] += oldcost[is.first] * (static_cast<Real>(npts) / oldba[is.first].numPts());
+            ncovered += npts;
+        }
+        cost[i] += avg * (bx.numPts() - ncovered);
+    }
+
+    ParallelAllReduce::Sum(cost.data(), cost.size(), ParallelContext::CommunicatorSub());
+
+    return cost;
+}
+
 void
 Amr::LoadBalanceLevel0 (Real time)
 {
@@ -3282,6 +3492,21 @@ Amr::initSubcycle ()
         std::string err_message = "Unrecognzied subcycling mode: " + subcycling_mode + "\n";
         amrex::Error(err_message.c_str());
     }
+
+    std::string scheduler = "recursive";
+    pp.query("subcycle_scheduler", scheduler);
+    if (scheduler == "taskgraph")
+    {
+#ifdef USE_PERILLA
+        amrex::Error("amr.subcycle_scheduler = taskgraph is not supported with Perilla");
+#endif
+        subcycle_scheduler.reset(new SubcycleScheduler(*this));
+    }
+    else if (scheduler != "recursive")
+    {
+        std::string err_message = "Unrecognized subcycle scheduler: " + scheduler + "\n";
+        amrex::Error(err_message.c_str());
+    }
 }
 
 void
@@ -3357,6 +3582,7 @@ Amr::initPltAndChk ()
 
     pp.query("precreateDirectories", precreateDirectories);
     pp.query("prereadFAHeaders", prereadFAHeaders);
+    pp.query("readFAHeadersPerRank", readFAHeadersPerRank);
 
     int phvInt(plot_headerversion), chvInt(checkpoint_headerversion);
     pp.query("plot_headerversion", phvInt);
@@ -4,10 +4,12 @@
 #include <unistd.h>
 #include <memory>
 #include <limits>
+#include <algorithm>
 
 #include <AMReX_AmrLevel.H>
 #include <AMReX_Derive.H>
 #include <AMReX_ParallelDescriptor.H>
+#include <AMReX_ParallelReduce.H>
 #include <AMReX_Utility.H>
 #include <AMReX_FillPatchUtil.H>
 #include <AMReX_ParmParse.H>
@@ -165,7 +167,22 @@ AmrLevel::writePlotFile (const std::string& dir,
 	}
     }
 
-    int n_data_items = plot_var_map.size();
+    //
+    // The derived quantities to write to plotfile.
+    //
+    Vector<std::string> derive_names;
+    int n_derive = 0;
+    for (const auto& name : parent->derivePlotVars())
+    {
+        const DeriveRec* rec = derive_lst.get(name);
+        if (rec && rec->deriveType() == IndexType::TheCellType())
+        {
+            derive_names.push_back(name);
+            n_derive += rec->numDerive();
+        }
+    }
+
+    int n_data_items = plot_var_map.size() + n_derive;
 
     // get the time from the first State_Type
     // if the State_Type is ::Interval, this will get t^{n+1/2} instead of t^n
@@ -192,6 +209,13 @@ AmrLevel::writePlotFile (const std::string& dir,
 	    int comp = plot_var_map[i].second;
 	    os << desc_lst[typ].name(comp) << '\n';
         }
+        for (const auto& name : derive_names)
+        {
+            const DeriveRec* rec = derive_lst.get(name);
+            for (int k = 0; k < rec->numDerive(); ++k) {
+                os << rec->variableName(k) << '\n';
+            }
+        }
 
         os << AMREX_SPACEDIM << '\n';
         os << parent->cumTime() << '\n';
@@ -277,7 +301,6 @@ AmrLevel::writePlotFile (const std::string& dir,
     //
     // We combine all of the multifabs -- state, derived, etc -- into one
     // multifab -- plotMF.
-    // NOTE: In this tutorial code, there is no derived data
     int       cnt   = 0;
     const int nGrow = 0;
     MultiFab  plotMF(grids,dmap,n_data_items,nGrow,MFInfo(),Factory());
@@ -293,6 +316,14 @@ AmrLevel::writePlotFile (const std::string& dir,
 	MultiFab::Copy(plotMF,*this_dat,comp,cnt,1,nGrow);
 	cnt++;
     }
+    //
+    // Compute all derived quantities in one batch.
+    //
+    if (!derive_names.empty())
+    {
+        deriveBatch(derive_names,cur_time,plotMF,cnt);
+        cnt += n_derive;
+    }
 
     //
     // Use the Full pathname when naming the MultiFab.
@@ -398,7 +429,13 @@ AmrLevel::set_state_in_checkpoint (Vector<int>& state_in_checkpoint)
 }
 
 void
-AmrLevel::finishConstructor () {}
+AmrLevel::finishConstructor ()
+{
+    m_measured_cost.define(grids, dmap);
+    m_smoothed_cost.define(grids, dmap);
+    m_last_cost.define(grids, dmap);
+    m_cost_nsteps = 0;
+}
 
 void
 AmrLevel::setTimeLevel (Real time,
@@ -1718,7 +1755,7 @@ AmrLevel::derive (const std::string& name,
 
     if (isStateVariable(name,index,scomp))
     {
-        FillPatch(*this,mf,ngrow,time,index,scomp,1);
+        FillPatch(*this,mf,ngrow,time,index,scomp,1,dcomp);
     }
     else if (const DeriveRec* rec = derive_lst.get(name))
     {
@@ -1838,6 +1875,220 @@ AmrLevel::derive (const std::string& name,
     }
 }
 
+void
+AmrLevel::deriveBatch (const Vector<std::string>& names,
+                       Real                       time,
+                       MultiFab&                  mf,
+                       int                        dcomp)
+{
+    BL_PROFILE("AmrLevel::deriveBatch()");
+
+    const int ngrow = mf.nGrow();
+    const int nstate = desc_lst.size();
+
+    // A quantity computed in the batched pass.  For state variables rec is
+    // null and scomp is the component within the state.
+    struct Item
+    {
+        const DeriveRec* rec;
+        int index;
+        int scomp;
+        int dcomp;
+    };
+    Vector<Item> items;
+
+    // Components and ghost cells needed from each state type.
+    Vector<int> comp_lo(nstate, std::numeric_limits<int>::max());
+    Vector<int> comp_hi(nstate, -1);
+    Vector<int> src_ngrow(nstate, 0);
+    Vector<std::vector<bool> > need(nstate);
+
+    int dc = dcomp;
+    for (const auto& name : names)
+    {
+        int index, scomp, ncomp;
+
+        if (isStateVariable(name, index, scomp))
+        {
+            if (state[index].boxArray().CellEqual(mf.boxArray())
+                && desc_lst[index].getType() == mf.ixType())
+            {
+                items.push_back({nullptr, index, scomp, dc});
+                need[index].resize(desc_lst[index].nComp(), false);
+                need[index][scomp] = true;
+                comp_lo[index] = std::min(comp_lo[index], scomp);
+                comp_hi[index] = std::max(comp_hi[index], scomp);
+                src_ngrow[index] = std::max(src_ngrow[index], ngrow);
+            }
+            else
+            {
+                derive(name, time, mf, dc);
+            }
+            dc += 1;
+        }
+        else if (const DeriveRec* rec = derive_lst.get(name))
+        {
+            rec->getRange(0, index, scomp, ncomp);
+
+            bool batch = (rec->derFunc() != static_cast<DeriveFunc>(0) ||
+                          rec->derFunc3D() != static_cast<DeriveFunc3D>(0))
+                && rec->deriveType() == mf.ixType()
+                && state[index].boxArray().CellEqual(mf.boxArray());
+            for (int k = 1; k < rec->numRange() && batch; ++k) {
+                int idx;
+                rec->getRange(k, idx, scomp, ncomp);
+                batch = state[idx].boxArray().CellEqual(state[index].boxArray());
+            }
+
+            if (batch)
+            {
+                Box bx0 = state[index].boxArray()[0];
+                Box bx1 = rec->boxMap()(bx0);
+                const int ngrow_src = ngrow + bx0.smallEnd(0) - bx1.smallEnd(0);
+
+                items.push_back({rec, index, -1, dc});
+                for (int k = 0; k < rec->numRange(); ++k)
+                {
+                    int idx;
+                    rec->getRange(k, idx, scomp, ncomp);
+                    need[idx].resize(desc_lst[idx].nComp(), false);
+                    for (int n = scomp; n < scomp+ncomp; ++n) {
+                        need[idx][n] = true;
+                    }
+                    comp_lo[idx] = std::min(comp_lo[idx], scomp);
+                    comp_hi[idx] = std::max(comp_hi[idx], scomp+ncomp-1);
+                    src_ngrow[idx] = std::max(src_ngrow[idx], ngrow_src);
+                }
+            }
+            else
+            {
+                derive(name, time, mf, dc);
+            }
+            dc += rec->numDerive();
+        }
+        else
+        {
+            derive(name, time, mf, dc);
+            dc += 1;
+        }
+    }
+
+    if (items.empty()) return;
+
+    //
+    // FillPatch every contiguous run of needed components of each state
+    // type once.  Component n of state type i ends up in component
+    // n-comp_lo[i] of srcMF[i].
+    //
+    Vector<std::unique_ptr<MultiFab> > srcMF(nstate);
+    for (int i = 0; i < nstate; ++i)
+    {
+        if (comp_hi[i] < 0) continue;
+
+        srcMF[i].reset(new MultiFab(state[i].boxArray(), dmap, comp_hi[i]-comp_lo[i]+1,
+                                    src_ngrow[i], MFInfo(), *m_factory));
+
+        for (int n = comp_lo[i]; n <= comp_hi[i]; )
+        {
+            if (!need[i][n]) { ++n; continue; }
+            int nend = n;
+            while (nend+1 <= comp_hi[i] && need[i][nend+1]) ++nend;
+            FillPatch(*this, *srcMF[i], src_ngrow[i], time, i, n, nend-n+1, n-comp_lo[i]);
+            n = nend+1;
+        }
+    }
+
+    const Real* dx  = geom.CellSize();
+    const Real  dt  = parent->dtLevel(level);
+
+#if defined(AMREX_CRSEGRNDOMP) || (!defined(AMREX_XSDK) && defined(CRSEGRNDOMP))
+    const bool tiling = true;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+#else
+    const bool tiling = false;
+#endif
+    {
+        FArrayBox tmp;
+
+        for (MFIter mfi(mf,tiling); mfi.isValid(); ++mfi)
+        {
+            int         grid_no = mfi.index();
+            FArrayBox&  dfab    = mf[mfi];
+            const Box&  gtbx    = (tiling) ? mfi.growntilebox() : dfab.box();
+            const int*  dlo     = dfab.loVect();
+            const int*  dhi     = dfab.hiVect();
+	    const int*  lo      = gtbx.loVect();
+	    const int*  hi      = gtbx.hiVect();
+            const RealBox temp    (gtbx,geom.CellSize(),geom.ProbLo());
+            const Real* xlo     = temp.lo();
+
+            for (const auto& it : items)
+            {
+                if (it.rec == nullptr)
+                {
+                    dfab.copy((*srcMF[it.index])[mfi], gtbx, it.scomp-comp_lo[it.index],
+                              gtbx, it.dcomp, 1);
+                    continue;
+                }
+
+                const DeriveRec* rec = it.rec;
+                int index, scomp, ncomp;
+                rec->getRange(0, index, scomp, ncomp);
+
+                const FArrayBox* cfab;
+                int c0;
+                if (rec->numRange() == 1)
+                {
+                    // The source components are contiguous in srcMF.
+                    cfab = &(*srcMF[index])[mfi];
+                    c0   = scomp - comp_lo[index];
+                }
+                else
+                {
+                    const Box& sbx = (*srcMF[index])[mfi].box();
+                    tmp.resize(rec->boxMap()(gtbx) & sbx, rec->numState());
+                    for (int k = 0, tc = 0; k < rec->numRange(); k++, tc += ncomp)
+                    {
+                        rec->getRange(k, index, scomp, ncomp);
+                        tmp.copy((*srcMF[index])[mfi], tmp.box(), scomp-comp_lo[index],
+                                 tmp.box(), tc, ncomp);
+                    }
+                    cfab = &tmp;
+                    c0   = 0;
+                }
+
+                Real*       ddat    = dfab.dataPtr(it.dcomp);
+                int         n_der   = rec->numDerive();
+                Real*       cdat    = const_cast<Real*>(cfab->dataPtr(c0));
+                const int*  clo     = cfab->loVect();
+                const int*  chi     = cfab->hiVect();
+                int         n_state = rec->numState();
+                const int*  dom_lo  = state[index].getDomain().loVect();
+                const int*  dom_hi  = state[index].getDomain().hiVect();
+                const int*  bcr     = rec->getBC();
+
+                if (rec->derFunc() != static_cast<DeriveFunc>(0)){
+                    rec->derFunc()(ddat,AMREX_ARLIM(dlo),AMREX_ARLIM(dhi),&n_der,
+                                   cdat,AMREX_ARLIM(clo),AMREX_ARLIM(chi),&n_state,
+                                   lo,hi,dom_lo,dom_hi,dx,xlo,&time,&dt,bcr,
+                                   &level,&grid_no);
+                } else {
+                    rec->derFunc3D()(ddat,AMREX_ARLIM_3D(dlo),AMREX_ARLIM_3D(dhi),&n_der,
+                                     cdat,AMREX_ARLIM_3D(clo),AMREX_ARLIM_3D(chi),&n_state,
+                                     AMREX_ARLIM_3D(lo),AMREX_ARLIM_3D(hi),
+                                     AMREX_ARLIM_3D(dom_lo),AMREX_ARLIM_3D(dom_hi),
+                                     AMREX_ZFILL(dx),AMREX_ZFILL(xlo),
+                                     &time,&dt,
+                                     AMREX_BCREC_3D(bcr),
+                                     &level,&grid_no);
+                }
+            }
+        }
+    }
+}
+
 //! Update the distribution maps in StateData based on the size of the map
 void
 AmrLevel::UpdateDistributionMaps ( DistributionMapping& update_dmap )
@@ -1845,7 +2096,13 @@ AmrLevel::UpdateDistributionMaps ( DistributionMapping& update_dmap )
     long mapsize = update_dmap.size();
 
     if (dmap.size() == mapsize)
-    { dmap = update_dmap; }
+    {
+        dmap = update_dmap;
+        m_measured_cost.define(grids, dmap);
+        m_smoothed_cost.define(grids, dmap);
+        m_last_cost.define(grids, dmap);
+        m_cost_nsteps = 0;
+    }
 
     for (int i = 0; i < state.size(); ++i)
     {
@@ -2037,6 +2294,62 @@ AmrLevel::estimateWork ()
     return 1.0*countCells();
 }
 
+void
+AmrLevel::updateCostEstimate (Real alpha)
+{
+    if (m_measured_cost.empty()) return;
+
+    const Real beta = (m_cost_nsteps == 0) ? 0.0 : 1.0-alpha;
+
+    for (MFIter mfi(m_measured_cost); mfi.isValid(); ++mfi)
+    {
+        Real& c = m_smoothed_cost[mfi];
+        c = (1.0-beta)*m_measured_cost[mfi] + beta*c;
+        m_last_cost[mfi] = m_measured_cost[mfi];
+        m_measured_cost[mfi] = 0.0;
+    }
+
+    ++m_cost_nsteps;
+}
+
+//
+// Gather the per-box cost of a level onto every rank.  Empty if nothing
+// has been measured.
+//
+static
+Vector<Real>
+GatherCost (const LayoutData<Real>& ld, int nsteps, int nboxes)
+{
+    Vector<Real> cost;
+
+    if (nsteps == 0) return cost;
+
+    cost.resize(nboxes, 0.0);
+    for (MFIter mfi(ld); mfi.isValid(); ++mfi) {
+        cost[mfi.index()] = ld[mfi];
+    }
+
+    ParallelAllReduce::Sum(cost.data(), cost.size(), ParallelContext::CommunicatorSub());
+
+    if (*std::max_element(cost.begin(), cost.end()) <= 0.0) {
+        cost.clear();
+    }
+
+    return cost;
+}
+
+Vector<Real>
+AmrLevel::costEstimate () const
+{
+    return GatherCost(m_smoothed_cost, m_cost_nsteps, grids.size());
+}
+
+Vector<Real>
+AmrLevel::lastMeasuredCost () const
+{
+    return GatherCost(m_last_cost, m_cost_nsteps, grids.size());
+}
+
 bool
 AmrLevel::writePlotNow ()
 {
@@ -2986,6 +3299,7 @@ FillPatchIterator::initFillPatch(int boxGrow, int time, int index, int scomp, in
                           }
 			  Box c_dom= amrex::coarsen(geom_fine->Domain(), m_amrlevel.crse_ratio);
                           m_fpc = &FabArrayBase::TheFPinfo(*(smf_fine[0]), m_fabs, fdomain_g, IntVect(ngrow), coarsener, c_dom);
+                          m_fpc_lock = FabArrayBase::FPinfoLock(*m_fpc);
                       }
 #ifdef USE_PERILLA_PTHREADS
 //                    perilla::syncAllThreads();
@@ -352,6 +352,7 @@ AsyncFillPatchIterator::~AsyncFillPatchIterator () {
 			Box c_dom= amrex::coarsen(geom_fine->Domain(), m_amrlevel.crse_ratio);
 
 			m_fpc = &FabArrayBase::TheFPinfo(*smf_fine[0], m_fabs, fdomain_g, IntVect(ngrow), coarsener, c_dom);
+			m_fpc_lock = FabArrayBase::FPinfoLock(*m_fpc);
 
 			if (!m_fpc->ba_crse_patch.empty())
 			{
@@ -0,0 +1,643 @@
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+
+#include <AMReX_InSituReduction.H>
+#include <AMReX_Amr.H>
+#include <AMReX_AmrLevel.H>
+#include <AMReX_BLProfiler.H>
+#include <AMReX_MultiFabUtil.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_ParallelReduce.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+#include <AMReX_iMultiFab.H>
+
+namespace amrex {
+
+namespace {
+
+IntVect
+levelRatio (const Amr& amr, int lev_crse, int lev_fine)
+{
+    IntVect rr = IntVect::TheUnitVector();
+    for (int lev = lev_crse; lev < lev_fine; ++lev) {
+        rr *= amr.refRatio(lev);
+    }
+    return rr;
+}
+
+Real
+cellVolume (const Geometry& geom)
+{
+    Real vol = 1.0;
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+        vol *= geom.CellSize(idim);
+    }
+    return vol;
+}
+
+//! Index of the cell of geom that contains x in direction idim.
+int
+cellIndex (const Geometry& geom, int idim, Real x)
+{
+    const Box& domain = geom.Domain();
+    int i = static_cast<int>(std::floor((x - geom.ProbLo(idim)) / geom.CellSize(idim)));
+    return std::max(domain.smallEnd(idim), std::min(domain.bigEnd(idim), i));
+}
+
+//! The cells of geom whose centers are in region.
+Box
+regionBox (const Geometry& geom, const RealBox& region)
+{
+    IntVect lo, hi;
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim)
+    {
+        const Real dx = geom.CellSize(idim);
+        lo[idim] = static_cast<int>(std::ceil ((region.lo(idim) - geom.ProbLo(idim))/dx - 0.5));
+        hi[idim] = static_cast<int>(std::floor((region.hi(idim) - geom.ProbLo(idim))/dx - 0.5));
+    }
+    return Box(lo, hi) & geom.Domain();
+}
+
+}
+
+bool
+InSituReduction::enabled ()
+{
+    ParmParse pp("insitu");
+    int ival = -1;
+    pp.query("int", ival);
+    return ival > 0 && pp.countval("reductions") > 0;
+}
+
+InSituReduction::InSituReduction (const Amr& amr, bool append)
+    : m_append(append)
+{
+    define(amr);
+    if (m_append) {
+        m_last_step = lastStep();
+    }
+}
+
+void
+InSituReduction::define (const Amr& amr)
+{
+    ParmParse pp("insitu");
+
+    pp.query("int", m_int);
+    m_prefix = "insitu_";
+    pp.query("prefix", m_prefix);
+
+    Vector<std::string> names;
+    pp.queryarr("reductions", names);
+
+    for (const auto& name : names)
+    {
+        ParmParse ppr("insitu." + name);
+
+        Reduction r;
+        r.name = name;
+
+        std::string type;
+        ppr.get("type", type);
+        if      (type == "minmax")    r.type = MinMax;
+        else if (type == "histogram") r.type = Histogram;
+        else if (type == "average")   r.type = Average;
+        else if (type == "slice")     r.type = Slice;
+        else if (type == "lineout")   r.type = LineOut;
+        else {
+            amrex::Abort("InSituReduction: unknown type " + type + " for insitu." + name);
+        }
+
+        ppr.getarr("vars", r.vars);
+
+        if (r.type == MinMax || r.type == Histogram)
+        {
+            if (ppr.countval("lo") > 0)
+            {
+                Vector<Real> lo, hi;
+                ppr.getarr("lo", lo, 0, AMREX_SPACEDIM);
+                ppr.getarr("hi", hi, 0, AMREX_SPACEDIM);
+                r.region = RealBox(lo.dataPtr(), hi.dataPtr());
+                r.has_region = true;
+            }
+        }
+
+        if (r.type == Histogram)
+        {
+            if (r.vars.size() != 1) {
+                amrex::Abort("InSituReduction: insitu." + name + " histogram takes exactly one variable");
+            }
+            ppr.get("nbins", r.nbins);
+            ppr.get("lo_value", r.bin_lo);
+            ppr.get("hi_value", r.bin_hi);
+            if (r.nbins <= 0 || r.bin_hi <= r.bin_lo) {
+                amrex::Abort("InSituReduction: insitu." + name + " has an empty histogram range");
+            }
+        }
+        else if (r.type == Average || r.type == Slice || r.type == LineOut)
+        {
+            ppr.query("level", r.level);
+            ppr.query("coarsen", r.coarsen);
+            if (r.level < 0 || r.level > amr.maxLevel()) {
+                amrex::Abort("InSituReduction: insitu." + name + ".level is not a valid level");
+            }
+            if (r.coarsen < 1) {
+                amrex::Abort("InSituReduction: insitu." + name + ".coarsen must be positive");
+            }
+
+            const Geometry& geom = amr.Geom(r.level);
+            r.target = geom.Domain();
+
+            if (r.type == Slice)
+            {
+                int dir;
+                Real coord;
+                ppr.get("dir", dir);
+                ppr.get("coord", coord);
+                const int i = cellIndex(geom, dir, coord);
+                r.target.setSmall(dir, i);
+                r.target.setBig(dir, i);
+            }
+            else if (r.type == LineOut)
+            {
+                int dir;
+                Vector<Real> point;
+                ppr.get("dir", dir);
+                ppr.getarr("point", point, 0, AMREX_SPACEDIM);
+                for (int idim = 0; idim < AMREX_SPACEDIM; ++idim)
+                {
+                    if (idim != dir)
+                    {
+                        const int i = cellIndex(geom, idim, point[idim]);
+                        r.target.setSmall(idim, i);
+                        r.target.setBig(idim, i);
+                    }
+                }
+            }
+
+            r.outbox = amrex::coarsen(r.target, r.coarsen);
+            r.out_ba.define(r.outbox);
+            r.out_ba.maxSize(amr.maxGridSize(r.level));
+            r.out_dm.define(r.out_ba);
+        }
+
+        for (const auto& v : r.vars)
+        {
+            if (std::find(m_vars.begin(), m_vars.end(), v) == m_vars.end()) {
+                m_vars.push_back(v);
+            }
+        }
+
+        m_red.push_back(r);
+    }
+
+    // Components of each variable in the data fetched by deriveBatch.
+    Vector<Vector<std::string> > var_comp_names;
+    for (const auto& v : m_vars)
+    {
+        m_var_comp.push_back(m_ncomp);
+
+        Vector<std::string> names;
+        int index, scomp;
+        if (AmrLevel::isStateVariable(v, index, scomp)) {
+            names.push_back(v);
+        } else if (const DeriveRec* rec = AmrLevel::get_derive_lst().get(v)) {
+            const int n = rec->numDerive();
+            for (int k = 0; k < n; ++k) {
+                const std::string& name = rec->variableName(k);
+                names.push_back((n == 1 || name != v) ? name : v + std::to_string(k));
+            }
+        } else {
+            amrex::Abort("InSituReduction: unknown variable " + v);
+        }
+        m_ncomp += names.size();
+        var_comp_names.push_back(names);
+    }
+
+    for (auto& r : m_red)
+    {
+        for (const auto& v : r.vars)
+        {
+            const int i = std::find(m_vars.begin(), m_vars.end(), v) - m_vars.begin();
+            for (int k = 0; k < var_comp_names[i].size(); ++k)
+            {
+                r.comp.push_back(m_var_comp[i] + k);
+                r.comp_names.push_back(var_comp_names[i][k]);
+            }
+        }
+
+        const int ncomp = r.comp.size();
+        r.sum_offset = m_nsum;
+        r.min_offset = m_nmin;
+
+        if (r.type == MinMax)
+        {
+            m_nsum += ncomp + 1;     // volume integrals and region volume
+            m_nmin += 2*ncomp;       // minima and negated maxima
+        }
+        else if (r.type == Histogram)
+        {
+            if (ncomp != 1) {
+                amrex::Abort("InSituReduction: insitu." + r.name + " histogram takes a single component");
+            }
+            m_nsum += r.nbins + 1;   // bin volumes and region volume
+        }
+    }
+}
+
+void
+InSituReduction::update (Amr& amr)
+{
+    if (m_int <= 0 || m_red.empty()) return;
+
+    const int step = amr.levelSteps(0);
+    if (step % m_int == 0 && step != m_last_step) {
+        compute(amr);
+    }
+}
+
+void
+InSituReduction::compute (Amr& amr)
+{
+    BL_PROFILE("InSituReduction::compute()");
+
+    const Real strt_time = amrex::second();
+
+    const int  finest_level = amr.finestLevel();
+    const Real time         = amr.cumTime();
+
+    Vector<Real> sums(m_nsum, 0.0);
+    Vector<Real> mins(m_nmin, std::numeric_limits<Real>::max());
+
+    // The sums of the components and their weight, for the field reductions.
+    Vector<std::unique_ptr<MultiFab> > fields(m_red.size());
+    for (int k = 0; k < m_red.size(); ++k)
+    {
+        const Reduction& r = m_red[k];
+        if (r.type == Average || r.type == Slice || r.type == LineOut)
+        {
+            fields[k].reset(new MultiFab(r.out_ba, r.out_dm, r.comp.size()+1, 0));
+            fields[k]->setVal(0.0);
+        }
+    }
+
+    for (int lev = 0; lev <= finest_level; ++lev)
+    {
+        AmrLevel& amrlevel = amr.getLevel(lev);
+
+        MultiFab data(amrlevel.boxArray(), amrlevel.DistributionMap(), m_ncomp, 0,
+                      MFInfo(), amrlevel.Factory());
+        amrlevel.deriveBatch(m_vars, time, data, 0);
+
+        std::unique_ptr<iMultiFab> mask;
+        if (lev < finest_level) {
+            mask.reset(new iMultiFab(amrex::makeFineMask(data, amr.getLevel(lev+1).boxArray(),
+                                                         amr.refRatio(lev))));
+        }
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            Vector<Real> tsums(m_nsum, 0.0);
+            Vector<Real> tmins(m_nmin, std::numeric_limits<Real>::max());
+
+            accumulate(amr, lev, data, mask.get(), tsums, tmins);
+
+#ifdef _OPENMP
+#pragma omp critical (insitu_reduction)
+#endif
+            {
+                for (long i = 0; i < m_nsum; ++i) {
+                    sums[i] += tsums[i];
+                }
+                for (long i = 0; i < m_nmin; ++i) {
+                    mins[i] = std::min(mins[i], tmins[i]);
+                }
+            }
+        }
+
+        for (int k = 0; k < m_red.size(); ++k)
+        {
+            if (fields[k]) {
+                accumulateField(amr, lev, data, mask.get(), m_red[k], *fields[k]);
+            }
+        }
+    }
+
+    // One reduction per operation for all reductions and all levels.
+    ParallelAllReduce::Sum(sums.data(), sums.size(), ParallelContext::CommunicatorSub());
+    ParallelAllReduce::Min(mins.data(), mins.size(), ParallelContext::CommunicatorSub());
+
+    // The averages of the field reductions, gathered on the I/O processor.
+    const int IOProc = ParallelDescriptor::IOProcessorNumber();
+    Vector<std::unique_ptr<MultiFab> > results(m_red.size());
+    for (int k = 0; k < m_red.size(); ++k)
+    {
+        if (!fields[k]) continue;
+
+        MultiFab& field = *fields[k];
+        const int ncomp = m_red[k].comp.size();
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        for (MFIter mfi(field,true); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.tilebox();
+            FArrayBox& fab = field[mfi];
+            for (IntVect iv = bx.smallEnd(), End = bx.bigEnd(); iv <= End; bx.next(iv))
+            {
+                const Real w = fab(iv, ncomp);
+                for (int n = 0; n < ncomp; ++n) {
+                    fab(iv, n) = (w > 0.0) ? fab(iv, n)/w : 0.0;
+                }
+            }
+        }
+
+        const BoxArray io_ba(m_red[k].outbox);
+        const DistributionMapping io_dm(Vector<int>(1, IOProc));
+        results[k].reset(new MultiFab(io_ba, io_dm, ncomp, 0));
+        results[k]->ParallelCopy(field, 0, 0, ncomp);
+    }
+
+    const int step = amr.levelSteps(0);
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        for (int k = 0; k < m_red.size(); ++k)
+        {
+            Reduction& r = m_red[k];
+            const int nvar = r.comp.size();
+            Vector<Real> value;
+
+            if (r.type == MinMax)
+            {
+                const Real* s = &sums[r.sum_offset];
+                const Real* m = &mins[r.min_offset];
+                const Real vol = s[nvar];
+                const Real nan = std::numeric_limits<Real>::quiet_NaN();
+                for (int n = 0; n < nvar; ++n)
+                {
+                    value.push_back((vol > 0.0) ?  m[n]      : nan);
+                    value.push_back((vol > 0.0) ? -m[nvar+n] : nan);
+                    value.push_back((vol > 0.0) ?  s[n]/vol  : nan);
+                }
+            }
+            else if (r.type == Histogram)
+            {
+                const Real* s = &sums[r.sum_offset];
+                const Real vol = s[r.nbins];
+                for (int b = 0; b < r.nbins; ++b) {
+                    value.push_back((vol > 0.0) ? s[b]/vol : 0.0);
+                }
+            }
+            else
+            {
+                const FArrayBox& fab = (*results[k])[0];
+                for (int n = 0; n < nvar; ++n) {
+                    for (IntVect iv = r.outbox.smallEnd(), End = r.outbox.bigEnd(); iv <= End; r.outbox.next(iv)) {
+                        value.push_back(fab(iv, n));
+                    }
+                }
+            }
+
+            if (!r.header_written)
+            {
+                writeHeader(r);
+                if (!m_append) {
+                    std::ofstream(m_prefix + r.name + ".bin", std::ios::binary | std::ios::trunc);
+                }
+                r.header_written = true;
+            }
+            write(r, step, time, value);
+        }
+    }
+
+    m_last_step = step;
+
+    if (amr.Verbose() > 0)
+    {
+        Real run_time = amrex::second() - strt_time;
+        ParallelDescriptor::ReduceRealMax(run_time,IOProc);
+        amrex::Print() << "InSituReduction: " << m_red.size() << " reductions at step "
+                       << step << " took " << run_time << " seconds\n";
+    }
+}
+
+void
+InSituReduction::accumulate (const Amr& amr, int lev, const MultiFab& data,
+                             const iMultiFab* mask, Vector<Real>& sums,
+                             Vector<Real>& mins) const
+{
+    const Geometry& geom = amr.Geom(lev);
+    const Real      dv   = cellVolume(geom);
+
+    // The cells of each reduction on this level.
+    Vector<Box> cells(m_red.size());
+    for (int k = 0; k < m_red.size(); ++k) {
+        cells[k] = (m_red[k].has_region) ? regionBox(geom, m_red[k].region) : geom.Domain();
+    }
+
+    for (MFIter mfi(data,true); mfi.isValid(); ++mfi)
+    {
+        const FArrayBox& fab = data[mfi];
+        const IArrayBox* msk = (mask) ? &((*mask)[mfi]) : nullptr;
+
+        for (int k = 0; k < m_red.size(); ++k)
+        {
+            const Reduction& r = m_red[k];
+            if (r.type != MinMax && r.type != Histogram) continue;
+
+            const Box bx = mfi.tilebox() & cells[k];
+            if (!bx.ok()) continue;
+
+            const int nvar = r.comp.size();
+            Real* s = &sums[r.sum_offset];
+            Real* m = (r.type == MinMax) ? &mins[r.min_offset] : nullptr;
+
+            for (IntVect iv = bx.smallEnd(), End = bx.bigEnd(); iv <= End; bx.next(iv))
+            {
+                if (msk && (*msk)(iv) != 0) continue;
+
+                if (r.type == MinMax)
+                {
+                    for (int n = 0; n < nvar; ++n)
+                    {
+                        const Real v = fab(iv, r.comp[n]);
+                        s[n] += v*dv;
+                        m[n]      = std::min(m[n],       v);
+                        m[nvar+n] = std::min(m[nvar+n], -v);
+                    }
+                }
+                else
+                {
+                    const Real v = fab(iv, r.comp[0]);
+                    if (v >= r.bin_lo && v <= r.bin_hi)
+                    {
+                        int b = static_cast<int>((v - r.bin_lo) / (r.bin_hi - r.bin_lo) * r.nbins);
+                        s[std::min(b, r.nbins-1)] += dv;
+                    }
+                }
+                s[(r.type == MinMax) ? nvar : r.nbins] += dv;
+            }
+        }
+    }
+}
+
+void
+InSituReduction::accumulateField (const Amr& amr, int lev, const MultiFab& data,
+                                  const iMultiFab* mask, const Reduction& r,
+                                  MultiFab& out) const
+{
+    const int ncomp = r.comp.size();
+    const IntVect crse(r.coarsen);
+
+    // On a level at least as fine as r.level, several cells may fall into
+    // one output cell; on a coarser one, a cell covers several cells of
+    // r.level, which are visited instead.
+    const bool    fine = (lev >= r.level);
+    const IntVect rr   = (fine) ? levelRatio(amr, r.level, lev) : levelRatio(amr, lev, r.level);
+    const Real    dv   = (fine) ? cellVolume(amr.Geom(lev)) : cellVolume(amr.Geom(r.level));
+
+    // The cells visited in each grid, and the partial output of the grid on
+    // its rank.
+    const BoxArray&            ba = data.boxArray();
+    const DistributionMapping& dm = data.DistributionMap();
+    const Box target = (fine) ? amrex::refine(r.target, rr) : r.target;
+    BoxList     bl;
+    Vector<int> pmap;
+    Vector<int> grid;
+    for (int i = 0, N = ba.size(); i < N; ++i)
+    {
+        const Box isect = ((fine) ? ba[i] : amrex::refine(ba[i], rr)) & target;
+        if (isect.ok())
+        {
+            bl.push_back(amrex::coarsen(isect, (fine) ? rr*crse : crse));
+            pmap.push_back(dm[i]);
+            grid.push_back(i);
+        }
+    }
+    if (grid.empty()) return;
+
+    MultiFab partial(BoxArray(bl), DistributionMapping(std::move(pmap)), ncomp+1, 0);
+    partial.setVal(0.0);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(partial); mfi.isValid(); ++mfi)
+    {
+        const int        i   = grid[mfi.index()];
+        FArrayBox&       pfab = partial[mfi];
+        const FArrayBox& fab = data[i];
+        const IArrayBox* msk = (mask) ? &((*mask)[i]) : nullptr;
+        const Box isect = ((fine) ? ba[i] : amrex::refine(ba[i], rr)) & target;
+
+        for (IntVect jv = isect.smallEnd(), End = isect.bigEnd(); jv <= End; isect.next(jv))
+        {
+            const IntVect iv = (fine) ? jv : amrex::coarsen(jv, rr);
+            if (msk && (*msk)(iv) != 0) continue;
+            const IntVect ov = amrex::coarsen(jv, (fine) ? rr*crse : crse);
+            for (int n = 0; n < ncomp; ++n) {
+                pfab(ov, n) += fab(iv, r.comp[n]) * dv;
+            }
+            pfab(ov, ncomp) += dv;
+        }
+    }
+
+    out.ParallelCopy(partial, 0, 0, ncomp+1, 0, 0, Periodicity::NonPeriodic(), FabArrayBase::ADD);
+}
+
+void
+InSituReduction::writeHeader (const Reduction& r) const
+{
+    static const char* type_names[] = { "minmax", "histogram", "average", "slice", "lineout" };
+
+    std::ofstream os(m_prefix + r.name + ".hdr", std::ios::trunc);
+    if (!os.good()) {
+        amrex::FileOpenFailed(m_prefix + r.name + ".hdr");
+    }
+
+    os << "type " << type_names[r.type] << '\n';
+    os << "vars";
+    for (const auto& v : r.comp_names) os << ' ' << v;
+    os << '\n';
+    os << "record long:step double:time long:n double[n]:value\n";
+
+    switch (r.type)
+    {
+    case MinMax:
+        os << "layout var-major (min max mean)\n";
+        break;
+    case Histogram:
+        os << "layout volume fraction per bin\n";
+        os << "nbins " << r.nbins << '\n';
+        os << "range " << r.bin_lo << ' ' << r.bin_hi << '\n';
+        break;
+    default:
+        os << "layout var-major, Fortran order over box\n";
+        os << "level " << r.level << '\n';
+        os << "coarsen " << r.coarsen << '\n';
+        os << "box " << r.outbox << '\n';
+        break;
+    }
+    if (r.has_region) {
+        os << "region " << r.region << '\n';
+    }
+}
+
+void
+InSituReduction::write (const Reduction& r, int step, Real time,
+                        const Vector<Real>& value) const
+{
+    std::ofstream os(m_prefix + r.name + ".bin", std::ios::binary | std::ios::app);
+    if (!os.good()) {
+        amrex::FileOpenFailed(m_prefix + r.name + ".bin");
+    }
+
+    const std::int64_t istep = step;
+    const double       dtime = time;
+    const std::int64_t n     = value.size();
+    os.write(reinterpret_cast<const char*>(&istep), sizeof(istep));
+    os.write(reinterpret_cast<const char*>(&dtime), sizeof(dtime));
+    os.write(reinterpret_cast<const char*>(&n),     sizeof(n));
+
+    for (Real v : value)
+    {
+        const double d = v;
+        os.write(reinterpret_cast<const char*>(&d), sizeof(d));
+    }
+}
+
+int
+InSituReduction::lastStep () const
+{
+    int last = -1;
+    if (ParallelDescriptor::IOProcessor())
+    {
+        for (const auto& r : m_red)
+        {
+            std::ifstream is(m_prefix + r.name + ".bin", std::ios::binary);
+            std::int64_t step, n;
+            double time;
+            while (is.read(reinterpret_cast<char*>(&step), sizeof(step)) &&
+                   is.read(reinterpret_cast<char*>(&time), sizeof(time)) &&
+                   is.read(reinterpret_cast<char*>(&n),    sizeof(n)))
+            {
+                is.seekg(n*sizeof(double), std::ios::cur);
+                if (is) {
+                    last = std::max(last, static_cast<int>(step));
+                }
+            }
+        }
+    }
+    ParallelDescriptor::Bcast(&last, 1, ParallelDescriptor::IOProcessorNumber());
+    return last;
+}
+
+}
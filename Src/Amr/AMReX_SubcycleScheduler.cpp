@@ -0,0 +1,474 @@
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <AMReX_SubcycleScheduler.H>
+#include <AMReX_Amr.H>
+#include <AMReX_AmrLevel.H>
+#include <AMReX_BLProfiler.H>
+#include <AMReX_Interpolater.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_Print.H>
+
+namespace amrex {
+
+int
+SubcycleScheduler::addTask (TaskType type, int level, int iteration, int niter, int grid,
+                            Real time, Real dt)
+{
+    Task t;
+    t.type      = type;
+    t.level     = level;
+    t.iteration = iteration;
+    t.niter     = niter;
+    t.grid      = grid;
+    t.time      = time;
+    t.dt        = dt;
+    t.ndeps     = 0;
+    t.done      = false;
+    t.urgent    = false;
+    m_tasks.push_back(t);
+    m_end.push_back(-1);
+    m_post.push_back(-1);
+    return m_tasks.size()-1;
+}
+
+void
+SubcycleScheduler::addEdge (int from, int to)
+{
+    if (!m_tasks[from].done) {
+        m_tasks[from].successors.push_back(to);
+        m_tasks[to].ndeps++;
+    }
+}
+
+int
+SubcycleScheduler::addStep (int level, int iteration, int niter, Real time,
+                            std::list<int>::iterator pos)
+{
+    const Real dt = m_amr.dt_level[level];
+    const int begin = addTask(Begin,        level, iteration, niter, -1, time, dt);
+    const int end   = addTask(End,          level, iteration, niter, -1, time, dt);
+    const int post  = addTask(PostTimeStep, level, iteration, niter, -1, time, dt);
+    m_end[begin]  = end;
+    m_post[begin] = post;
+    addEdge(begin, end);
+    addEdge(end, post);
+    m_sequence.insert(pos, begin);
+    m_sequence.insert(pos, end);
+    m_sequence.insert(pos, post);
+    return begin;
+}
+
+void
+SubcycleScheduler::run (Real time, Real stop_time)
+{
+    BL_PROFILE("SubcycleScheduler::run()");
+
+    m_tasks.clear();
+    m_end.clear();
+    m_post.clear();
+    m_trace.clear();
+    m_sequence.clear();
+    m_ready_urgent.clear();
+    m_ready.clear();
+    m_ready_urgent.resize(m_amr.maxLevel()+1);
+    m_ready.resize(m_amr.maxLevel()+1);
+    m_finished = false;
+
+    addStep(0, 1, 1, time, m_sequence.end());
+
+    bool threaded = false;
+#ifdef _OPENMP
+    if (omp_get_max_threads() > 1 && !omp_in_parallel()) {
+        for (int lev = 0; lev <= m_amr.finest_level; ++lev) {
+            threaded = threaded || m_amr.amr_level[lev]->supportsGridAdvance();
+        }
+    }
+#endif
+
+    if (threaded)
+    {
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+#ifdef _OPENMP
+            if (omp_get_thread_num() == 0) {
+#endif
+                runSequence(stop_time);
+#ifdef _OPENMP
+            } else {
+                runWorker();
+            }
+#endif
+        }
+    }
+    else
+    {
+        runSequence(stop_time);
+    }
+
+    BL_ASSERT(m_trace.size() == m_tasks.size());
+
+    if (m_amr.Verbose() > 1) {
+        printTrace(amrex::OutStream());
+    }
+}
+
+void
+SubcycleScheduler::runSequence (Real stop_time)
+{
+    for (m_current = m_sequence.begin(); m_current != m_sequence.end(); ++m_current)
+    {
+        const int itask = *m_current;
+
+        // Help with the Grid tasks until this task's local inputs are ready.
+        while (true)
+        {
+            bool ready;
+            int igrid = -1;
+#ifdef _OPENMP
+#pragma omp critical (amrex_subcycle_scheduler)
+#endif
+            {
+                ready = (m_tasks[itask].ndeps == 0);
+                if (!ready) igrid = popReady();
+            }
+            if (ready) break;
+            if (igrid >= 0) {
+                executeGrid(igrid);
+            } else {
+#ifdef _OPENMP
+                if (omp_in_parallel()) {
+                    std::this_thread::yield();
+                    continue;
+                }
+#endif
+                amrex::Abort("SubcycleScheduler: no task is ready");
+            }
+        }
+
+        // A team of its own, so that the MFIter loops of the level-wide
+        // task do not share out their boxes with the worker threads.
+#ifdef _OPENMP
+#pragma omp parallel num_threads(1)
+#endif
+        execute(itask, stop_time);
+
+#ifdef _OPENMP
+#pragma omp critical (amrex_subcycle_scheduler)
+#endif
+        finish(itask);
+    }
+
+#ifdef _OPENMP
+#pragma omp critical (amrex_subcycle_scheduler)
+#endif
+    m_finished = true;
+}
+
+void
+SubcycleScheduler::runWorker ()
+{
+    while (true)
+    {
+        bool finished;
+        int igrid;
+#ifdef _OPENMP
+#pragma omp critical (amrex_subcycle_scheduler)
+#endif
+        {
+            finished = m_finished;
+            igrid = popReady();
+        }
+        if (igrid >= 0) {
+            executeGrid(igrid);
+        } else if (finished) {
+            break;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void
+SubcycleScheduler::execute (int itask, Real stop_time)
+{
+    const Task t = m_tasks[itask];
+    const int lev = t.level;
+
+#ifdef _OPENMP
+#pragma omp critical (amrex_subcycle_scheduler)
+#endif
+    m_trace.push_back(itask);
+
+    if (t.type == Begin)
+    {
+        BL_PROFILE("SubcycleScheduler::Begin");
+
+        m_amr.prepareAdvance(lev, t.time, stop_time);
+
+        // After prepareAdvance, since regridding with load balance may
+        // replace this level too.
+        AmrLevel& amr_level = *m_amr.amr_level[lev];
+
+        const bool grid_advance = amr_level.supportsGridAdvance();
+
+        if (grid_advance)
+        {
+            amr_level.advanceBegin(t.time, t.dt, t.iteration, t.niter);
+        }
+        else
+        {
+            BL_PROFILE_REGION_START("amr_level.advance");
+            Real dt_new = amr_level.advance(t.time, t.dt, t.iteration, t.niter);
+            BL_PROFILE_REGION_STOP("amr_level.advance");
+
+            m_amr.finishAdvance(lev, t.time, t.iteration, dt_new);
+        }
+
+        Vector<int> under;
+        if (grid_advance && lev < m_amr.finest_level) {
+            under = gridsUnderFine(lev);
+        }
+
+#ifdef _OPENMP
+#pragma omp critical (amrex_subcycle_scheduler)
+#endif
+        {
+            Vector<int> grid_tasks;
+            if (grid_advance)
+            {
+                const DistributionMapping& dm = amr_level.DistributionMap();
+                const int myproc = ParallelDescriptor::MyProc();
+                for (int i = 0, N = amr_level.boxArray().size(); i < N; ++i)
+                {
+                    if (dm[i] == myproc)
+                    {
+                        const int igrid = addTask(Grid, lev, t.iteration, t.niter, i, t.time, t.dt);
+                        addEdge(itask, igrid);
+                        addEdge(igrid, m_end[itask]);
+                        grid_tasks.push_back(igrid);
+                    }
+                }
+            }
+
+            spawnFineTasks(itask, grid_tasks, under);
+        }
+    }
+    else if (t.type == End)
+    {
+        BL_PROFILE("SubcycleScheduler::End");
+
+        AmrLevel& amr_level = *m_amr.amr_level[lev];
+
+        if (amr_level.supportsGridAdvance())
+        {
+            Real dt_new = amr_level.advanceEnd(t.time, t.dt, t.iteration, t.niter);
+
+            if (amr_level.postStepRegrid()) {
+                amrex::Error("SubcycleScheduler: post-step regrid is not supported for levels with advanceGrid");
+            }
+
+            m_amr.finishAdvance(lev, t.time, t.iteration, dt_new);
+        }
+    }
+    else
+    {
+        BL_PROFILE("SubcycleScheduler::PostTimeStep");
+
+        m_amr.amr_level[lev]->post_timestep(t.iteration);
+
+        m_amr.which_level_being_advanced = -1;
+    }
+}
+
+void
+SubcycleScheduler::executeGrid (int itask)
+{
+    Task t;
+#ifdef _OPENMP
+#pragma omp critical (amrex_subcycle_scheduler)
+#endif
+    {
+        t = m_tasks[itask];
+        m_trace.push_back(itask);
+    }
+
+    m_amr.amr_level[t.level]->advanceGrid(t.time, t.dt, t.iteration, t.niter, t.grid);
+
+#ifdef _OPENMP
+#pragma omp critical (amrex_subcycle_scheduler)
+#endif
+    finish(itask);
+}
+
+Vector<int>
+SubcycleScheduler::gridsUnderFine (int lev) const
+{
+    const AmrLevel& crse = *m_amr.amr_level[lev];
+    const AmrLevel& fine = *m_amr.amr_level[lev+1];
+    const BoxArray& cba = crse.boxArray();
+
+    Vector<int> grids;
+
+    if (!fine.supportsGridAdvance())
+    {
+        // AmrLevel::advance may read the coarse data anywhere.
+        for (int i = 0, N = cba.size(); i < N; ++i) {
+            grids.push_back(i);
+        }
+        return grids;
+    }
+
+    Vector<Interpolater*> interps;
+    const DescriptorList& desc_lst = AmrLevel::get_desc_lst();
+    for (int t = 0; t < desc_lst.size(); ++t) {
+        for (int n = 0; n < desc_lst[t].nComp(); ++n) {
+            Interpolater* interp = desc_lst[t].interp(n);
+            if (interp && std::find(interps.begin(), interps.end(), interp) == interps.end()) {
+                interps.push_back(interp);
+            }
+        }
+    }
+
+    const IntVect& ratio = m_amr.refRatio(lev);
+    const Geometry& cgeom = m_amr.Geom(lev);
+    const int ngrow = fine.advanceGhostCells();
+    const BoxArray& fba = fine.boxArray();
+
+    BoxList bl;
+    Vector<IntVect> pshifts;
+    for (int i = 0, N = fba.size(); i < N; ++i)
+    {
+        const Box fbx = amrex::grow(fba[i], ngrow);
+        for (Interpolater* interp : interps)
+        {
+            const Box cbx = interp->CoarseBox(fbx, ratio);
+            bl.push_back(cbx);
+            cgeom.periodicShift(cgeom.Domain(), cbx, pshifts);
+            for (const IntVect& iv : pshifts) {
+                bl.push_back(cbx + iv);
+            }
+        }
+    }
+    const BoxArray under(std::move(bl));
+
+    for (int i = 0, N = cba.size(); i < N; ++i) {
+        if (under.intersects(cba[i])) {
+            grids.push_back(i);
+        }
+    }
+    return grids;
+}
+
+void
+SubcycleScheduler::spawnFineTasks (int itask, const Vector<int>& grid_tasks,
+                                   const Vector<int>& under)
+{
+    const Task& t = m_tasks[itask];
+    const int lev = t.level;
+
+    if (lev >= m_amr.finest_level) return;
+
+    const int  lev_fine = lev+1;
+    const int  ncycle   = (m_amr.sub_cycle) ? m_amr.n_cycle[lev_fine] : 1;
+    const Real time     = t.time;
+    const int  crse_post = m_post[itask];
+
+    // The fine steps go before the End of this step in the sequence.
+    std::list<int>::iterator pos = std::next(m_current);
+
+    int first_begin = -1;
+    int prev_post = -1;
+    for (int i = 1; i <= ncycle; ++i)
+    {
+        const Real fine_time = (m_amr.sub_cycle) ? time + (i-1)*m_amr.dt_level[lev_fine] : time;
+        const int begin = addStep(lev_fine, i, ncycle, fine_time, pos);
+        if (prev_post >= 0) {
+            addEdge(prev_post, begin);
+        } else {
+            first_begin = begin;
+        }
+        prev_post = m_post[begin];
+    }
+
+    // Reflux and average down of the coarse level need the whole fine interval.
+    addEdge(prev_post, crse_post);
+
+    // The fine FillPatch needs the coarse grids under it.
+    if (!grid_tasks.empty())
+    {
+        for (int igrid : grid_tasks) {
+            if (std::binary_search(under.begin(), under.end(), m_tasks[igrid].grid)) {
+                addEdge(igrid, first_begin);
+                m_tasks[igrid].urgent = true;
+            }
+        }
+    }
+}
+
+void
+SubcycleScheduler::finish (int itask)
+{
+    Task& t = m_tasks[itask];
+    t.done = true;
+    for (int s : t.successors)
+    {
+        BL_ASSERT(m_tasks[s].ndeps > 0);
+        if (--m_tasks[s].ndeps == 0 && m_tasks[s].type == Grid) {
+            if (m_tasks[s].urgent) {
+                m_ready_urgent[m_tasks[s].level].push_back(s);
+            } else {
+                m_ready[m_tasks[s].level].push_back(s);
+            }
+        }
+    }
+}
+
+int
+SubcycleScheduler::popReady ()
+{
+    // The finer levels are on the critical path of the sequence.
+    for (Vector<std::deque<int> >* queues : {&m_ready_urgent, &m_ready})
+    {
+        for (int lev = queues->size()-1; lev >= 0; --lev)
+        {
+            std::deque<int>& q = (*queues)[lev];
+            if (!q.empty()) {
+                const int itask = q.front();
+                q.pop_front();
+                return itask;
+            }
+        }
+    }
+    return -1;
+}
+
+void
+SubcycleScheduler::printTrace (std::ostream& os) const
+{
+    if (ParallelDescriptor::IOProcessor())
+    {
+        static const char* names[] = {"Begin        ", "Grid         ", "End          ", "PostTimeStep "};
+        os << "SubcycleScheduler: " << m_trace.size() << " tasks\n";
+        for (int itask : m_trace)
+        {
+            const Task& t = m_tasks[itask];
+            os << "  " << names[t.type]
+               << "level " << t.level << " iteration " << t.iteration << "/" << t.niter;
+            if (t.type == Grid) {
+                os << " grid " << t.grid;
+            }
+            os << "\n";
+        }
+    }
+}
+
+}
@@ -6,6 +6,11 @@
 #include <AMReX_ParallelDescriptor.H>
 #include <AMReX_Print.H>
 
+#ifdef AMREX_USE_EB
+#include <AMReX_EB2.H>
+#include <AMReX_EBAmrUtil.H>
+#endif
+
 namespace amrex {
 
 namespace
@@ -61,9 +66,11 @@ AmrMesh::InitAmrMesh (int max_level_in, const Vector<int>& n_cell_in, std::vecto
     use_fixed_upto_level   = 0;
     refine_grid_layout     = true;
     check_input            = true;
+    eb_remove_covered_grids = false;
 
     use_new_chop         = false;
     iterate_on_new_grids = true;
+    share_grids_on_node  = false;
 
     ParmParse pp("amr");
 
@@ -319,6 +326,14 @@ AmrMesh::InitAmrMesh (int max_level_in, const Vector<int>& n_cell_in, std::vecto
 
     pp.query("check_input", check_input);
 
+#ifdef AMREX_USE_EB
+    // fine grids that lie entirely inside the body hold no data
+    pp.query("eb_remove_covered_grids", eb_remove_covered_grids);
+#endif
+
+    // one copy of the grids and distribution maps per node, in shared memory
+    pp.query("share_grids_on_node", share_grids_on_node);
+
     finest_level = -1;
 
     if (check_input) checkInput();
@@ -336,13 +351,19 @@ AmrMesh::MaxRefRatio (int lev) const
 void
 AmrMesh::SetDistributionMap (int lev, const DistributionMapping& dmap_in)
 {
-    if (dmap[lev] != dmap_in) dmap[lev] = dmap_in;
+    if (dmap[lev] != dmap_in) {
+        dmap[lev] = dmap_in;
+        if (share_grids_on_node) dmap[lev].shareOnNode();
+    }
 }
 
 void
 AmrMesh::SetBoxArray (int lev, const BoxArray& ba_in)
 {
-    if (grids[lev] != ba_in) grids[lev] = ba_in;
+    if (grids[lev] != ba_in) {
+        grids[lev] = ba_in;
+        if (share_grids_on_node) grids[lev].shareOnNode();
+    }
 }
 
 void
@@ -706,6 +727,45 @@ AmrMesh::MakeNewGrids (int lbase, Real time, int& new_finest, Vector<BoxArray>&
             }
         }
     }
+
+#ifdef AMREX_USE_EB
+    if (eb_remove_covered_grids && !EB2::IndexSpace::empty())
+    {
+        //
+        // Drop the grids that are entirely covered by the body, finest
+        // level first, keeping those that the next finer level needs
+        // for proper nesting.
+        //
+        for (int lev = new_finest; lev > lbase; --lev)
+        {
+            if (new_grids[lev].empty() || (useFixedCoarseGrids() && lev <= useFixedUpToLevel())) {
+                continue;
+            }
+
+            const BoxArray& ba = new_grids[lev];
+            BoxArray ba_eb = amrex::removeCoveredBoxes(EB2::IndexSpace::top().getLevel(Geom(lev)),
+                                                       Geom(lev), ba);
+            if (ba_eb.size() == ba.size() || ba_eb.empty()) continue;
+
+            if (lev < new_finest)
+            {
+                BoxArray fine_nbhd = amrex::coarsen(new_grids[lev+1], ref_ratio[lev]);
+                fine_nbhd.grow(n_proper+1);
+                BoxList bl(ba.ixType());
+                for (int i = 0, N = ba.size(); i < N; ++i) {
+                    if (ba_eb.contains(ba[i]) || fine_nbhd.intersects(ba[i])) {
+                        bl.push_back(ba[i]);
+                    }
+                }
+                ba_eb = BoxArray(std::move(bl));
+            }
+
+            if (ba_eb.size() < ba.size()) {
+                new_grids[lev] = ba_eb;
+            }
+        }
+    }
+#endif
 }
 
 void
@@ -149,6 +149,8 @@ namespace amrex
                                                                       IntVect(ngrow),
                                                                       coarsener,
                                                                       amrex::coarsen(fgeom.Domain(),ratio));
+            // FillPatchSingleLevel may build other cache entries.
+            FabArrayBase::FPinfoLock fpc_lock(fpc);
 
 	    if ( ! fpc.ba_crse_patch.empty())
 	    {
@@ -311,6 +313,8 @@ namespace amrex
         bool include_physbndry = false;
         const auto& cfinfo = FabArrayBase::TheCFinfo(fine[0], fgeom, IntVect(ngrow),
                                                      include_periodic, include_physbndry);
+        // The copies below may build other cache entries.
+        FabArrayBase::CFinfoLock cfinfo_lock(cfinfo);
 
         if (! cfinfo.ba_cfb.empty())
         {
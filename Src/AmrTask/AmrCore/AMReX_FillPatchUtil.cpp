@@ -133,6 +133,8 @@ namespace amrex
 	    const FabArrayBase::FPinfo& fpc = FabArrayBase::TheFPinfo(*fmf[0], mf, fdomain_g,
                                                                       IntVect(ngrow), coarsener, 
                                                                       amrex::coarsen(fgeom.Domain(),ratio));
+            // FillPatchSingleLevel may build other cache entries.
+            FabArrayBase::FPinfoLock fpc_lock(fpc);
 
 	    if ( ! fpc.ba_crse_patch.empty())
 	    {
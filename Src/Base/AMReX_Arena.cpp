@@ -2,11 +2,13 @@
 #include <AMReX_Arena.H>
 #include <AMReX_BArena.H>
 #include <AMReX_CArena.H>
+#include <AMReX_HugePageArena.H>
 
 #ifndef AMREX_FORTRAN_BOXLIB
 #include <AMReX.H>
 #include <AMReX_Print.H>
 #include <AMReX_ParallelDescriptor.H>
+#include <AMReX_ParmParse.H>
 #endif
 
 namespace amrex {
@@ -44,10 +46,23 @@ Arena::Initialize ()
     BL_ASSERT(the_managed_arena == nullptr);
     BL_ASSERT(the_pinned_arena == nullptr);
     
+    // FAB data in 2 MB huge pages
+    bool use_huge_pages = false;
+    {
+        ParmParse pp("amrex");
+        pp.query("use_huge_pages", use_huge_pages);
+    }
+
 #if defined(BL_COALESCE_FABS)
     the_arena = new CArena;
-#else
+#elif defined(AMREX_USE_GPU)
     the_arena = new BArena;
+#else
+    if (use_huge_pages) {
+        the_arena = new HugePageArena;
+    } else {
+        the_arena = new BArena;
+    }
 #endif
     
 #ifdef AMREX_USE_GPU
@@ -100,8 +115,9 @@ Arena::PrintUsage ()
         const int IOProc   = ParallelDescriptor::IOProcessorNumber();
         if (The_Arena()) {
             CArena* p = dynamic_cast<CArena*>(The_Arena());
-            if (p) {
-                long min_kilobytes = p->heap_space_used() / 1024;
+            HugePageArena* hp = dynamic_cast<HugePageArena*>(The_Arena());
+            if (p || hp) {
+                long min_kilobytes = (p ? p->heap_space_used() : hp->heap_space_used()) / 1024;
                 long max_kilobytes = min_kilobytes;
                 ParallelDescriptor::ReduceLongMin(min_kilobytes, IOProc);
                 ParallelDescriptor::ReduceLongMax(max_kilobytes, IOProc);
@@ -5,6 +5,10 @@
 #include <AMReX_Utility.H>
 #include <AMReX_MFIter.H>
 #include <AMReX_BaseFab.H>
+#include <AMReX_ParmParse.H>
+
+#include <algorithm>
+#include <cstring>
 
 #ifdef BL_MEM_PROFILING
 #include <AMReX_MemProfiler.H>
@@ -27,6 +31,7 @@ long BARef::total_hash_bytes_hwm = 0L;
 
 bool    BARef::initialized = false;
 bool BoxArray::initialized = false;
+long BoxArray::implicit_min_boxes = 0;
 
 namespace {
     const int bl_ignore_max = 100000;
@@ -75,8 +80,14 @@ BARef::BARef (std::istream& is)
 }
 
 BARef::BARef (const BARef& rhs) 
-    : m_abox(rhs.m_abox) // don't copy hash
+    : m_abox(rhs.m_abox), // don't copy hash
+      m_implicit(rhs.m_implicit),
+      m_nimplicit(rhs.m_nimplicit),
+      m_cuts(rhs.m_cuts)
 {
+    if (rhs.m_shared_box) {
+        m_abox.assign(rhs.m_shared_box, rhs.m_shared_box+rhs.m_nshared);
+    }
 #ifdef BL_MEM_PROFILING
     updateMemoryUsage_box(1);
 #endif	    
@@ -88,6 +99,9 @@ BARef::~BARef ()
     updateMemoryUsage_box(-1);
     updateMemoryUsage_hash(-1);
 #endif	    
+    if (m_shared_box) {
+        ParallelDescriptor::FreeNodeShared(m_shared_handle);
+    }
 }
 
 void
@@ -155,6 +169,7 @@ BARef::define (const BoxList& bl)
 #ifdef BL_MEM_PROFILING
     updateMemoryUsage_box(-1);
 #endif
+    m_implicit = false;
     m_abox = bl.data();
 #ifdef BL_MEM_PROFILING
     updateMemoryUsage_box(1);
@@ -167,21 +182,239 @@ BARef::define (BoxList&& bl) noexcept
 #ifdef BL_MEM_PROFILING
     updateMemoryUsage_box(-1);
 #endif
+    m_implicit = false;
     m_abox = std::move(bl.data());
 #ifdef BL_MEM_PROFILING
     updateMemoryUsage_box(1);
 #endif
 }
 
+void
+BARef::defineImplicit (const Box& bx, const IntVect& chunk)
+{
+    BL_ASSERT(m_abox.size() == 0 && bx.ixType().cellCentered());
+    m_implicit = true;
+    m_nimplicit = 1;
+    for (int i = 0; i < AMREX_SPACEDIM; ++i)
+    {
+        // The same cuts as BoxList::maxSize
+        Vector<int>& cuts = m_cuts[i];
+        cuts.clear();
+        cuts.push_back(bx.smallEnd(i));
+        const int len = bx.length(i);
+        if (len > chunk[i])
+        {
+            int ratio = 1;
+            int bs    = chunk[i];
+            int nlen  = len;
+            while ((bs%2 == 0) && (nlen%2 == 0))
+            {
+                ratio *= 2;
+                bs    /= 2;
+                nlen  /= 2;
+            }
+            const int numblk = nlen/bs + (nlen%bs ? 1 : 0);
+            const int sz     = nlen/numblk;
+            const int extra  = nlen%numblk;
+            int hi = bx.bigEnd(i);
+            for (int k = 0; k < numblk-1; k++)
+            {
+                const int ksize = (k < extra ? sz+1 : sz) * ratio;
+                hi -= ksize;
+                cuts.push_back(hi+1);
+            }
+            std::reverse(cuts.begin()+1, cuts.end());
+        }
+        cuts.push_back(bx.bigEnd(i)+1);
+        m_nimplicit *= cuts.size()-1;
+    }
+}
+
+Box
+BARef::implicitBox (long i) const
+{
+    //
+    // BoxList::maxSize chops direction d of each of the M boxes made so
+    // far into n pieces.  Box b keeps the lowest piece and index b, and
+    // the other pieces of Box b follow all M boxes, from the highest down.
+    //
+    IntVect lo, hi;
+    long M = m_nimplicit;
+    for (int d = AMREX_SPACEDIM-1; d >= 0; --d)
+    {
+        const int n = m_cuts[d].size()-1;
+        M /= n;
+        int p = 0;
+        if (i >= M) {
+            const long j = i - M;
+            i = j / (n-1);
+            p = n-1 - static_cast<int>(j % (n-1));
+        }
+        lo[d] = m_cuts[d][p];
+        hi[d] = m_cuts[d][p+1]-1;
+    }
+    return Box(lo,hi);
+}
+
+void
+BARef::materialize ()
+{
+    if (m_implicit)
+    {
+#ifdef BL_MEM_PROFILING
+        updateMemoryUsage_box(-1);
+#endif
+        m_abox.resize(m_nimplicit);
+        const long N = m_nimplicit;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (long i = 0; i < N; ++i) {
+            m_abox[i] = implicitBox(i);
+        }
+        m_implicit = false;
+        m_nimplicit = 0;
+        for (auto& cuts : m_cuts) {
+            Vector<int>().swap(cuts);
+        }
+#ifdef BL_MEM_PROFILING
+        updateMemoryUsage_box(1);
+#endif
+    }
+    else if (m_shared_box)
+    {
+        m_abox.assign(m_shared_box, m_shared_box+m_nshared);
+        clearHash();
+        ParallelDescriptor::FreeNodeShared(m_shared_handle);
+        m_shared_box = nullptr;
+        m_nshared = 0;
+        m_shared_handle = -1;
+#ifdef BL_MEM_PROFILING
+        updateMemoryUsage_box(1);
+#endif
+    }
+}
+
+namespace {
+    //
+    // Layout of a node shared BARef: the header, the boxes, and the bins.
+    //
+    struct SharedBARefHeader
+    {
+        long nbox;
+        long nbins;
+        Box bbox;
+        IntVect crsn;
+    };
+
+    struct SharedBARefLayout
+    {
+        SharedBARefLayout (long nbox, long nbins) {
+            box       = align(sizeof(SharedBARefHeader));
+            bin_key   = align(box       + nbox*sizeof(Box));
+            bin_start = align(bin_key   + nbins*sizeof(long));
+            bin_box   = align(bin_start + (nbins+1)*sizeof(int));
+            bytes     =       bin_box   + nbox*sizeof(int);
+        }
+        static std::size_t align (std::size_t n) { return (n+15)/16*16; }
+        std::size_t box, bin_key, bin_start, bin_box, bytes;
+    };
+}
+
+void
+BARef::shareOnNode ()
+{
+    BL_ASSERT(!m_implicit && m_shared_box == nullptr);
+
+    // The bins are only built, and used, on rank 0 of the node.
+    const bool writer = ParallelDescriptor::MyRankInNode() == 0;
+    BL_ASSERT(!writer || has_hashmap);
+    const long N = size();
+    const SharedBARefLayout wl(N, writer ? nbins : 0);
+
+    int handle;
+    char* p = static_cast<char*>(ParallelDescriptor::AllocNodeShared(
+        wl.bytes, handle, [&] (void* q)
+        {
+            char* c = static_cast<char*>(q);
+            SharedBARefHeader h;
+            h.nbox  = N;
+            h.nbins = nbins;
+            h.bbox  = bbox;
+            h.crsn  = crsn;
+            std::memcpy(c, &h, sizeof(h));
+            std::memcpy(c+wl.box,       m_abox.data(), N*sizeof(Box));
+            std::memcpy(c+wl.bin_key,   pbin_key,      nbins*sizeof(long));
+            std::memcpy(c+wl.bin_start, pbin_start,    (nbins+1)*sizeof(int));
+            std::memcpy(c+wl.bin_box,   pbin_box,      N*sizeof(int));
+        }));
+
+    SharedBARefHeader h;
+    std::memcpy(&h, p, sizeof(h));
+    if (h.nbox != N) {
+        amrex::Abort("BARef::shareOnNode: the BoxArrays on this node differ");
+    }
+    const SharedBARefLayout l(h.nbox, h.nbins);
+
+#ifdef BL_MEM_PROFILING
+    updateMemoryUsage_box(-1);
+    updateMemoryUsage_hash(-1);
+#endif
+    clearHash();
+    Vector<Box>().swap(m_abox);
+
+    m_shared_box    = reinterpret_cast<const Box*>(p + l.box);
+    m_nshared       = N;
+    m_shared_handle = handle;
+
+    bbox       = h.bbox;
+    crsn       = h.crsn;
+    nbins      = h.nbins;
+    pbin_key   = reinterpret_cast<const long*>(p + l.bin_key);
+    pbin_start = reinterpret_cast<const int*>(p + l.bin_start);
+    pbin_box   = reinterpret_cast<const int*>(p + l.bin_box);
+    has_hashmap = true;
+}
+
+bool
+BARef::sameBoxes (const BARef& rhs) const
+{
+    if (!m_implicit && !rhs.m_implicit && !m_shared_box && !rhs.m_shared_box) {
+        return m_abox == rhs.m_abox;
+    } else if (m_implicit && rhs.m_implicit) {
+        return m_cuts == rhs.m_cuts;
+    } else {
+        const long N = size();
+        if (N != rhs.size()) return false;
+        for (long i = 0; i < N; ++i) {
+            if (getBox(i) != rhs.getBox(i)) return false;
+        }
+        return true;
+    }
+}
+
+void
+BARef::clearHash ()
+{
+    Vector<long>().swap(bin_key);
+    Vector<int>().swap(bin_start);
+    Vector<int>().swap(bin_box);
+    nbins = 0;
+    pbin_key = nullptr;
+    pbin_start = nullptr;
+    pbin_box = nullptr;
+    has_hashmap = false;
+}
+
 void 
 BARef::resize (long n) {
+    materialize();
 #ifdef BL_MEM_PROFILING
     updateMemoryUsage_box(-1);
     updateMemoryUsage_hash(-1);
 #endif
     m_abox.resize(n);
-    hash.clear();
-    has_hashmap = false;
+    clearHash();
 #ifdef BL_MEM_PROFILING
     updateMemoryUsage_box(1);
 #endif
@@ -208,12 +441,8 @@ BARef::updateMemoryUsage_box (int s)
 void
 BARef::updateMemoryUsage_hash (int s)
 {
-    if (hash.size() > 0) {
-	long b = sizeof(hash);
-	for (const auto& x: hash) {
-	    b += amrex::gcc_map_node_extra_bytes
-		+ sizeof(IntVect) + amrex::bytesOf(x.second);
-	}
+    if (bin_key.size() > 0) {
+	long b = amrex::bytesOf(bin_key) + amrex::bytesOf(bin_start) + amrex::bytesOf(bin_box);
 	if (s > 0) {
 	    total_hash_bytes += b;
 	    total_hash_bytes_hwm = std::max(total_hash_bytes_hwm, total_hash_bytes);
@@ -260,6 +489,8 @@ BoxArray::Initialize ()
     if (!initialized) {
 	initialized = true;
 	BARef::Initialize();
+        ParmParse pp("boxarray");
+        pp.query("implicit_min_boxes", implicit_min_boxes);
     }
 
     amrex::ExecOnFinalize(BoxArray::Finalize);
@@ -269,6 +500,7 @@ void
 BoxArray::Finalize ()
 {
     initialized = false;
+    implicit_min_boxes = 0;
 }
 
 BoxArray::BoxArray ()
@@ -494,13 +726,13 @@ BoxArray::operator== (const BoxArray& rhs) const
 {
     if (m_simple && rhs.m_simple) {
         return m_typ == rhs.m_typ && m_crse_ratio == rhs.m_crse_ratio &&
-            (m_ref == rhs.m_ref || m_ref->m_abox == rhs.m_ref->m_abox);
+            (m_ref == rhs.m_ref || m_ref->sameBoxes(*rhs.m_ref));
     } else {
         return m_simple == rhs.m_simple
             && m_typ == rhs.m_typ
             && m_crse_ratio == rhs.m_crse_ratio
             && m_transformer->equal(*rhs.m_transformer)
-            && (m_ref == rhs.m_ref || m_ref->m_abox == rhs.m_ref->m_abox);
+            && (m_ref == rhs.m_ref || m_ref->sameBoxes(*rhs.m_ref));
     }
 }
 
@@ -514,7 +746,7 @@ bool
 BoxArray::CellEqual (const BoxArray& rhs) const
 {
     return m_crse_ratio == rhs.m_crse_ratio
-        && (m_ref == rhs.m_ref || m_ref->m_abox == rhs.m_ref->m_abox);
+        && (m_ref == rhs.m_ref || m_ref->sameBoxes(*rhs.m_ref));
 }
 
 BoxArray&
@@ -529,6 +761,15 @@ BoxArray::maxSize (const IntVect& block_size)
     if (!m_simple || m_crse_ratio != IntVect::TheUnitVector()) {
         uniqify();
     }
+    if (implicit_min_boxes > 0 && m_simple && size() == 1 && !m_ref->m_implicit)
+    {
+        auto p = std::make_shared<BARef>();
+        p->defineImplicit(m_ref->m_abox[0], block_size);
+        if (p->size() >= implicit_min_boxes) {
+            m_ref = p;
+            return *this;
+        }
+    }
     BoxList blst(*this);
     blst.maxSize(block_size);
     const int N = blst.size();
@@ -796,6 +1037,7 @@ BoxArray::set (int        i,
                const Box& ibox)
 {
     BL_ASSERT(m_simple && m_crse_ratio == IntVect::TheUnitVector());
+    m_ref->materialize();
     if (i == 0) {
         m_typ = ibox.ixType();
         m_transformer->setIxType(m_typ);
@@ -930,8 +1172,18 @@ BoxArray::minimalBox () const
     BL_ASSERT(m_simple);
     Box minbox;
     const int N = size();
-    if (N > 0)
+    if (m_ref->m_implicit)
+    {
+        IntVect lo, hi;
+        for (int i = 0; i < AMREX_SPACEDIM; ++i) {
+            lo[i] = m_ref->m_cuts[i].front();
+            hi[i] = m_ref->m_cuts[i].back()-1;
+        }
+        minbox = Box(lo,hi);
+    }
+    else if (N > 0)
     {
+        const Box* abox = m_ref->boxData();
 #ifdef _OPENMP
 	bool use_single_thread = omp_in_parallel();
 	const int nthreads = use_single_thread ? 1 : omp_get_max_threads();
@@ -941,14 +1193,14 @@ BoxArray::minimalBox () const
 #endif
 	if (use_single_thread)
 	{
-	    minbox = m_ref->m_abox[0];
+	    minbox = abox[0];
 	    for (int i = 1; i < N; ++i) {
-		minbox.minBox(m_ref->m_abox[i]);
+		minbox.minBox(abox[i]);
 	    }
 	}
 	else
 	{
-	    Vector<Box> bxs(nthreads, m_ref->m_abox[0]);
+	    Vector<Box> bxs(nthreads, abox[0]);
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
@@ -960,7 +1212,7 @@ BoxArray::minimalBox () const
 #pragma omp for
 #endif
 		for (int i = 0; i < N; ++i) {
-		    bxs[tid].minBox(m_ref->m_abox[i]);
+		    bxs[tid].minBox(abox[i]);
 		}
 	    }
 	    minbox = bxs[0];
@@ -980,8 +1232,19 @@ BoxArray::minimalBox (long& npts_avg_box) const
     Box minbox;
     const int N = size();
     long npts_tot = 0;
-    if (N > 0)
+    if (m_ref->m_implicit)
     {
+        IntVect lo, hi;
+        for (int i = 0; i < AMREX_SPACEDIM; ++i) {
+            lo[i] = m_ref->m_cuts[i].front();
+            hi[i] = m_ref->m_cuts[i].back()-1;
+        }
+        minbox = Box(lo,hi);
+        npts_tot = minbox.numPts();
+    }
+    else if (N > 0)
+    {
+        const Box* abox = m_ref->boxData();
 #ifdef _OPENMP
 	bool use_single_thread = omp_in_parallel();
 	const int nthreads = use_single_thread ? 1 : omp_get_max_threads();
@@ -991,16 +1254,16 @@ BoxArray::minimalBox (long& npts_avg_box) const
 #endif
 	if (use_single_thread)
 	{
-	    minbox = m_ref->m_abox[0];
-            npts_tot += m_ref->m_abox[0].numPts();
+	    minbox = abox[0];
+            npts_tot += abox[0].numPts();
 	    for (int i = 1; i < N; ++i) {
-		minbox.minBox(m_ref->m_abox[i]);
-                npts_tot += m_ref->m_abox[i].numPts();
+		minbox.minBox(abox[i]);
+                npts_tot += abox[i].numPts();
 	    }
 	}
 	else
 	{
-	    Vector<Box> bxs(nthreads, m_ref->m_abox[0]);
+	    Vector<Box> bxs(nthreads, abox[0]);
 #ifdef _OPENMP
 #pragma omp parallel reduction(+:npts_tot)
 #endif
@@ -1012,8 +1275,8 @@ BoxArray::minimalBox (long& npts_avg_box) const
 #pragma omp for
 #endif
 		for (int i = 0; i < N; ++i) {
-		    bxs[tid].minBox(m_ref->m_abox[i]);
-                    long npts = m_ref->m_abox[i].numPts();
+		    bxs[tid].minBox(abox[i]);
+                    long npts = abox[i].numPts();
                     npts_tot += npts;
 		}
 	    }
@@ -1094,11 +1357,16 @@ BoxArray::intersections (const Box&                         bx,
 {
   // This is called too many times BL_PROFILE("BoxArray::intersections()");
 
-    BARef::HashType& BoxHashMap = getHashMap();
+    if (m_ref->m_implicit) {
+        implicitIntersections(bx, isects, first_only, ng);
+        return;
+    }
+
+    buildHashBin();
 
     isects.resize(0);
 
-    if (!BoxHashMap.empty())
+    if (m_ref->nbins > 0)
     {
         BL_ASSERT(bx.ixType() == ixType());
 
@@ -1120,19 +1388,28 @@ BoxArray::intersections (const Box&                         bx,
 
 	if (!cbx.intersects(m_ref->bbox)) return;
 
-	auto TheEnd = BoxHashMap.cend();
-
         bool super_simple = m_simple && m_crse_ratio==1 && m_typ.cellCentered();
-        auto& abox = m_ref->m_abox;
-
-        for (IntVect iv = cbx.smallEnd(), End = cbx.bigEnd(); iv <= End; cbx.next(iv))
+        const Box* abox = m_ref->boxData();
+        const long* bin_key = m_ref->pbin_key;
+        const long* bin_key_end = bin_key + m_ref->nbins;
+        const int* bin_start = m_ref->pbin_start;
+        const int* bin_box = m_ref->pbin_box;
+
+        // The bins of a row of cbx are contiguous in bin_key.
+        Box rowbx = cbx;
+        rowbx.setBig(0, cbx.smallEnd(0));
+        for (IntVect iv = rowbx.smallEnd(), End = rowbx.bigEnd(); iv <= End; rowbx.next(iv))
         {
-            auto it = BoxHashMap.find(iv);
-
-            if (it != TheEnd)
+            IntVect ivhi = iv;
+            ivhi[0] = cbx.bigEnd(0);
+            const long keyhi = m_ref->binKey(ivhi);
+            for (auto it = std::lower_bound(bin_key, bin_key_end, m_ref->binKey(iv));
+                 it != bin_key_end && *it <= keyhi; ++it)
             {
-                for (const int index : it->second)
+                const int ibin = it - bin_key;
+                for (int ib = bin_start[ibin]; ib < bin_start[ibin+1]; ++ib)
                 {
+                    const int index = bin_box[ib];
                     const Box& ibox = super_simple ? abox[index] : (*this)[index];
                     const Box& isect = bx & amrex::grow(ibox,ng);
 
@@ -1147,6 +1424,64 @@ BoxArray::intersections (const Box&                         bx,
     }
 }
 
+void
+BoxArray::refRange (const Box& gbx, IntVect& lo, IntVect& hi) const
+{
+    // The index space of m_ref is cell-centered and refined by m_crse_ratio.
+    lo = gbx.smallEnd() - getDoiHi();
+    hi = gbx.bigEnd()   + getDoiLo();
+    lo = lo * m_crse_ratio;
+    hi = (hi + 1) * m_crse_ratio - 1;
+}
+
+void
+BoxArray::implicitIntersections (const Box&                         bx,
+                                 std::vector< std::pair<int,Box> >& isects,
+                                 bool                               first_only,
+                                 const IntVect&                     ng) const
+{
+    BL_ASSERT(bx.ixType() == ixType());
+
+    isects.resize(0);
+
+    IntVect lo, hi;
+    refRange(amrex::grow(bx,ng), lo, hi);
+
+    // Range of pieces in each direction
+    IntVect plo, phi;
+    for (int d = 0; d < AMREX_SPACEDIM; ++d)
+    {
+        const Vector<int>& cuts = m_ref->m_cuts[d];
+        if (hi[d] < cuts.front() || lo[d] >= cuts.back()) return;
+        plo[d] = std::upper_bound(cuts.begin(), cuts.end(), lo[d]) - cuts.begin() - 1;
+        phi[d] = std::upper_bound(cuts.begin(), cuts.end(), hi[d]) - cuts.begin() - 1;
+        plo[d] = std::max(plo[d], 0);
+        phi[d] = std::min(phi[d], static_cast<int>(cuts.size())-2);
+    }
+
+    const Box pbx(plo,phi);
+    for (IntVect p = pbx.smallEnd(), End = pbx.bigEnd(); p <= End; pbx.next(p))
+    {
+        // Inverse of BARef::implicitBox
+        long index = 0;
+        long M = 1;
+        for (int d = 0; d < AMREX_SPACEDIM; ++d)
+        {
+            const int n = m_ref->m_cuts[d].size()-1;
+            if (p[d] > 0) {
+                index = M + index*(n-1) + (n-1-p[d]);
+            }
+            M *= n;
+        }
+        const Box& isect = bx & amrex::grow((*this)[index],ng);
+        if (isect.ok())
+        {
+            isects.push_back(std::pair<int,Box>(index,isect));
+            if (first_only) return;
+        }
+    }
+}
+
 BoxList
 BoxArray::complementIn (const Box& bx) const
 {
@@ -1162,9 +1497,26 @@ BoxArray::complementIn (BoxList& bl, const Box& bx) const
     bl.set(bx.ixType());
     bl.push_back(bx);
 
-    if (!empty()) 
+    if (m_ref->m_implicit)
+    {
+        std::vector< std::pair<int,Box> > isects;
+        intersections(bx, isects);
+        BoxList newbl(bl.ixType());
+        BoxList newdiff(bl.ixType());
+        for (const auto& is : isects)
+        {
+            newbl.clear();
+            for (const Box& b : bl) {
+                amrex::boxDiff(newdiff, b, is.second);
+                newbl.join(newdiff);
+            }
+            bl.swap(newbl);
+            if (bl.isEmpty()) break;
+        }
+    }
+    else if (!empty())
     {
-	BARef::HashType& BoxHashMap = getHashMap();
+	buildHashBin();
 
 	BL_ASSERT(bx.ixType() == ixType());
 
@@ -1186,25 +1538,29 @@ BoxArray::complementIn (BoxList& bl, const Box& bx) const
 
 	if (!cbx.intersects(m_ref->bbox)) return;
 
-	auto TheEnd = BoxHashMap.cend();
-
         BoxList newbl(bl.ixType());
         newbl.reserve(bl.capacity());
         BoxList newdiff(bl.ixType());
 
         bool super_simple = m_simple && m_crse_ratio==1 && m_typ.cellCentered();
-        auto& abox = m_ref->m_abox;
+        const Box* abox = m_ref->boxData();
+        const long* bin_key = m_ref->pbin_key;
+        const long* bin_key_end = bin_key + m_ref->nbins;
+        const int* bin_start = m_ref->pbin_start;
+        const int* bin_box = m_ref->pbin_box;
 
 	for (IntVect iv = cbx.smallEnd(), End = cbx.bigEnd(); 
 	     iv <= End && bl.isNotEmpty(); 
 	     cbx.next(iv))
         {
-            auto it = BoxHashMap.find(iv);
+            auto it = std::lower_bound(bin_key, bin_key_end, m_ref->binKey(iv));
 
-            if (it != TheEnd)
+            if (it != bin_key_end && *it == m_ref->binKey(iv))
             {
-                for (const int index : it->second)
+                const int ibin = it - bin_key;
+                for (int ib = bin_start[ibin]; ib < bin_start[ibin+1]; ++ib)
                 {
+                    const int index = bin_box[ib];
                     const Box& isect = (super_simple)
                         ? (bx & abox[index])
                         : (bx & (*this)[index]);
@@ -1227,13 +1583,12 @@ BoxArray::complementIn (BoxList& bl, const Box& bx) const
 void
 BoxArray::clear_hash_bin () const
 {
-    if (!m_ref->hash.empty())
+    if (m_ref->nbins > 0)
     {
 #ifdef BL_MEM_PROFILING
 	m_ref->updateMemoryUsage_hash(-1);
 #endif
-        m_ref->hash.clear();
-        m_ref->has_hashmap = false;
+        m_ref->clearHash();
     }
 }
 
@@ -1253,7 +1608,24 @@ BoxArray::removeOverlap (bool simplify)
 
     uniqify();
 
-    BARef::HashType& BoxHashMap = m_ref->hash;
+    if (empty()) return;
+
+    //
+    // Boxes are added below, so use a hash that can grow instead of the
+    // bins of m_ref.  The added boxes are parts of existing ones, so the
+    // bin size does not change.
+    //
+    auto& abox = m_ref->m_abox;
+
+    IntVect crsn = IntVect::TheUnitVector();
+    for (const auto& b : abox) {
+        crsn = amrex::max(crsn, b.size());
+    }
+
+    std::unordered_map< IntVect, std::vector<int>, IntVect::shift_hasher > BoxHashMap;
+    for (int i = 0, N = abox.size(); i < N; ++i) {
+        BoxHashMap[amrex::coarsen(abox[i].smallEnd(),crsn)].push_back(i);
+    }
 
     const Box EmptyBox;
 
@@ -1263,23 +1635,36 @@ BoxArray::removeOverlap (bool simplify)
     //
 #ifdef BL_MEM_PROFILING
     m_ref->updateMemoryUsage_box(-1);
-    m_ref->updateMemoryUsage_hash(-1);
-    long total_hash_bytes_save = m_ref->total_hash_bytes;
 #endif
 
     BoxList bl_diff;
 
     for (int i = 0; i < size(); i++)
     {
-        if (m_ref->m_abox[i].ok())
+        if (abox[i].ok())
         {
-            intersections(m_ref->m_abox[i],isects);
+            const Box ibox = abox[i];
+            isects.clear();
+            const Box cbx(amrex::coarsen(ibox.smallEnd(),crsn)-1,
+                          amrex::coarsen(ibox.bigEnd(),crsn));
+            for (IntVect iv = cbx.smallEnd(), End = cbx.bigEnd(); iv <= End; cbx.next(iv))
+            {
+                auto it = BoxHashMap.find(iv);
+                if (it != BoxHashMap.end()) {
+                    for (const int index : it->second) {
+                        const Box& isect = ibox & abox[index];
+                        if (isect.ok()) {
+                            isects.push_back(std::pair<int,Box>(index,isect));
+                        }
+                    }
+                }
+            }
 
             for (int j = 0, N = isects.size(); j < N; j++)
             {
                 if (isects[j].first == i) continue;
 
-                Box& bx = m_ref->m_abox[isects[j].first];
+                Box& bx = abox[isects[j].first];
 
                 amrex::boxDiff(bl_diff, bx, isects[j].second);
 
@@ -1287,8 +1672,8 @@ BoxArray::removeOverlap (bool simplify)
 
                 for (const Box& b : bl_diff)
                 {
-                    m_ref->m_abox.push_back(b);
-                    BoxHashMap[amrex::coarsen(b.smallEnd(),m_ref->crsn)].push_back(size()-1);
+                    abox.push_back(b);
+                    BoxHashMap[amrex::coarsen(b.smallEnd(),crsn)].push_back(size()-1);
                 }
             }
         }
@@ -1314,10 +1699,6 @@ BoxArray::removeOverlap (bool simplify)
 
     *this = nba;
 
-#ifdef BL_MEM_PROFILING
-    m_ref->total_hash_bytes = total_hash_bytes_save;
-#endif
-
     BL_ASSERT(isDisjoint());
 }
 
@@ -1349,44 +1730,70 @@ BoxArray::getDoiHi () const
     return m_simple ?           m_typ.ixType() : m_transformer->doiHi();
 }
 
-BARef::HashType&
-BoxArray::getHashMap () const
+void
+BoxArray::buildHashBin () const
 {
-    BARef::HashType& BoxHashMap = m_ref->hash;
-
-    if (m_ref->HasHashMap()) return BoxHashMap;
+    if (m_ref->HasHashMap()) return;
 
 #ifdef _OPENMP
     #pragma omp critical(intersections_lock)
 #endif
     {
-        if (BoxHashMap.empty() && size() > 0)
+        if (!m_ref->has_hashmap && size() > 0)
         {
             //
             // Calculate the bounding box & maximum extent of the boxes.
             //
 	    IntVect maxext = IntVect::TheUnitVector();
-            Box boundingbox = m_ref->m_abox[0];
+            const Box* abox = m_ref->boxData();
+            Box boundingbox = abox[0];
 
 	    const int N = size();
 	    for (int i = 0; i < N; ++i)
             {
-                const Box& bx = m_ref->m_abox[i];
+                const Box& bx = abox[i];
                 maxext = amrex::max(maxext, bx.size());
                 boundingbox.minBox(bx);
             }
 
+            m_ref->crsn = maxext;
+            m_ref->bbox =boundingbox.coarsen(maxext);
+            m_ref->bbox.normalize();
+
+            // Sort the boxes by bin, keeping the order of the boxes in each bin.
+            std::vector< std::pair<long,int> > keys(N);
             for (int i = 0; i < N; i++)
             {
                 const IntVect& crsnsmlend 
-		    = amrex::coarsen(m_ref->m_abox[i].smallEnd(),maxext);
-                BoxHashMap[crsnsmlend].push_back(i);
+		    = amrex::coarsen(abox[i].smallEnd(),maxext);
+                keys[i] = std::make_pair(m_ref->binKey(crsnsmlend), i);
+            }
+            std::sort(keys.begin(), keys.end());
+
+            auto& bin_key = m_ref->bin_key;
+            auto& bin_start = m_ref->bin_start;
+            auto& bin_box = m_ref->bin_box;
+            bin_key.clear();
+            bin_start.clear();
+            bin_box.resize(N);
+            for (int i = 0; i < N; i++)
+            {
+                if (i == 0 || keys[i].first != keys[i-1].first) {
+                    bin_key.push_back(keys[i].first);
+                    bin_start.push_back(i);
+                }
+                bin_box[i] = keys[i].second;
             }
+            bin_start.push_back(N);
 
-            m_ref->crsn = maxext;
-            m_ref->bbox =boundingbox.coarsen(maxext);
-            m_ref->bbox.normalize();
+            m_ref->nbins = bin_key.size();
+            m_ref->pbin_key = bin_key.data();
+            m_ref->pbin_start = bin_start.data();
+            m_ref->pbin_box = bin_box.data();
 
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
 	    m_ref->has_hashmap = true;
 
 #ifdef BL_MEM_PROFILING
@@ -1394,8 +1801,22 @@ BoxArray::getHashMap () const
 #endif
         }
     }
+}
+
+void
+BoxArray::shareOnNode ()
+{
+    if (m_ref->m_implicit || m_ref->m_shared_box || size() < 2
+        || ParallelDescriptor::NProcsPerNode() == 1) {
+        return;
+    }
 
-    return BoxHashMap;
+    BL_PROFILE("BoxArray::shareOnNode()");
+
+    if (ParallelDescriptor::MyRankInNode() == 0) {
+        buildHashBin();
+    }
+    m_ref->shareOnNode();
 }
 
 void
@@ -1407,6 +1828,7 @@ BoxArray::uniqify ()
 	auto p = std::make_shared<BARef>(*m_ref);
 	std::swap(m_ref,p);
     }
+    m_ref->materialize();
     if (m_crse_ratio != 1) {
         const int N = m_ref->m_abox.size();
 #ifdef _OPENMP
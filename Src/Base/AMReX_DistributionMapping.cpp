@@ -43,9 +43,51 @@ DistributionMapping::PVMF DistributionMapping::m_BuildMap = 0;
 const Vector<int>&
 DistributionMapping::ProcessorMap () const
 {
+    if (m_ref->m_shared_pmap)
+    {
+#ifdef _OPENMP
+#pragma omp critical(dm_processormap_lock)
+#endif
+        if (m_ref->m_pmap.empty()) {
+            m_ref->m_pmap.assign(m_ref->m_shared_pmap, m_ref->m_shared_pmap+m_ref->m_nshared);
+        }
+    }
     return m_ref->m_pmap;
 }
 
+void
+DistributionMapping::Ref::releaseShared ()
+{
+    if (m_shared_pmap) {
+        ParallelDescriptor::FreeNodeShared(m_shared_handle);
+        m_shared_pmap = nullptr;
+        m_nshared = 0;
+        m_shared_handle = -1;
+    }
+}
+
+void
+DistributionMapping::shareOnNode ()
+{
+    if (m_ref->m_shared_pmap || empty() || ParallelDescriptor::NProcsPerNode() == 1) {
+        return;
+    }
+
+    BL_PROFILE("DistributionMapping::shareOnNode()");
+
+    const long N = size();
+    int handle;
+    void* p = ParallelDescriptor::AllocNodeShared(N*sizeof(int), handle, [&] (void* q)
+    {
+        std::memcpy(q, m_ref->m_pmap.data(), N*sizeof(int));
+    });
+
+    Vector<int>().swap(m_ref->m_pmap);
+    m_ref->m_shared_pmap = static_cast<const int*>(p);
+    m_ref->m_nshared = N;
+    m_ref->m_shared_handle = handle;
+}
+
 DistributionMapping::Strategy
 DistributionMapping::strategy ()
 {
@@ -91,7 +133,8 @@ DistributionMapping::SFC_Threshold ()
 bool
 DistributionMapping::operator== (const DistributionMapping& rhs) const
 {
-    return m_ref == rhs.m_ref || m_ref->m_pmap == rhs.m_ref->m_pmap;
+    return m_ref == rhs.m_ref
+        || (size() == rhs.size() && std::equal(m_ref->pmap(), m_ref->pmap()+size(), rhs.m_ref->pmap()));
 }
 
 bool
@@ -359,9 +402,15 @@ DistributionMapping::DistributionMapping (const DistributionMapping& d1,
     :
     m_ref(std::make_shared<Ref>())
 {
-    m_ref->m_pmap = d1.ProcessorMap();
-    const auto& p2 = d2.ProcessorMap();
-    m_ref->m_pmap.insert(m_ref->m_pmap.end(), p2.begin(), p2.end());
+    const long n1 = d1.size();
+    const long n2 = d2.size();
+    m_ref->m_pmap.resize(n1+n2);
+    for (long i = 0; i < n1; ++i) {
+        m_ref->m_pmap[i] = d1[i];
+    }
+    for (long i = 0; i < n2; ++i) {
+        m_ref->m_pmap[n1+i] = d2[i];
+    }
 }
 
 void
@@ -1266,7 +1315,7 @@ DistributionMapping::RRSFCProcessorMap (const BoxArray&          boxes,
 }
 
 DistributionMapping
-DistributionMapping::makeKnapSack (const Vector<Real>& rcost)
+DistributionMapping::makeKnapSack (const Vector<Real>& rcost, int nmax)
 {
     BL_PROFILE("makeKnapSack");
 
@@ -1284,7 +1333,7 @@ DistributionMapping::makeKnapSack (const Vector<Real>& rcost)
     int nprocs = ParallelContext::NProcsSub();
     Real eff;
 
-    r.KnapSackProcessorMap(cost, nprocs, &eff, true);
+    r.KnapSackProcessorMap(cost, nprocs, &eff, true, nmax);
 
     return r;
 }
@@ -1397,6 +1446,45 @@ DistributionMapping::makeSFC (const MultiFab& weight, bool sort)
     return r;
 }
 
+DistributionMapping
+DistributionMapping::makeSFC (const Vector<Real>& rcost, const BoxArray& ba, bool sort)
+{
+    BL_PROFILE("makeSFC");
+
+    DistributionMapping r;
+
+    Vector<long> cost(rcost.size());
+
+    Real wmax = *std::max_element(rcost.begin(), rcost.end());
+    Real scale = (wmax == 0) ? 1.e9 : 1.e9/wmax;
+
+    for (int i = 0; i < rcost.size(); ++i) {
+        cost[i] = long(rcost[i]*scale) + 1L;
+    }
+
+    int nprocs = ParallelContext::NProcsSub();
+
+    r.SFCProcessorMap(ba, cost, nprocs, sort);
+
+    return r;
+}
+
+Real
+DistributionMapping::efficiency (const DistributionMapping& dm, const Vector<Real>& rcost)
+{
+    BL_ASSERT(dm.size() == rcost.size());
+
+    Vector<Real> load(ParallelContext::NProcsSub(), 0.0);
+    for (int i = 0; i < rcost.size(); ++i) {
+        load[ParallelContext::global_to_local_rank(dm[i])] += rcost[i];
+    }
+
+    Real lmax = *std::max_element(load.begin(), load.end());
+    Real lavg = std::accumulate(load.begin(), load.end(), 0.0) / load.size();
+
+    return (lmax > 0.0) ? lavg/lmax : 1.0;
+}
+
 std::vector<std::vector<int> >
 DistributionMapping::makeSFC (const BoxArray& ba)
 {
@@ -1448,8 +1536,8 @@ DistributionMapping::getIndexArray ()
     {
         int myProc = ParallelDescriptor::MyProc();
 
-        for(int i = 0, N = m_ref->m_pmap.size(); i < N; ++i) {
-            int rank = m_ref->m_pmap[i];
+        for(int i = 0, N = size(); i < N; ++i) {
+            int rank = (*this)[i];
             if (ParallelDescriptor::sameTeam(rank)) {
                 // If Team is not used (i.e., team size == 1), distributionMap[i] == myProc
                 m_ref->m_index_array.push_back(i);
@@ -1467,8 +1555,8 @@ DistributionMapping::getOwnerShip ()
     {
         int myProc = ParallelDescriptor::MyProc();
 
-        for(int i = 0, N = m_ref->m_pmap.size(); i < N; ++i) {
-            int rank = m_ref->m_pmap[i];
+        for(int i = 0, N = size(); i < N; ++i) {
+            int rank = (*this)[i];
             if (ParallelDescriptor::sameTeam(rank)) {
                 // If Team is not used (i.e., team size == 1), distributionMap[i] == myProc
                 m_ref->m_index_array.push_back(i);
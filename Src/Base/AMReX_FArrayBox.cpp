@@ -19,6 +19,7 @@
 #include <AMReX.H>
 #include <AMReX_Utility.H>
 #include <AMReX_MemPool.H>
+#include <AMReX_BoxIterator.H>
 
 namespace amrex {
 
@@ -219,6 +220,26 @@ FArrayBox::initVal ()
     }
 }
 
+void
+FArrayBox::initVal (const Box& bx)
+{
+    BL_ASSERT(box().contains(bx));
+    if (init_snan) {
+#if defined(BL_USE_DOUBLE) && !defined(AMREX_USE_GPU)
+        // one row in the first direction at a time
+        Box rows(bx);
+        rows.setBig(0, bx.smallEnd(0));
+        for (int n = 0; n < nComp(); ++n) {
+            for (BoxIterator bi(rows); bi.ok(); ++bi) {
+                amrex_array_init_snan(&(*this)(bi(),n), bx.length(0));
+            }
+        }
+#endif
+    } else if (do_initval) {
+        setVal(initval, bx, 0, nComp());
+    }
+}
+
 void
 FArrayBox::resize (const Box& b,
                    int        N)
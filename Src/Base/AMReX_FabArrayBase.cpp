@@ -24,6 +24,8 @@ namespace amrex {
 bool    FabArrayBase::do_async_sends;
 int     FabArrayBase::MaxComp;
 int     FabArrayBase::use_cuda_aware_mpi;
+long    FabArrayBase::comm_cache_max_bytes;
+bool    FabArrayBase::first_touch;
 
 #if defined(AMREX_USE_GPU) && defined(AMREX_USE_GPU_PRAGMA)
 
@@ -69,6 +71,9 @@ FabArrayBase::CacheStats           FabArrayBase::m_CFinfo_stats("CrseFineCache")
 
 std::map<FabArrayBase::BDKey, int> FabArrayBase::m_BD_count;
 
+FabArrayBase::CommCacheEntry*      FabArrayBase::m_lru_first = nullptr;
+FabArrayBase::CommCacheEntry*      FabArrayBase::m_lru_last  = nullptr;
+
 FabArrayBase::FabArrayStats        FabArrayBase::m_FA_stats;
 
 namespace
@@ -88,6 +93,8 @@ FabArrayBase::Initialize ()
     //
     FabArrayBase::do_async_sends    = true;
     FabArrayBase::MaxComp           = 25;
+    FabArrayBase::comm_cache_max_bytes = 0;
+    FabArrayBase::first_touch       = false;
 
     ParmParse pp("fabarray");
 
@@ -110,10 +117,17 @@ FabArrayBase::Initialize ()
 
     pp.query("maxcomp",             FabArrayBase::MaxComp);
     pp.query("do_async_sends",      FabArrayBase::do_async_sends);
+    pp.query("first_touch",         FabArrayBase::first_touch);
 
     if (MaxComp < 1)
         MaxComp = 1;
 
+    {
+        double max_mb = 0.0;
+        pp.query("comm_cache_max_mb", max_mb);
+        FabArrayBase::comm_cache_max_bytes = std::max(0L, static_cast<long>(max_mb*1024.*1024.));
+    }
+
 #ifdef AMREX_USE_CUDA
     FabArrayBase::use_cuda_aware_mpi = 1;
     pp.query("use_cuda_aware_mpi", FabArrayBase::use_cuda_aware_mpi);
@@ -188,7 +202,7 @@ FabArrayBase::define (const BoxArray&            bxs,
     
     boxarray = bxs;
     
-    BL_ASSERT(dm.ProcessorMap().size() == bxs.size());
+    BL_ASSERT(dm.size() == bxs.size());
     distributionMap = dm;
 
     indexArray = distributionMap.getIndexArray();
@@ -274,7 +288,8 @@ FabArrayBase::TileArray::bytes () const
 FabArrayBase::CPC::CPC (const FabArrayBase& dstfa, const IntVect& dstng,
 			const FabArrayBase& srcfa, const IntVect& srcng,
 			const Periodicity& period)
-    : m_srcbdk(srcfa.getBDKey()), 
+    : CommCacheEntry(CPC_entry),
+      m_srcbdk(srcfa.getBDKey()), 
       m_dstbdk(dstfa.getBDKey()), 
       m_srcng(srcng), 
       m_dstng(dstng), 
@@ -293,7 +308,8 @@ FabArrayBase::CPC::CPC (const BoxArray& dstba, const DistributionMapping& dstdm,
 			const BoxArray& srcba, const DistributionMapping& srcdm, 
 			const Vector<int>& srcidx, const IntVect& srcng,
 			const Periodicity& period, int myproc)
-    : m_srcbdk(), 
+    : CommCacheEntry(CPC_entry),
+      m_srcbdk(), 
       m_dstbdk(), 
       m_srcng(srcng), 
       m_dstng(dstng), 
@@ -455,7 +471,8 @@ FabArrayBase::CPC::define (const BoxArray& ba_dst, const DistributionMapping& dm
 
 FabArrayBase::CPC::CPC (const BoxArray& ba, const IntVect& ng,
                         const DistributionMapping& dstdm, const DistributionMapping& srcdm)
-    : m_srcbdk(), 
+    : CommCacheEntry(CPC_entry),
+      m_srcbdk(), 
       m_dstbdk(), 
       m_srcng(ng), 
       m_dstng(ng), 
@@ -525,9 +542,7 @@ FabArrayBase::flushCPC (bool no_assertion) const
 	    }
 	}
 
-#ifdef BL_MEM_PROFILING
 	m_CPC_stats.bytes -= it->second->bytes();
-#endif
 	m_CPC_stats.recordErase(it->second->m_nuse);
 	delete it->second;
     }
@@ -552,9 +567,7 @@ FabArrayBase::flushCPCache ()
 	}
     }
     m_TheCPCache.clear();
-#ifdef BL_MEM_PROFILING
     m_CPC_stats.bytes = 0L;
-#endif
 }
 
 const FabArrayBase::CPC&
@@ -582,6 +595,8 @@ FabArrayBase::getCPC (const IntVect& dstng, const FabArrayBase& src, const IntVe
 	    it->second->m_dstba  == boxArray())
 	{
 	    ++(it->second->m_nuse);
+	    lruRemove(it->second);
+	    lruInsert(it->second);
 	    m_CPC_stats.recordUse();
 	    return *(it->second);
 	}
@@ -590,12 +605,10 @@ FabArrayBase::getCPC (const IntVect& dstng, const FabArrayBase& src, const IntVe
     // Have to build a new one
     CPC* new_cpc = new CPC(*this, dstng, src, srcng, period);
 
-#ifdef BL_MEM_PROFILING
-    m_CPC_stats.bytes += new_cpc->bytes();
-    m_CPC_stats.bytes_hwm = std::max(m_CPC_stats.bytes_hwm, m_CPC_stats.bytes);
-#endif    
+    m_CPC_stats.recordBytes(new_cpc->bytes());
 
     new_cpc->m_nuse = 1;
+    lruInsert(new_cpc);
     m_CPC_stats.recordBuild();
     m_CPC_stats.recordUse();
 
@@ -603,6 +616,8 @@ FabArrayBase::getCPC (const IntVect& dstng, const FabArrayBase& src, const IntVe
     if (srckey != dstkey)
 	m_TheCPCache.insert(          CPCache::value_type(srckey,new_cpc));
 
+    trimCommCache(new_cpc);
+
     return *new_cpc;
 }
 
@@ -613,7 +628,8 @@ FabArrayBase::getCPC (const IntVect& dstng, const FabArrayBase& src, const IntVe
 FabArrayBase::FB::FB (const FabArrayBase& fa, const IntVect& nghost,
                       bool cross, const Periodicity& period, 
                       bool enforce_periodicity_only)
-    : m_typ(fa.boxArray().ixType()), m_crse_ratio(fa.boxArray().crseRatio()),
+    : CommCacheEntry(FB_entry),
+      m_typ(fa.boxArray().ixType()), m_crse_ratio(fa.boxArray().crseRatio()),
       m_ngrow(nghost), m_cross(cross),
       m_epo(enforce_periodicity_only), m_period(period),
       m_threadsafe_loc(false), m_threadsafe_rcv(false),
@@ -1003,9 +1019,7 @@ FabArrayBase::flushFB (bool no_assertion) const
     std::pair<FBCacheIter,FBCacheIter> er_it = m_TheFBCache.equal_range(m_bdkey);
     for (FBCacheIter it = er_it.first; it != er_it.second; ++it)
     {
-#ifdef BL_MEM_PROFILING
 	m_FBC_stats.bytes -= it->second->bytes();
-#endif
 	m_FBC_stats.recordErase(it->second->m_nuse);
 	delete it->second;
     }
@@ -1021,9 +1035,7 @@ FabArrayBase::flushFBCache ()
 	delete it->second;
     }
     m_TheFBCache.clear();
-#ifdef BL_MEM_PROFILING
     m_FBC_stats.bytes = 0L;
-#endif
 }
 
 const FabArrayBase::FB&
@@ -1044,6 +1056,8 @@ FabArrayBase::getFB (const IntVect& nghost, const Periodicity& period,
 	    it->second->m_period     == period              )
 	{
 	    ++(it->second->m_nuse);
+	    lruRemove(it->second);
+	    lruInsert(it->second);
 	    m_FBC_stats.recordUse();
 	    return *(it->second);
 	}
@@ -1052,17 +1066,18 @@ FabArrayBase::getFB (const IntVect& nghost, const Periodicity& period,
     // Have to build a new one
     FB* new_fb = new FB(*this, nghost, cross, period, enforce_periodicity_only);
 
-#ifdef BL_PROFILE
-    m_FBC_stats.bytes += new_fb->bytes();
-    m_FBC_stats.bytes_hwm = std::max(m_FBC_stats.bytes_hwm, m_FBC_stats.bytes);
-#endif
+    m_FBC_stats.recordBytes(new_fb->bytes());
 
     new_fb->m_nuse = 1;
+    new_fb->m_key = m_bdkey;
+    lruInsert(new_fb);
     m_FBC_stats.recordBuild();
     m_FBC_stats.recordUse();
 
     m_TheFBCache.insert(er_it.second, FBCache::value_type(m_bdkey,new_fb));
 
+    trimCommCache(new_fb);
+
     return *new_fb;
 }
 
@@ -1072,7 +1087,8 @@ FabArrayBase::FPinfo::FPinfo (const FabArrayBase& srcfa,
 			      const IntVect&      dstng,
 			      const BoxConverter& coarsener,
                               const Box&          cdomain)
-    : m_srcbdk   (srcfa.getBDKey()),
+    : CommCacheEntry(FPinfo_entry),
+      m_srcbdk   (srcfa.getBDKey()),
       m_dstbdk   (dstfa.getBDKey()),
       m_dstdomain(dstdomain),
       m_dstng    (dstng),
@@ -1170,6 +1186,8 @@ FabArrayBase::TheFPinfo (const FabArrayBase& srcfa,
 	    it->second->m_coarsener->doit(it->second->m_dstdomain) == coarsener.doit(dstdomain))
 	{
 	    ++(it->second->m_nuse);
+	    lruRemove(it->second);
+	    lruInsert(it->second);
 	    m_FPinfo_stats.recordUse();
 	    return *(it->second);
 	}
@@ -1178,12 +1196,10 @@ FabArrayBase::TheFPinfo (const FabArrayBase& srcfa,
     // Have to build a new one
     FPinfo* new_fpc = new FPinfo(srcfa, dstfa, dstdomain, dstng, coarsener, cdomain);
 
-#ifdef BL_MEM_PROFILING
-    m_FPinfo_stats.bytes += new_fpc->bytes();
-    m_FPinfo_stats.bytes_hwm = std::max(m_FPinfo_stats.bytes_hwm, m_FPinfo_stats.bytes);
-#endif
+    m_FPinfo_stats.recordBytes(new_fpc->bytes());
     
     new_fpc->m_nuse = 1;
+    lruInsert(new_fpc);
     m_FPinfo_stats.recordBuild();
     m_FPinfo_stats.recordUse();
 
@@ -1191,6 +1207,8 @@ FabArrayBase::TheFPinfo (const FabArrayBase& srcfa,
     if (srckey != dstkey)
 	m_TheFillPatchCache.insert(          FPinfoCache::value_type(srckey,new_fpc));
 
+    trimCommCache(new_fpc);
+
     return *new_fpc;
 }
 
@@ -1222,9 +1240,7 @@ FabArrayBase::flushFPinfo (bool no_assertion)
 	    }
 	} 
 
-#ifdef BL_MEM_PROFILING
 	m_FPinfo_stats.bytes -= it->second->bytes();
-#endif
 	m_FPinfo_stats.recordErase(it->second->m_nuse);
 	delete it->second;
     }
@@ -1243,7 +1259,8 @@ FabArrayBase::CFinfo::CFinfo (const FabArrayBase& finefa,
                               const IntVect&      ng,
                               bool                include_periodic,
                               bool                include_physbndry)
-    : m_fine_bdk (finefa.getBDKey()),
+    : CommCacheEntry(CFinfo_entry),
+      m_fine_bdk (finefa.getBDKey()),
       m_ng       (ng),
       m_include_periodic(include_periodic),
       m_include_physbndry(include_physbndry),
@@ -1335,6 +1352,8 @@ FabArrayBase::TheCFinfo (const FabArrayBase& finefa,
             it->second->m_ng          == ng)
         {
             ++(it->second->m_nuse);
+            lruRemove(it->second);
+            lruInsert(it->second);
             m_CFinfo_stats.recordUse();
             return *(it->second);
         }
@@ -1343,17 +1362,17 @@ FabArrayBase::TheCFinfo (const FabArrayBase& finefa,
     // Have to build a new one
     CFinfo* new_cfinfo = new CFinfo(finefa, finegm, ng, include_periodic, include_physbndry);
 
-#ifdef BL_MEM_PROFILING
-    m_CFinfo_stats.bytes += new_cfinfo->bytes();
-    m_CFinfo_stats.bytes_hwm = std::max(m_CFinfo_stats.bytes_hwm, m_CFinfo_stats.bytes);
-#endif
+    m_CFinfo_stats.recordBytes(new_cfinfo->bytes());
 
     new_cfinfo->m_nuse = 1;
+    lruInsert(new_cfinfo);
     m_CFinfo_stats.recordBuild();
     m_CFinfo_stats.recordUse();
 
     m_TheCrseFineCache.insert(er_it.second, CFinfoCache::value_type(key,new_cfinfo));
 
+    trimCommCache(new_cfinfo);
+
     return *new_cfinfo;
 }
 
@@ -1364,15 +1383,136 @@ FabArrayBase::flushCFinfo (bool no_assertion)
     auto er_it = m_TheCrseFineCache.equal_range(m_bdkey);
     for (auto it = er_it.first; it != er_it.second; ++it)
     {
-#ifdef BL_MEM_PROFILING
         m_CFinfo_stats.bytes -= it->second->bytes();
-#endif
         m_CFinfo_stats.recordErase(it->second->m_nuse);
         delete it->second;
     }
     m_TheCrseFineCache.erase(er_it.first, er_it.second);
 }
 
+long
+FabArrayBase::commCacheBytes ()
+{
+    return m_TAC_stats.bytes + m_FBC_stats.bytes + m_CPC_stats.bytes
+        + m_FPinfo_stats.bytes + m_CFinfo_stats.bytes;
+}
+
+void
+FabArrayBase::lruInsert (CommCacheEntry* e)
+{
+    e->m_lru_prev = m_lru_last;
+    e->m_lru_next = nullptr;
+    if (m_lru_last) {
+        m_lru_last->m_lru_next = e;
+    } else {
+        m_lru_first = e;
+    }
+    m_lru_last = e;
+}
+
+void
+FabArrayBase::lruRemove (CommCacheEntry* e)
+{
+    if (e->m_lru_prev) {
+        e->m_lru_prev->m_lru_next = e->m_lru_next;
+    } else if (m_lru_first == e) {
+        m_lru_first = e->m_lru_next;
+    } else {
+        return; // not in the list
+    }
+    if (e->m_lru_next) {
+        e->m_lru_next->m_lru_prev = e->m_lru_prev;
+    } else {
+        m_lru_last = e->m_lru_prev;
+    }
+    e->m_lru_prev = nullptr;
+    e->m_lru_next = nullptr;
+}
+
+namespace {
+    //
+    // Erase the element of the multimap cache with the key and the value.
+    //
+    template <class Cache, class Entry>
+    void
+    eraseEntry (Cache& cache, const FabArrayBase::BDKey& key, const Entry* entry)
+    {
+        auto er_it = cache.equal_range(key);
+        for (auto it = er_it.first; it != er_it.second; ++it) {
+            if (it->second == entry) {
+                cache.erase(it);
+                return;
+            }
+        }
+    }
+}
+
+void
+FabArrayBase::trimCommCache (const CommCacheEntry* keep)
+{
+    if (comm_cache_max_bytes <= 0) return;
+
+    // The tile arrays cannot be evicted, so they do not count.
+    CommCacheEntry* e = m_lru_first;
+    while (e != nullptr && commCacheBytes() - m_TAC_stats.bytes > comm_cache_max_bytes)
+    {
+        CommCacheEntry* next = e->m_lru_next;
+
+        if (e != keep && e->m_nlock == 0)
+        {
+            switch (e->m_kind)
+            {
+            case CommCacheEntry::FB_entry:
+            {
+                FB* fb = static_cast<FB*>(e);
+                eraseEntry(m_TheFBCache, fb->m_key, fb);
+                m_FBC_stats.bytes -= fb->bytes();
+                m_FBC_stats.recordErase(fb->m_nuse);
+                m_FBC_stats.recordEvict();
+                delete fb;
+                break;
+            }
+            case CommCacheEntry::CPC_entry:
+            {
+                // A CPC is in the cache under both its source and destination keys.
+                CPC* cpc = static_cast<CPC*>(e);
+                eraseEntry(m_TheCPCache, cpc->m_srcbdk, cpc);
+                eraseEntry(m_TheCPCache, cpc->m_dstbdk, cpc);
+                m_CPC_stats.bytes -= cpc->bytes();
+                m_CPC_stats.recordErase(cpc->m_nuse);
+                m_CPC_stats.recordEvict();
+                delete cpc;
+                break;
+            }
+            case CommCacheEntry::FPinfo_entry:
+            {
+                // So is an FPinfo.
+                FPinfo* fpi = static_cast<FPinfo*>(e);
+                eraseEntry(m_TheFillPatchCache, fpi->m_srcbdk, fpi);
+                eraseEntry(m_TheFillPatchCache, fpi->m_dstbdk, fpi);
+                m_FPinfo_stats.bytes -= fpi->bytes();
+                m_FPinfo_stats.recordErase(fpi->m_nuse);
+                m_FPinfo_stats.recordEvict();
+                delete fpi;
+                break;
+            }
+            case CommCacheEntry::CFinfo_entry:
+            {
+                CFinfo* cfi = static_cast<CFinfo*>(e);
+                eraseEntry(m_TheCrseFineCache, cfi->m_fine_bdk, cfi);
+                m_CFinfo_stats.bytes -= cfi->bytes();
+                m_CFinfo_stats.recordErase(cfi->m_nuse);
+                m_CFinfo_stats.recordEvict();
+                delete cfi;
+                break;
+            }
+            }
+        }
+
+        e = next;
+    }
+}
+
 void
 FabArrayBase::Finalize ()
 {
@@ -1424,11 +1564,7 @@ FabArrayBase::getTileArray (const IntVect& tilesize) const
 	    buildTileArray(tilesize, *p);
 	    p->nuse = 0;
 	    m_TAC_stats.recordBuild();
-#ifdef BL_MEM_PROFILING
-	    m_TAC_stats.bytes += p->bytes();
-	    m_TAC_stats.bytes_hwm = std::max(m_TAC_stats.bytes_hwm,
-					     m_TAC_stats.bytes);
-#endif
+	    m_TAC_stats.recordBytes(p->bytes());
 	}
 #ifdef _OPENMP
 #pragma omp master
@@ -1549,9 +1685,7 @@ FabArrayBase::flushTileArray (const IntVect& tileSize, bool no_assertion) const
 	    for (TAMap::const_iterator tai_it = tao_it->second.begin();
 		 tai_it != tao_it->second.end(); ++tai_it)
 	    {
-#ifdef BL_MEM_PROFILING
 		m_TAC_stats.bytes -= tai_it->second.bytes();
-#endif		
 		m_TAC_stats.recordErase(tai_it->second.nuse);
 	    }
 	    tao.erase(tao_it);
@@ -1562,9 +1696,7 @@ FabArrayBase::flushTileArray (const IntVect& tileSize, bool no_assertion) const
             const IntVect& crse_ratio = boxArray().crseRatio();
 	    TAMap::iterator tai_it = tai.find(std::pair<IntVect,IntVect>(tileSize,crse_ratio));
 	    if (tai_it != tai.end()) {
-#ifdef BL_MEM_PROFILING
 		m_TAC_stats.bytes -= tai_it->second.bytes();
-#endif		
 		m_TAC_stats.recordErase(tai_it->second.nuse);
 		tai.erase(tai_it);
 	    }
@@ -1585,9 +1717,7 @@ FabArrayBase::flushTileArrayCache ()
 	}
     }
     m_TheTileArrayCache.clear();
-#ifdef BL_MEM_PROFILING
     m_TAC_stats.bytes = 0L;
-#endif
 }
 
 void
@@ -3,6 +3,12 @@
 #include <cstdlib>
 #include <limits>
 #include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include <AMReX.H>
 #include <AMReX_FabConv.H>
@@ -17,6 +23,10 @@ bool RealDescriptor::bAlwaysFixDenormals (false);
 int  RealDescriptor::writeBufferSize(262144);  // ---- these are number of reals,
 int  RealDescriptor::readBufferSize(262144);   // ---- not bytes
 
+namespace {
+    long convertThreadMin(65536);  // ---- number of reals
+}
+
 IntDescriptor::IntDescriptor () {}
 
 IntDescriptor::IntDescriptor (long     nb,
@@ -165,6 +175,13 @@ RealDescriptor::SetWriteBufferSize(int wbs)
     writeBufferSize = wbs;
 }
 
+void
+RealDescriptor::SetConvertThreadMin(long ctm)
+{
+    BL_ASSERT(ctm > 0);
+    convertThreadMin = ctm;
+}
+
 RealDescriptor*
 RealDescriptor::clone () const
 {
@@ -904,6 +921,162 @@ operator>> (std::istream&   is,
     return is;
 }
 
+namespace {
+
+inline std::uint32_t
+byte_swap (std::uint32_t x)
+{
+    return ((x & 0x000000FFu) << 24) | ((x & 0x0000FF00u) <<  8)
+         | ((x & 0x00FF0000u) >>  8) | ((x & 0xFF000000u) >> 24);
+}
+
+inline std::uint64_t
+byte_swap (std::uint64_t x)
+{
+    return (std::uint64_t(byte_swap(std::uint32_t(x))) << 32)
+         | byte_swap(std::uint32_t(x >> 32));
+}
+
+template <class T> struct IEEEBits;
+template <> struct IEEEBits<float>
+{
+    using type = std::uint32_t;
+    static constexpr type expmask = 0x7F800000u;
+};
+template <> struct IEEEBits<double>
+{
+    using type = std::uint64_t;
+    static constexpr type expmask = 0x7FF0000000000000u;
+};
+
+//
+// out[i] = in[i] for IEEE TI in and IEEE TO out, each in the native or
+// the reversed byte order.  The loop has no branches, so it vectorizes.
+// Between float and double, a denormal or zero in or out is written as
+// +0, which is what PD_fconvert followed by PD_fixdenormals does.
+//
+template <class TO, bool SWAPO, class TI, bool SWAPI>
+void
+ieee_convert (void* out, const void* in, long nitems)
+{
+    using UI = typename IEEEBits<TI>::type;
+    using UO = typename IEEEBits<TO>::type;
+    const char* pin  = static_cast<const char*>(in);
+    char*       pout = static_cast<char*>(out);
+    AMREX_PRAGMA_SIMD
+    for (long i = 0; i < nitems; ++i)
+    {
+        UI ui;
+        std::memcpy(&ui, pin + i*sizeof(UI), sizeof(UI));
+        if (SWAPI) ui = byte_swap(ui);
+        TI x;
+        std::memcpy(&x, &ui, sizeof(TI));
+        const TO y = static_cast<TO>(x);
+        UO uo;
+        std::memcpy(&uo, &y, sizeof(TO));
+        if (sizeof(TO) != sizeof(TI)) {
+            const bool denormal = (ui & IEEEBits<TI>::expmask) == 0
+                               || (uo & IEEEBits<TO>::expmask) == 0;
+            uo = denormal ? UO(0) : uo;
+        }
+        if (SWAPO) uo = byte_swap(uo);
+        std::memcpy(pout + i*sizeof(UO), &uo, sizeof(UO));
+    }
+}
+
+typedef void (*IEEEConvertFn) (void*, const void*, long);
+
+//
+// Returns 4 or 8 if rd is IEEE single or double precision in the native
+// or the reversed byte order, and 0 otherwise.
+//
+int
+ieee_size (const RealDescriptor& rd, bool& swapped)
+{
+    const Vector<int>& ord = rd.orderarray();
+    const long* fmt;
+    const int*  normal;
+    const int*  reverse;
+    if (rd.numBytes() == 4 && ord.size() == 4) {
+        fmt     = FPC::ieee_float;
+        normal  = FPC::normal_float_order;
+        reverse = FPC::reverse_float_order;
+    } else if (rd.numBytes() == 8 && ord.size() == 8) {
+        fmt     = FPC::ieee_double;
+        normal  = FPC::normal_double_order;
+        reverse = FPC::reverse_double_order;
+    } else {
+        return 0;
+    }
+    if ( ! std::equal(rd.formatarray().begin(), rd.formatarray().end(), fmt)) {
+        return 0;
+    }
+    const bool is_normal  = std::equal(ord.begin(), ord.end(), normal);
+    const bool is_reverse = std::equal(ord.begin(), ord.end(), reverse);
+    if ( ! is_normal && ! is_reverse) {
+        return 0;
+    }
+    const bool native_is_reverse = FPC::Native32RealDescriptor().orderarray()[0] == 4;
+    swapped = (is_reverse != native_is_reverse);
+    return rd.numBytes();
+}
+
+//
+// The conversion from ird to ord if both are IEEE formats, or nullptr.
+//
+IEEEConvertFn
+ieee_converter (const RealDescriptor& ord, const RealDescriptor& ird)
+{
+    bool oswap = false, iswap = false;
+    const int osize = ieee_size(ord, oswap);
+    const int isize = ieee_size(ird, iswap);
+    if (osize == 0 || isize == 0) {
+        return nullptr;
+    }
+    static const IEEEConvertFn fns[16] = {
+        ieee_convert<float ,false,float ,false>, ieee_convert<float ,false,float ,true>,
+        ieee_convert<float ,false,double,false>, ieee_convert<float ,false,double,true>,
+        ieee_convert<float ,true ,float ,false>, ieee_convert<float ,true ,float ,true>,
+        ieee_convert<float ,true ,double,false>, ieee_convert<float ,true ,double,true>,
+        ieee_convert<double,false,float ,false>, ieee_convert<double,false,float ,true>,
+        ieee_convert<double,false,double,false>, ieee_convert<double,false,double,true>,
+        ieee_convert<double,true ,float ,false>, ieee_convert<double,true ,float ,true>,
+        ieee_convert<double,true ,double,false>, ieee_convert<double,true ,double,true>
+    };
+    return fns[(osize == 8)*8 + oswap*4 + (isize == 8)*2 + iswap];
+}
+
+//
+// Large arrays are converted by all the threads, unless we already are
+// in a parallel region.
+//
+void
+ieee_convert_threaded (IEEEConvertFn f, void* out, int osize,
+                       const void* in, int isize, long nitems)
+{
+#ifdef _OPENMP
+    if (nitems >= convertThreadMin && omp_get_max_threads() > 1 && ! omp_in_parallel())
+    {
+#pragma omp parallel
+        {
+            const long nthreads = omp_get_num_threads();
+            // ---- whole cache lines per thread
+            const long chunk = ((nitems + nthreads - 1) / nthreads + 63) / 64 * 64;
+            const long lo = chunk * omp_get_thread_num();
+            const long n  = std::min(chunk, nitems - lo);
+            if (n > 0) {
+                f(static_cast<char*>(out) + lo*osize,
+                  static_cast<const char*>(in) + lo*isize, n);
+            }
+        }
+        return;
+    }
+#endif
+    f(out, in, nitems);
+}
+
+}
+
 static
 void
 PD_convert (void*                 out,
@@ -922,17 +1095,13 @@ PD_convert (void*                 out,
         BL_ASSERT(int(n) == nitems);
         memcpy(out, in, n*ord.numBytes());
     }
+    else if (IEEEConvertFn f = (boffs == 0 && ! onescmp) ? ieee_converter(ord, ird) : nullptr) {
+        ieee_convert_threaded(f, out, ord.numBytes(), in, ird.numBytes(), nitems);
+    }
     else if (ord.formatarray() == ird.formatarray() && boffs == 0 && ! onescmp) {
         permute_real_word_order(out, in, nitems,
                                 ord.order(), ird.order(), ord.numBytes());
     }
-    else if (ird == FPC::NativeRealDescriptor() && ord == FPC::Native32RealDescriptor()) {
-      const Real *rIn = static_cast<const Real *>(in);
-      float *rOut= static_cast<float *>(out);
-      for(long i(0); i < nitems; ++i) {
-        rOut[i] = rIn[i];
-      }
-    }
     else
     {
         PD_fconvert(out, in, nitems, boffs, ord.format(), ord.order(),
@@ -942,6 +1111,22 @@ PD_convert (void*                 out,
     }
 }
 
+//
+// Convert nitems in RealDescriptor format id to RealDescriptor format od.
+//
+
+void
+RealDescriptor::convert (void*                 out,
+                         const RealDescriptor& od,
+                         const void*           in,
+                         const RealDescriptor& id,
+                         long                  nitems)
+{
+    BL_PROFILE("RD:convert");
+
+    PD_convert(out, in, nitems, 0, od, id, FPC::NativeLongDescriptor());
+}
+
 //
 // Convert nitems in RealDescriptor format to native Real format.
 //
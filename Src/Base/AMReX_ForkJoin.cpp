@@ -292,11 +292,11 @@ ForkJoin::get_dm (const BoxArray& ba, int task_idx, const DistributionMapping& d
         int rank_lo = split_bounds[task_idx];  // note that these ranks are not necessarily global
         int nprocs_task = NProcsTask(task_idx);
 
-        Vector<int> pmap = dm_orig.ProcessorMap(); // DistributionMapping stores global ranks
-        for (auto& r : pmap) {
-            int lr = ParallelContext::global_to_local_rank(r);
+        Vector<int> pmap(dm_orig.size());
+        for (int i = 0; i < pmap.size(); ++i) {
+            int lr = ParallelContext::global_to_local_rank(dm_orig[i]); // DistributionMapping stores global ranks
             lr = lr%nprocs_task + rank_lo;
-            r = ParallelContext::local_to_global_rank(lr);
+            pmap[i] = ParallelContext::local_to_global_rank(lr);
         }
 
         dm_vec[task_idx].reset(new DistributionMapping(std::move(pmap)));
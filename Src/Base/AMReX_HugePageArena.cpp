@@ -0,0 +1,92 @@
+
+#include <AMReX_HugePageArena.H>
+#include <AMReX_BLassert.H>
+
+#include <cstdint>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace amrex {
+
+constexpr std::size_t HugePageArena::huge_page_size;
+
+HugePageArena::HugePageArena (std::size_t threshold)
+    : m_threshold(threshold)
+{}
+
+HugePageArena::~HugePageArena ()
+{
+#ifdef __linux__
+    for (const auto& kv : m_mapped) {
+        ::munmap(kv.first, kv.second);
+    }
+#endif
+}
+
+void*
+HugePageArena::alloc (std::size_t sz)
+{
+#ifdef __linux__
+    if (sz >= m_threshold)
+    {
+        const std::size_t nbytes = (sz + huge_page_size-1) / huge_page_size * huge_page_size;
+        //
+        // mmap only aligns to the base page size, so map an extra huge
+        // page and unmap the unaligned ends.
+        //
+        const std::size_t nmap = nbytes + huge_page_size;
+        void* vp = ::mmap(nullptr, nmap, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (vp != MAP_FAILED)
+        {
+            char* p = static_cast<char*>(vp);
+            char* q = reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(p) + huge_page_size-1)
+                                              / huge_page_size * huge_page_size);
+            if (q > p) {
+                ::munmap(p, q-p);
+            }
+            if (p+nmap > q+nbytes) {
+                ::munmap(q+nbytes, (p+nmap) - (q+nbytes));
+            }
+#ifdef MADV_HUGEPAGE
+            ::madvise(q, nbytes, MADV_HUGEPAGE);
+#endif
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_mapped[q] = nbytes;
+            m_used += nbytes;
+            return q;
+        }
+    }
+#endif
+    return ::operator new(sz);
+}
+
+void
+HugePageArena::free (void* pt)
+{
+    if (pt == nullptr) return;
+#ifdef __linux__
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_mapped.find(pt);
+        if (it != m_mapped.end()) {
+            ::munmap(it->first, it->second);
+            m_used -= it->second;
+            m_mapped.erase(it);
+            return;
+        }
+    }
+#endif
+    ::operator delete(pt);
+}
+
+std::size_t
+HugePageArena::heap_space_used () const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_used;
+}
+
+}
@@ -2,11 +2,33 @@
 #include <AMReX_MFIter.H>
 #include <AMReX_FabArray.H>
 #include <AMReX_FArrayBox.H>
+#include <AMReX_LayoutData.H>
+#include <AMReX_Utility.H>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
 
 namespace amrex {
 
 int MFIter::nextDynamicIndex = std::numeric_limits<int>::min();
 
+namespace {
+    //
+    // The tiles of a thread for work stealing.  The thread takes them
+    // from the head, and the other threads from the tail.
+    //
+    struct StealQueue
+    {
+        std::mutex mutex;
+        Vector<int> tiles;
+        int head = 0;
+        int tail = 0;
+    };
+    // Like nextDynamicIndex, these are shared by the threads of the current MFIter loop.
+    Vector<std::unique_ptr<StealQueue> > steal_queues;
+}
+
 MFIter::MFIter (const FabArrayBase& fabarray_, 
 		unsigned char       flags_)
     :
@@ -14,6 +36,9 @@ MFIter::MFIter (const FabArrayBase& fabarray_,
     tile_size((flags_ & Tiling) ? FabArrayBase::mfiter_tile_size : IntVect::TheZeroVector()),
     flags(flags_),
     dynamic(false),
+    steal(false),
+    m_cost(nullptr),
+    m_tile_cost(nullptr),
     index_map(nullptr),
     local_index_map(nullptr),
     tile_array(nullptr),
@@ -30,6 +55,9 @@ MFIter::MFIter (const FabArrayBase& fabarray_,
     tile_size((do_tiling_) ? FabArrayBase::mfiter_tile_size : IntVect::TheZeroVector()),
     flags(do_tiling_ ? Tiling : 0),
     dynamic(false),
+    steal(false),
+    m_cost(nullptr),
+    m_tile_cost(nullptr),
     index_map(nullptr),
     local_index_map(nullptr),
     tile_array(nullptr),
@@ -47,6 +75,9 @@ MFIter::MFIter (const FabArrayBase& fabarray_,
     tile_size(tilesize_),
     flags(flags_ | Tiling),
     dynamic(false),
+    steal(false),
+    m_cost(nullptr),
+    m_tile_cost(nullptr),
     index_map(nullptr),
     local_index_map(nullptr),
     tile_array(nullptr),
@@ -65,6 +96,9 @@ MFIter::MFIter (const BoxArray& ba, const DistributionMapping& dm, unsigned char
     tile_size((flags_ & Tiling) ? FabArrayBase::mfiter_tile_size : IntVect::TheZeroVector()),
     flags(flags_),
     dynamic(false),
+    steal(false),
+    m_cost(nullptr),
+    m_tile_cost(nullptr),
     index_map(nullptr),
     local_index_map(nullptr),
     tile_array(nullptr),
@@ -83,6 +117,9 @@ MFIter::MFIter (const BoxArray& ba, const DistributionMapping& dm, bool do_tilin
     tile_size((do_tiling_) ? FabArrayBase::mfiter_tile_size : IntVect::TheZeroVector()),
     flags(do_tiling_ ? Tiling : 0),
     dynamic(false),
+    steal(false),
+    m_cost(nullptr),
+    m_tile_cost(nullptr),
     index_map(nullptr),
     local_index_map(nullptr),
     tile_array(nullptr),
@@ -103,6 +140,9 @@ MFIter::MFIter (const BoxArray& ba, const DistributionMapping& dm,
     tile_size(tilesize_),
     flags(flags_ | Tiling),
     dynamic(false),
+    steal(false),
+    m_cost(nullptr),
+    m_tile_cost(nullptr),
     index_map(nullptr),
     local_index_map(nullptr),
     tile_array(nullptr),
@@ -122,6 +162,9 @@ MFIter::MFIter (const BoxArray& ba, const DistributionMapping& dm, const MFItInf
     tile_size(info.tilesize),
     flags(info.do_tiling ? Tiling : 0),
     dynamic(info.dynamic),
+    steal(info.steal),
+    m_cost(info.cost),
+    m_tile_cost(info.tile_cost),
     index_map(nullptr),
     local_index_map(nullptr),
     tile_array(nullptr),
@@ -148,6 +191,9 @@ MFIter::MFIter (const FabArrayBase& fabarray_, const MFItInfo& info)
     tile_size(info.tilesize),
     flags(info.do_tiling ? Tiling : 0),
     dynamic(info.dynamic),
+    steal(info.steal),
+    m_cost(info.cost),
+    m_tile_cost(info.tile_cost),
     index_map(nullptr),
     local_index_map(nullptr),
     tile_array(nullptr),
@@ -201,10 +247,12 @@ void
 MFIter::Initialize ()
 {
     if (flags & SkipInit) {
+        steal = false;
 	return;
     }
     else if (flags & AllBoxes)  // a very special case
     {
+        steal = false;
 	index_map    = &(fabArray.IndexArray());
 	currentIndex = 0;
 	beginIndex   = 0;
@@ -260,9 +308,14 @@ MFIter::Initialize ()
 	
 #ifdef _OPENMP
 	int nthreads = omp_get_num_threads();
+	if (nthreads == 1) steal = false;
 	if (nthreads > 1)
 	{
-            if (dynamic)
+            if (steal)
+            {
+                initStealing();
+            }
+            else if (dynamic)
             {
                 beginIndex = omp_get_thread_num();
             }
@@ -281,16 +334,138 @@ MFIter::Initialize ()
                 }
             }
 	}
+#else
+        steal = false;
 #endif
 
-	currentIndex = beginIndex;
+        if (m_tile_cost && !steal)
+        {
+#ifdef _OPENMP
+#pragma omp barrier
+#pragma omp single
+#endif
+            if (m_tile_cost->size() != index_map->size()) {
+                m_tile_cost->assign(index_map->size(), 0.0);
+            }
+        }
+
+	if (!steal) currentIndex = beginIndex;
 
 #ifdef AMREX_USE_GPU
 	Gpu::Device::setStreamIndex(currentIndex);
+        // Kernels are asynchronous, so the host cannot time the tiles.
+        m_cost = nullptr;
+        m_tile_cost = nullptr;
 #endif
 
 	typ = fabArray.boxArray().ixType();
+
+        if (m_cost) {
+            BL_ASSERT(m_cost->DistributionMap() == fabArray.DistributionMap());
+        }
+        if (m_cost || m_tile_cost) {
+            m_tile_start = amrex::second();
+        }
+    }
+}
+
+void
+MFIter::recordCost ()
+{
+    if (isValid())
+    {
+        const double t = amrex::second();
+        if (m_cost)
+        {
+            Real& c = (*m_cost)[*this];
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+            c += t - m_tile_start;
+        }
+        if (m_tile_cost)
+        {
+            // Only this thread works on this tile.  Smooth the estimate over steps.
+            Real& c = (*m_tile_cost)[currentIndex];
+            c = (c > 0.0) ? 0.5*(c + (t - m_tile_start)) : (t - m_tile_start);
+        }
+        m_tile_start = t;
+    }
+}
+
+void
+MFIter::initStealing ()
+{
+#ifdef _OPENMP
+#pragma omp barrier
+#pragma omp single
+    {
+        const int nthreads = omp_get_num_threads();
+        const int ntiles = endIndex - beginIndex;
+
+        if (m_tile_cost && m_tile_cost->size() != index_map->size()) {
+            m_tile_cost->assign(index_map->size(), 0.0);
+        }
+
+        Vector<Real> cost(ntiles);
+        Real total = 0.0;
+        for (int i = 0; i < ntiles; ++i) {
+            const int it = beginIndex + i;
+            cost[i] = (m_tile_cost && (*m_tile_cost)[it] > 0.0)
+                ? (*m_tile_cost)[it] : static_cast<Real>((*tile_array)[it].numPts());
+            total += cost[i];
+        }
+
+        steal_queues.resize(nthreads);
+        for (auto& q : steal_queues) {
+            if (!q) q.reset(new StealQueue);
+            q->tiles.clear();
+        }
+
+        //
+        // Contiguous ranges of tiles of about the same cost, for locality:
+        // a tile goes to the thread whose share has the middle of its cost.
+        //
+        Real sum = 0.0;
+        for (int i = 0; i < ntiles; ++i) {
+            int t = (total > 0.0) ? static_cast<int>((sum + 0.5*cost[i]) / total * nthreads) : 0;
+            t = std::min(t, nthreads-1);
+            steal_queues[t]->tiles.push_back(beginIndex+i);
+            sum += cost[i];
+        }
+
+        for (auto& q : steal_queues) {
+            if (m_tile_cost) {
+                std::stable_sort(q->tiles.begin(), q->tiles.end(),
+                                 [&] (int a, int b) { return cost[a-beginIndex] > cost[b-beginIndex]; });
+            }
+            q->head = 0;
+            q->tail = q->tiles.size();
+        }
+    }
+    // omp single has an implicit barrier.
+
+    nextStolen();
+#endif
+}
+
+void
+MFIter::nextStolen ()
+{
+#ifdef _OPENMP
+    const int tid = omp_get_thread_num();
+    const int nq = steal_queues.size();
+    for (int k = 0; k < nq; ++k)
+    {
+        StealQueue& q = *steal_queues[(tid+k)%nq];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.head < q.tail) {
+            currentIndex = (k == 0) ? q.tiles[q.head++] : q.tiles[--q.tail];
+            return;
+        }
     }
+#endif
+    currentIndex = endIndex;
 }
 
 Box 
@@ -573,7 +573,7 @@ MultiFab::MultiFab (const BoxArray&            bxs,
     :
     FabArray<FArrayBox>(bxs,dm,ncomp,ngrow,info,factory)
 {
-    if (SharedMemory() && info.alloc) initVal();  // else already done in FArrayBox
+    if ((SharedMemory() || FirstTouch()) && info.alloc) initVal();  // else already done in FArrayBox
 #ifdef BL_MEM_PROFILING
     ++num_multifabs;
     num_multifabs_hwm = std::max(num_multifabs_hwm, num_multifabs);
@@ -621,7 +621,7 @@ MultiFab::define (const BoxArray&            bxs,
                   const FabFactory<FArrayBox>& factory)
 {
     define(bxs, dm, nvar, IntVect(ngrow), info, factory);
-    if (SharedMemory() && info.alloc) initVal();  // else already done in FArrayBox
+    if ((SharedMemory() || FirstTouch()) && info.alloc) initVal();  // else already done in FArrayBox
 }
 
 void
@@ -633,7 +633,7 @@ MultiFab::define (const BoxArray&            bxs,
                   const FabFactory<FArrayBox>& factory)
 {
     this->FabArray<FArrayBox>::define(bxs,dm,nvar,ngrow,info,factory);
-    if (SharedMemory() && info.alloc) initVal();  // else already done in FArrayBox
+    if ((SharedMemory() || FirstTouch()) && info.alloc) initVal();  // else already done in FArrayBox
 }
 
 void
@@ -646,7 +646,7 @@ MultiFab::initVal ()
     for (MFIter mfi(*this, TilingIfNotGPU()); mfi.isValid(); ++mfi)
     {
         FArrayBox* fab = this->fabPtr(mfi);
-	fab->initVal();
+	fab->initVal(mfi.growntilebox());
     }
 }
 
@@ -0,0 +1,387 @@
+
+#include <AMReX_MultiFabReducer.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX.H>
+
+#include <cmath>
+#include <limits>
+
+namespace amrex {
+
+namespace {
+
+    template <class F>
+    Real
+    tile_reduce (const Box& bx, const FArrayBox& x, int xcomp, const IArrayBox* mask,
+                 Real r, F const& f)
+    {
+        const auto len = amrex::length(bx);
+        const auto lo  = amrex::lbound(bx);
+        const auto xp  = x.view(lo, xcomp);
+        if (mask) {
+            const auto mp = mask->view(lo);
+            for         (int k = 0; k < len.z; ++k) {
+                for     (int j = 0; j < len.y; ++j) {
+                    for (int i = 0; i < len.x; ++i) {
+                        if (mp(i,j,k)) r = f(r, xp(i,j,k));
+                    }
+                }
+            }
+        } else {
+            for         (int k = 0; k < len.z; ++k) {
+                for     (int j = 0; j < len.y; ++j) {
+                    for (int i = 0; i < len.x; ++i) {
+                        r = f(r, xp(i,j,k));
+                    }
+                }
+            }
+        }
+        return r;
+    }
+
+    Real
+    tile_dot (const Box& bx, const FArrayBox& x, int xcomp, const FArrayBox& y, int ycomp,
+              const IArrayBox* mask, Real r)
+    {
+        const auto len = amrex::length(bx);
+        const auto lo  = amrex::lbound(bx);
+        const auto xp  = x.view(lo, xcomp);
+        const auto yp  = y.view(lo, ycomp);
+        if (mask) {
+            const auto mp = mask->view(lo);
+            for         (int k = 0; k < len.z; ++k) {
+                for     (int j = 0; j < len.y; ++j) {
+                    for (int i = 0; i < len.x; ++i) {
+                        if (mp(i,j,k)) r += xp(i,j,k)*yp(i,j,k);
+                    }
+                }
+            }
+        } else {
+            for         (int k = 0; k < len.z; ++k) {
+                for     (int j = 0; j < len.y; ++j) {
+                    for (int i = 0; i < len.x; ++i) {
+                        r += xp(i,j,k)*yp(i,j,k);
+                    }
+                }
+            }
+        }
+        return r;
+    }
+
+#ifdef BL_USE_MPI
+    // The buffer is sent as one element of a contiguous type, so that
+    // MPI cannot split it.  Its first entry is the number of sums.
+    void
+    mfreducer_combine (void* invec, void* inoutvec, int* len, MPI_Datatype* dtype)
+    {
+        int size;
+        MPI_Type_size(*dtype, &size);
+        const int n = size / sizeof(Real);
+        for (int e = 0; e < *len; ++e) {
+            const Real* in = static_cast<const Real*>(invec) + e*n;
+            Real* io = static_cast<Real*>(inoutvec) + e*n;
+            const int nsum = static_cast<int>(io[0]);
+            for (int i = 1; i <= nsum; ++i) {
+                io[i] += in[i];
+            }
+            for (int i = nsum+1; i < n; ++i) {
+                io[i] = std::max(io[i], in[i]);
+            }
+        }
+    }
+
+    MPI_Op mfreducer_op = MPI_OP_NULL;
+
+    MPI_Op
+    get_mfreducer_op ()
+    {
+        if (mfreducer_op == MPI_OP_NULL) {
+            BL_MPI_REQUIRE( MPI_Op_create(mfreducer_combine, 1, &mfreducer_op) );
+            amrex::ExecOnFinalize([] () {
+                MPI_Op_free(&mfreducer_op);
+                mfreducer_op = MPI_OP_NULL;
+            });
+        }
+        return mfreducer_op;
+    }
+#endif
+}
+
+MultiFabReducer::~MultiFabReducer ()
+{
+#ifdef BL_USE_MPI
+    if (m_req != MPI_REQUEST_NULL) {
+        MPI_Wait(&m_req, MPI_STATUS_IGNORE);
+    }
+    if (m_type != MPI_DATATYPE_NULL) {
+        MPI_Type_free(&m_type);
+    }
+#endif
+}
+
+int
+MultiFabReducer::add (Kind kind, const MultiFab& x, int xcomp, const MultiFab* y, int ycomp,
+                      int nghost, const iMultiFab* mask)
+{
+    BL_ASSERT(xcomp >= 0 && xcomp < x.nComp());
+    BL_ASSERT(nghost >= 0 && nghost <= x.nGrow());
+    BL_ASSERT(y == nullptr || (y->boxArray() == x.boxArray() &&
+                               y->DistributionMap() == x.DistributionMap() &&
+                               nghost <= y->nGrow()));
+    BL_ASSERT(mask == nullptr || (mask->boxArray() == x.boxArray() &&
+                                  mask->DistributionMap() == x.DistributionMap() &&
+                                  nghost <= mask->nGrow()));
+
+    const bool is_sum = (kind == Kind::sum || kind == Kind::norm1 ||
+                         kind == Kind::norm2 || kind == Kind::dot);
+    const int slot = is_sum ? m_nsum++ : m_nmax++;
+    m_entry.push_back(Entry{kind, &x, xcomp, y, ycomp, nghost, mask, slot});
+    m_done = false;
+    return m_entry.size()-1;
+}
+
+int
+MultiFabReducer::addSum (const MultiFab& mf, int comp, int nghost, const iMultiFab* mask)
+{
+    return add(Kind::sum, mf, comp, nullptr, 0, nghost, mask);
+}
+
+int
+MultiFabReducer::addMin (const MultiFab& mf, int comp, int nghost, const iMultiFab* mask)
+{
+    return add(Kind::min, mf, comp, nullptr, 0, nghost, mask);
+}
+
+int
+MultiFabReducer::addMax (const MultiFab& mf, int comp, int nghost, const iMultiFab* mask)
+{
+    return add(Kind::max, mf, comp, nullptr, 0, nghost, mask);
+}
+
+int
+MultiFabReducer::addNorm0 (const MultiFab& mf, int comp, int nghost, const iMultiFab* mask)
+{
+    return add(Kind::norm0, mf, comp, nullptr, 0, nghost, mask);
+}
+
+int
+MultiFabReducer::addNorm1 (const MultiFab& mf, int comp, int nghost, const iMultiFab* mask)
+{
+    return add(Kind::norm1, mf, comp, nullptr, 0, nghost, mask);
+}
+
+int
+MultiFabReducer::addNorm2 (const MultiFab& mf, int comp, int nghost, const iMultiFab* mask)
+{
+    return add(Kind::norm2, mf, comp, nullptr, 0, nghost, mask);
+}
+
+int
+MultiFabReducer::addDot (const MultiFab& x, int xcomp, const MultiFab& y, int ycomp,
+                         int nghost, const iMultiFab* mask)
+{
+    BL_ASSERT(ycomp >= 0 && ycomp < y.nComp());
+    return add(Kind::dot, x, xcomp, &y, ycomp, nghost, mask);
+}
+
+void
+MultiFabReducer::clear ()
+{
+    m_entry.clear();
+    m_nsum = 0;
+    m_nmax = 0;
+    m_buf.clear();
+    m_value.clear();
+    m_done = false;
+}
+
+void
+MultiFabReducer::evalLocal ()
+{
+    BL_PROFILE("MultiFabReducer::evalLocal()");
+
+    const int nbuf = 1 + m_nsum + m_nmax;
+    Vector<Real> init(nbuf, 0.0);
+    init[0] = m_nsum;
+    for (int i = 1+m_nsum; i < nbuf; ++i) {
+        init[i] = std::numeric_limits<Real>::lowest();
+    }
+    m_buf = init;
+
+    auto buf_index = [this] (const Entry& e) {
+        return (e.kind == Kind::min || e.kind == Kind::max || e.kind == Kind::norm0)
+            ? 1 + m_nsum + e.slot : 1 + e.slot;
+    };
+
+    // One pass for each BoxArray and DistributionMapping
+    const int nentries = m_entry.size();
+    Vector<char> done(nentries, 0);
+    Vector<int> group;
+    for (int i0 = 0; i0 < nentries; ++i0)
+    {
+        if (done[i0]) continue;
+        const MultiFab& mf0 = *m_entry[i0].x;
+        group.clear();
+        for (int i = i0; i < nentries; ++i) {
+            if (!done[i] && m_entry[i].x->boxArray() == mf0.boxArray()
+                         && m_entry[i].x->DistributionMap() == mf0.DistributionMap()) {
+                group.push_back(i);
+                done[i] = 1;
+            }
+        }
+
+#ifdef _OPENMP
+#pragma omp parallel if (!system::regtest_reduction)
+#endif
+        {
+            Vector<Real> priv(init);
+
+            for (MFIter mfi(mf0,true); mfi.isValid(); ++mfi)
+            {
+                for (int i : group)
+                {
+                    const Entry& e = m_entry[i];
+                    const Box& bx = mfi.growntilebox(e.nghost);
+                    const FArrayBox& xfab = (*e.x)[mfi];
+                    const IArrayBox* mfab = (e.mask) ? &((*e.mask)[mfi]) : nullptr;
+                    Real& r = priv[buf_index(e)];
+                    switch (e.kind)
+                    {
+                    case Kind::sum:
+                        r = tile_reduce(bx, xfab, e.xcomp, mfab, r,
+                                        [] (Real a, Real v) { return a + v; });
+                        break;
+                    case Kind::min:
+                        // stored as max of -x
+                        r = tile_reduce(bx, xfab, e.xcomp, mfab, r,
+                                        [] (Real a, Real v) { return std::max(a, -v); });
+                        break;
+                    case Kind::max:
+                        r = tile_reduce(bx, xfab, e.xcomp, mfab, r,
+                                        [] (Real a, Real v) { return std::max(a, v); });
+                        break;
+                    case Kind::norm0:
+                        r = tile_reduce(bx, xfab, e.xcomp, mfab, r,
+                                        [] (Real a, Real v) { return std::max(a, std::abs(v)); });
+                        break;
+                    case Kind::norm1:
+                        r = tile_reduce(bx, xfab, e.xcomp, mfab, r,
+                                        [] (Real a, Real v) { return a + std::abs(v); });
+                        break;
+                    case Kind::norm2:
+                        r = tile_reduce(bx, xfab, e.xcomp, mfab, r,
+                                        [] (Real a, Real v) { return a + v*v; });
+                        break;
+                    case Kind::dot:
+                        r = tile_dot(bx, xfab, e.xcomp, (*e.y)[mfi], e.ycomp, mfab, r);
+                        break;
+                    }
+                }
+            }
+
+#ifdef _OPENMP
+#pragma omp critical (multifabreducer)
+#endif
+            {
+                for (int i : group) {
+                    const int b = buf_index(m_entry[i]);
+                    if (b <= m_nsum) {
+                        m_buf[b] += priv[b];
+                    } else {
+                        m_buf[b] = std::max(m_buf[b], priv[b]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void
+MultiFabReducer::unpack ()
+{
+    const int nentries = m_entry.size();
+    m_value.resize(nentries);
+    for (int i = 0; i < nentries; ++i)
+    {
+        const Entry& e = m_entry[i];
+        switch (e.kind)
+        {
+        case Kind::min:
+            m_value[i] = -m_buf[1+m_nsum+e.slot];
+            break;
+        case Kind::max:
+            m_value[i] = m_buf[1+m_nsum+e.slot];
+            break;
+        case Kind::norm0:
+            m_value[i] = std::max(m_buf[1+m_nsum+e.slot], Real(0.0));
+            break;
+        case Kind::norm2:
+            m_value[i] = std::sqrt(m_buf[1+e.slot]);
+            break;
+        default:
+            m_value[i] = m_buf[1+e.slot];
+        }
+    }
+    m_done = true;
+}
+
+void
+MultiFabReducer::eval (bool local)
+{
+    BL_PROFILE("MultiFabReducer::eval()");
+
+    if (local) {
+        evalLocal();
+        unpack();
+    } else {
+        eval_nowait();
+        eval_finish();
+    }
+}
+
+void
+MultiFabReducer::eval_nowait ()
+{
+    BL_PROFILE("MultiFabReducer::eval_nowait()");
+
+    evalLocal();
+    m_done = false;
+
+#ifdef BL_USE_MPI
+    AMREX_ASSERT(m_req == MPI_REQUEST_NULL);
+    int nprocs;
+    MPI_Comm_size(m_comm, &nprocs);
+    if (nprocs > 1)
+    {
+        BL_MPI_REQUIRE( MPI_Type_contiguous(m_buf.size(), ParallelDescriptor::Mpi_typemap<Real>::type(),
+                                            &m_type) );
+        BL_MPI_REQUIRE( MPI_Type_commit(&m_type) );
+#if (MPI_VERSION >= 3)
+        BL_MPI_REQUIRE( MPI_Iallreduce(MPI_IN_PLACE, m_buf.data(), 1, m_type, get_mfreducer_op(),
+                                       m_comm, &m_req) );
+#else
+        BL_MPI_REQUIRE( MPI_Allreduce(MPI_IN_PLACE, m_buf.data(), 1, m_type, get_mfreducer_op(),
+                                      m_comm) );
+#endif
+    }
+#endif
+}
+
+void
+MultiFabReducer::eval_finish ()
+{
+    BL_PROFILE("MultiFabReducer::eval_finish()");
+
+#ifdef BL_USE_MPI
+    if (m_req != MPI_REQUEST_NULL) {
+        BL_MPI_REQUIRE( MPI_Wait(&m_req, MPI_STATUS_IGNORE) );
+    }
+    if (m_type != MPI_DATATYPE_NULL) {
+        BL_MPI_REQUIRE( MPI_Type_free(&m_type) );
+    }
+#endif
+
+    unpack();
+}
+
+}
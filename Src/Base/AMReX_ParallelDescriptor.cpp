@@ -8,6 +8,7 @@
 #include <stack>
 #include <list>
 #include <chrono>
+#include <map>
 
 #include <AMReX.H>
 #include <AMReX_Utility.H>
@@ -47,6 +48,7 @@ namespace ParallelDescriptor
     ProcessTeam m_Team;
 
     MPI_Comm m_comm = MPI_COMM_NULL;    // communicator for all ranks, probably MPI_COMM_WORLD
+    MPI_Comm m_comm_node = MPI_COMM_NULL;    // ranks of m_comm on this node
 
     int m_MinTag = 1000, m_MaxTag = -1;
 
@@ -56,6 +58,27 @@ namespace ParallelDescriptor
     MPI_Win cp_win;
     MPI_Win fb_win;
 #endif
+
+    namespace
+    {
+        struct NodeShared
+        {
+#if defined(BL_USE_MPI) && (MPI_VERSION >= 3)
+            MPI_Win win;
+#endif
+            void* p;
+            int   released;
+        };
+        //
+        // The node shared allocations by handle.  All the ranks of a node
+        // make them in the same order, so they have the same handles.
+        //
+        std::map<int,NodeShared> node_shared;
+        int node_shared_next = 0;
+
+        //! Collective over m_comm_node.  Free the memory released by all the ranks, or all of it.
+        void freeNodeShared (bool all);
+    }
   
     namespace util
     {
@@ -305,6 +328,12 @@ ParallelDescriptor::StartParallel (int*    argc,
 
     ParallelContext::push(m_comm);
 
+#if (MPI_VERSION >= 3)
+    BL_MPI_REQUIRE( MPI_Comm_split_type(m_comm, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &m_comm_node) );
+#else
+    BL_MPI_REQUIRE( MPI_Comm_dup(MPI_COMM_SELF, &m_comm_node) );
+#endif
+
     // ---- find the maximum value for a tag
     int flag(0), *p;
     // For Open MPI, calling this with subcommunicators will fail.
@@ -329,6 +358,10 @@ ParallelDescriptor::StartParallel (int*    argc,
 void
 ParallelDescriptor::EndParallel ()
 {
+    freeNodeShared(true);
+    BL_MPI_REQUIRE( MPI_Comm_free(&m_comm_node) );
+    m_comm_node = MPI_COMM_NULL;
+
     if (!call_mpi_finalize) {
         BL_MPI_REQUIRE( MPI_Comm_free(&m_comm) );
     }
@@ -1657,6 +1690,7 @@ ParallelDescriptor::StartParallel (int*    argc,
                                    MPI_Comm)
 {
     m_comm = 0;
+    m_comm_node = 0;
     m_MaxTag = 9000;
     ParallelContext::push(m_comm);
 }
@@ -1688,6 +1722,7 @@ ParallelDescriptor::Message::test ()
 
 void ParallelDescriptor::EndParallel () 
 {
+    freeNodeShared(true);
     ParallelContext::pop();
 }
 
@@ -1828,6 +1863,123 @@ ParallelDescriptor::Waitsome (Vector<MPI_Request>& reqs,
 
 #endif
 
+int
+ParallelDescriptor::MyRankInNode ()
+{
+    return MyProc(m_comm_node);
+}
+
+int
+ParallelDescriptor::NProcsPerNode ()
+{
+#ifdef BL_USE_MPI
+    int n;
+    MPI_Comm_size(m_comm_node, &n);
+    return n;
+#else
+    return 1;
+#endif
+}
+
+void*
+ParallelDescriptor::AllocNodeShared (std::size_t nbytes, int& handle,
+                                     const std::function<void(void*)>& init)
+{
+    BL_PROFILE("ParallelDescriptor::AllocNodeShared()");
+
+    freeNodeShared(false);
+
+    NodeShared ns;
+    ns.released = 0;
+#if defined(BL_USE_MPI) && (MPI_VERSION >= 3)
+    const bool writer = MyRankInNode() == 0;
+    const MPI_Aint sz = writer ? std::max<std::size_t>(nbytes,1) : 0;
+    void* mine;
+    BL_MPI_REQUIRE( MPI_Win_allocate_shared(sz, 1, MPI_INFO_NULL, m_comm_node, &mine, &ns.win) );
+    MPI_Aint qsz;
+    int disp;
+    BL_MPI_REQUIRE( MPI_Win_shared_query(ns.win, 0, &qsz, &disp, &ns.p) );
+    BL_MPI_REQUIRE( MPI_Win_lock_all(MPI_MODE_NOCHECK, ns.win) );
+    if (writer) {
+        init(ns.p);
+    }
+    // Make the writes of rank 0 visible to the others.
+    BL_MPI_REQUIRE( MPI_Win_sync(ns.win) );
+    BL_MPI_REQUIRE( MPI_Barrier(m_comm_node) );
+    BL_MPI_REQUIRE( MPI_Win_sync(ns.win) );
+#else
+    BL_ASSERT(MyRankInNode() == 0);
+    ns.p = std::malloc(std::max<std::size_t>(nbytes,1));
+    init(ns.p);
+#endif
+
+    handle = node_shared_next++;
+    node_shared[handle] = ns;
+    return ns.p;
+}
+
+void
+ParallelDescriptor::FreeNodeShared (int handle)
+{
+#ifdef _OPENMP
+#pragma omp critical(node_shared_lock)
+#endif
+    {
+        auto it = node_shared.find(handle);
+        if (it != node_shared.end()) {
+            it->second.released = 1;
+        }
+    }
+}
+
+namespace ParallelDescriptor {
+namespace {
+
+void
+freeNodeShared (bool all)
+{
+    if (node_shared.empty()) return;
+
+    if (!all)
+    {
+        // Only free what is released by all the ranks of the node.
+        Vector<int> released;
+        released.reserve(node_shared.size());
+        for (const auto& kv : node_shared) {
+            released.push_back(kv.second.released);
+        }
+#ifdef BL_USE_MPI
+        BL_MPI_REQUIRE( MPI_Allreduce(MPI_IN_PLACE, released.data(), released.size(),
+                                      MPI_INT, MPI_MIN, m_comm_node) );
+#endif
+        int i = 0;
+        for (auto& kv : node_shared) {
+            kv.second.released = released[i++];
+        }
+    }
+
+    for (auto it = node_shared.begin(); it != node_shared.end(); )
+    {
+        if (all || it->second.released)
+        {
+#if defined(BL_USE_MPI) && (MPI_VERSION >= 3)
+            BL_MPI_REQUIRE( MPI_Win_unlock_all(it->second.win) );
+            BL_MPI_REQUIRE( MPI_Win_free(&it->second.win) );
+#else
+            std::free(it->second.p);
+#endif
+            it = node_shared.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+}
+}
+
 BL_FORT_PROC_DECL(BL_PD_BARRIER,bl_pd_barrier)()
 {
     ParallelDescriptor::Barrier();
@@ -2036,6 +2188,54 @@ ParallelDescriptor::ReadAndBcastFile (const std::string& filename,
 }
 
 
+void
+ParallelDescriptor::ReadAndBcastFiles (const Vector<std::string>& filenames,
+                                       Vector<Vector<char> >&     charBufs,
+                                       bool                       bExitOnError)
+{
+    BL_PROFILE("ParallelDescriptor::ReadAndBcastFiles()");
+
+    const int nfiles = filenames.size();
+    const int nprocs = ParallelDescriptor::NProcs();
+    const int myproc = ParallelDescriptor::MyProc();
+
+    charBufs.resize(nfiles);
+
+    // ---- each rank reads its share of the files
+    Vector<long> fileLength(nfiles, 0);
+    for (int i = myproc; i < nfiles; i += nprocs) {
+        std::ifstream iss(filenames[i].c_str(), std::ios::in | std::ios::binary);
+        if ( ! iss.good()) {
+            if(bExitOnError) {
+                amrex::FileOpenFailed(filenames[i]);
+            }
+            fileLength[i] = -1;
+            continue;
+        }
+        iss.seekg(0, std::ios::end);
+        fileLength[i] = static_cast<std::streamoff>(iss.tellg());
+        iss.seekg(0, std::ios::beg);
+        charBufs[i].resize(fileLength[i] + 1);
+        iss.read(charBufs[i].dataPtr(), fileLength[i]);
+        charBufs[i][fileLength[i]] = '\0';
+    }
+
+    // ---- one reduction for all the lengths, then the contents from each reader
+    ParallelDescriptor::ReduceLongSum(fileLength.dataPtr(), nfiles);
+
+    for (int i = 0; i < nfiles; ++i) {
+        if (fileLength[i] < 0) {
+            charBufs[i].clear();
+            continue;
+        }
+        const long fileLengthPadded = fileLength[i] + 1;
+        charBufs[i].resize(fileLengthPadded);
+        ParallelDescriptor::Bcast(charBufs[i].dataPtr(), fileLengthPadded, i % nprocs);
+        charBufs[i][fileLength[i]] = '\0';
+    }
+}
+
+
 #ifndef BL_AMRPROF
 void
 ParallelDescriptor::StartTeams ()
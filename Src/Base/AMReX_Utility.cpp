@@ -526,15 +526,14 @@ int amrex::HashDistributionMap(const DistributionMapping &dm, int hashSize)
 {
   BL_ASSERT(hashSize > 0);
 
-  const Vector<int> &dmArrayMap = dm.ProcessorMap();
   Vector<long> hash(hashSize, 0);
 
   // Create hash by summing processer map over
   //   a looped hash array of given size. 
-  for (int i=0; i<dmArrayMap.size(); i++)
+  for (int i=0; i<dm.size(); i++)
   {
     int hashIndex = (i%hashSize);
-    hash[hashIndex] += dmArrayMap[i];
+    hash[hashIndex] += dm[i];
   }
 
   // Output hash is the ones digit of each element
@@ -6,6 +6,14 @@
 #include <vector>
 #include <deque>
 #include <cerrno>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <AMReX_ccse-mpi.H>
 #include <AMReX_Utility.H>
@@ -33,6 +41,10 @@ bool VisMF::usePersistentIFStreams(false);
 bool VisMF::useSynchronousReads(false);
 bool VisMF::useDynamicSetSelection(true);
 bool VisMF::allowSparseWrites(true);
+bool VisMF::useAggregatedWrites(false);
+int  VisMF::nAggregators(0);
+bool VisMF::useAggregatedReads(false);
+long VisMF::aggregatorBufferSize(1 << 25);
 
 long VisMF::ioBufferSize(VisMF::IO_Buffer_Size);
 
@@ -46,6 +58,13 @@ int VisMF::nMFFileInStreams(4);
 namespace
 {
     bool initialized = false;
+
+    //! An istream reads the bytes of a buffer through this.
+    struct MemoryStreamBuf
+        : public std::streambuf
+    {
+        MemoryStreamBuf (char *p, long n) { setg(p, p, p + n); }
+    };
 }
 
 void
@@ -82,6 +101,11 @@ VisMF::Initialize ()
     pp.query("usedynamicsetselection", useDynamicSetSelection);
     pp.query("iobuffersize", ioBufferSize);
     pp.query("allowsparsewrites", allowSparseWrites);
+    pp.query("useaggregatedwrites", useAggregatedWrites);
+    pp.query("naggregators", nAggregators);
+    nAggregators = std::max(0, nAggregators);
+    pp.query("aggregatorbuffersize", aggregatorBufferSize);
+    pp.query("useaggregatedreads", useAggregatedReads);
 
     initialized = true;
 }
@@ -722,7 +746,7 @@ VisMF::Header::CalculateMinMax (const FabArray<FArrayBox>& mf,
     Vector<int> nmtags(ParallelDescriptor::NProcs(), 0);
     Vector<int> offset(ParallelDescriptor::NProcs(), 0);
 
-    const Vector<int> &pmap = mf.DistributionMap().ProcessorMap();
+    const DistributionMapping& pmap = mf.DistributionMap();
 
     for(int i(0), N = mf.size(); i < N; ++i) {
         ++nmtags[pmap[i]];
@@ -941,9 +965,17 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
         }
     }
 
+#ifdef BL_USE_MPI
+    if(useAggregatedWrites && ParallelDescriptor::NProcs() > 1) {
+      long bytesWritten(WriteAggregated(mf, mf_name, how, *whichRD));
+      delete whichRD;
+      return bytesWritten;
+    }
+#endif
+
     // ---- check if mf has sparse data
     bool useSparseFPP(false);
-    const Vector<int> &pmap = mf.DistributionMap().ProcessorMap();
+    const DistributionMapping& pmap = mf.DistributionMap();
     std::set<int> procsWithData;
     Vector<int> procsWithDataVector;
     for(int i(0); i < pmap.size(); ++i) {
@@ -1076,6 +1108,603 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
 }
 
 
+#ifdef BL_USE_MPI
+Vector<int>
+VisMF::Aggregators ()
+{
+    const int myProc(ParallelDescriptor::MyProc());
+    const int nProcs(ParallelDescriptor::NProcs());
+
+    // ---- the aggregator of a rank is the lowest rank on its node,
+    // ---- or in its block of nProcs/nAggregators ranks
+    int myAggregator(myProc);
+    if(nAggregators > 0) {
+      const long nAgg(std::min(nAggregators, nProcs));
+      const long whichAgg((myProc * nAgg) / nProcs);
+      myAggregator = (whichAgg * nProcs + nAgg - 1) / nAgg;
+    } else {
+      BL_MPI_REQUIRE( MPI_Bcast(&myAggregator, 1, MPI_INT, 0,
+                                ParallelDescriptor::CommunicatorNode()) );
+    }
+    Vector<int> aggregators(nProcs);
+    BL_MPI_REQUIRE( MPI_Allgather(&myAggregator, 1, MPI_INT, aggregators.dataPtr(), 1, MPI_INT,
+                                  ParallelDescriptor::Communicator()) );
+    return aggregators;
+}
+
+
+long
+VisMF::WriteAggregated (const FabArray<FArrayBox> &mf,
+                        const std::string         &mf_name,
+                        VisMF::How                 how,
+                        const RealDescriptor      &whichRD)
+{
+    BL_PROFILE("VisMF::WriteAggregated()");
+
+    long bytesWritten(0);
+    bool calcMinMax(false);
+    VisMF::Header hdr(mf, how, currentVersion, calcMinMax);
+    std::string filePrefix(mf_name + FabFileSuffix);
+    const int coordinatorProc(ParallelDescriptor::IOProcessorNumber());
+    const int myProc(ParallelDescriptor::MyProc());
+    const int nProcs(ParallelDescriptor::NProcs());
+    MPI_Comm comm(ParallelDescriptor::Communicator());
+    const bool oldHeader(currentVersion == VisMF::Header::Version_v1);
+    const bool doConvert(whichRD != FPC::NativeRealDescriptor());
+    const int whichRDBytes(whichRD.numBytes());
+    const FABio &fio = FArrayBox::getFABio();
+
+    const Vector<int> aggregators(VisMF::Aggregators());  // ---- [rank]
+    const int myAggregator(aggregators[myProc]);
+    // ---- the files are numbered in the order of their aggregators
+    std::map<int, int> aggFileNumber;  // ---- [aggregator rank, file number]
+    for(int i(0); i < nProcs; ++i) {
+      aggFileNumber.insert(std::make_pair(aggregators[i], 0));
+    }
+    int nAggFiles(0);
+    for(auto &af : aggFileNumber) {
+      af.second = nAggFiles++;
+    }
+
+    // ---- phase one:  the fabs of this rank, with their headers, in index order
+    long localBytes(0);
+    for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+      const FArrayBox &fab = mf[mfi];
+      if(oldHeader) {
+        std::stringstream hss;
+        fio.write_header(hss, fab, fab.nComp());
+        localBytes += static_cast<std::streamoff>(hss.tellp());
+      }
+      localBytes += fab.box().numPts() * mf.nComp() * whichRDBytes;
+    }
+    std::unique_ptr<char[]> localData(new char[std::max(localBytes, 1L)]);
+    long localPosition(0);
+    for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+      const FArrayBox &fab = mf[mfi];
+      char *afPtr = localData.get() + localPosition;
+      if(oldHeader) {
+        std::stringstream hss;
+        fio.write_header(hss, fab, fab.nComp());
+        const long hLength(static_cast<std::streamoff>(hss.tellp()));
+        memcpy(afPtr, hss.str().c_str(), hLength);
+        afPtr += hLength;
+        localPosition += hLength;
+      }
+      const long writeDataItems(fab.box().numPts() * mf.nComp());
+      if(doConvert) {
+        RealDescriptor::convertFromNativeFormat(static_cast<void *> (afPtr), writeDataItems,
+                                                fab.dataPtr(), whichRD);
+      } else {
+        memcpy(afPtr, fab.dataPtr(), writeDataItems * whichRDBytes);
+      }
+      localPosition += writeDataItems * whichRDBytes;
+    }
+    BL_ASSERT(localPosition == localBytes);
+    bytesWritten += localBytes;
+
+    // ---- phase two:  the aggregator, rank 0 of aggComm, writes the data of
+    // ---- its ranks in rank order in blocks of aggregatorBufferSize bytes
+    MPI_Comm aggComm;
+    BL_MPI_REQUIRE( MPI_Comm_split(comm, myAggregator, myProc, &aggComm) );
+    int aggRank, aggSize;
+    BL_MPI_REQUIRE( MPI_Comm_rank(aggComm, &aggRank) );
+    BL_MPI_REQUIRE( MPI_Comm_size(aggComm, &aggSize) );
+    BL_ASSERT((aggRank == 0) == (myAggregator == myProc));
+
+    const long blockSize(std::min(aggregatorBufferSize,
+                                  static_cast<long>(std::numeric_limits<int>::max())));
+    const int aggTag(ParallelDescriptor::SeqNum());
+    long myOffset(0);
+    BL_MPI_REQUIRE( MPI_Exscan(&localBytes, &myOffset, 1, MPI_LONG, MPI_SUM, aggComm) );
+    if(aggRank == 0) {
+      myOffset = 0;
+    }
+    Vector<long> memberBytes(aggRank == 0 ? aggSize : 1);
+    BL_MPI_REQUIRE( MPI_Gather(&localBytes, 1, MPI_LONG,
+                               memberBytes.dataPtr(), 1, MPI_LONG, 0, aggComm) );
+
+    if(aggRank != 0) {
+      // ---- one message for each block this rank's data is in
+      Vector<MPI_Request> reqs;
+      for(long pos(0); pos < localBytes; ) {
+        const long n(std::min(localBytes - pos, blockSize - (myOffset + pos) % blockSize));
+        reqs.push_back(MPI_REQUEST_NULL);
+        BL_MPI_REQUIRE( MPI_Isend(localData.get() + pos, static_cast<int>(n), MPI_CHAR,
+                                  0, aggTag, aggComm, &reqs.back()) );
+        pos += n;
+      }
+      if( ! reqs.empty()) {
+        BL_MPI_REQUIRE( MPI_Waitall(static_cast<int>(reqs.size()), reqs.dataPtr(), MPI_STATUSES_IGNORE) );
+      }
+    } else {
+      Vector<long> memberOffset(aggSize + 1, 0);
+      for(int m(0); m < aggSize; ++m) {
+        memberOffset[m+1] = memberOffset[m] + memberBytes[m];
+      }
+      const long fileBytes(memberOffset[aggSize]);
+      const long nBlocks((fileBytes + blockSize - 1) / blockSize);
+
+      if(nBlocks > 0) {
+        std::string fileName(NFilesIter::FileName(aggFileNumber[myProc], filePrefix));
+        std::ofstream ofs;
+        ofs.rdbuf()->pubsetbuf(0, 0);
+        ofs.open(fileName.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+        if( ! ofs.good()) {
+          amrex::FileOpenFailed(fileName);
+        }
+
+        // ---- receive block k+1 while writing block k
+        const long bufferSize(std::min(blockSize, fileBytes));
+        std::unique_ptr<char[]> buffers[2] = { std::unique_ptr<char[]>(new char[bufferSize]),
+                                               std::unique_ptr<char[]>(new char[bufferSize]) };
+        Vector<MPI_Request> reqs[2];
+        int firstMember(0);
+        auto postBlock = [&] (long k) {
+          char *buffer = buffers[k%2].get();
+          Vector<MPI_Request> &breqs = reqs[k%2];
+          breqs.clear();
+          const long lo(k * blockSize), hi(std::min(lo + blockSize, fileBytes));
+          while(memberOffset[firstMember+1] <= lo) {
+            ++firstMember;
+          }
+          for(int m(firstMember); m < aggSize && memberOffset[m] < hi; ++m) {
+            const long b(std::max(lo, memberOffset[m]));
+            const long e(std::min(hi, memberOffset[m+1]));
+            if(e <= b) {
+              continue;
+            }
+            if(m == 0) {
+              memcpy(buffer + (b - lo), localData.get() + b, e - b);
+            } else {
+              breqs.push_back(MPI_REQUEST_NULL);
+              BL_MPI_REQUIRE( MPI_Irecv(buffer + (b - lo), static_cast<int>(e - b), MPI_CHAR,
+                                        m, aggTag, aggComm, &breqs.back()) );
+            }
+          }
+        };
+
+        postBlock(0);
+        for(long k(0); k < nBlocks; ++k) {
+          if(k+1 < nBlocks) {
+            postBlock(k+1);
+          }
+          Vector<MPI_Request> &breqs = reqs[k%2];
+          if( ! breqs.empty()) {
+            BL_MPI_REQUIRE( MPI_Waitall(static_cast<int>(breqs.size()), breqs.dataPtr(), MPI_STATUSES_IGNORE) );
+          }
+          const long n(std::min(blockSize, fileBytes - k * blockSize));
+          ofs.write(buffers[k%2].get(), n);
+        }
+        ofs.flush();
+        ofs.close();
+        if( ! ofs.good()) {
+          amrex::Error("VisMF::WriteAggregated:  error writing " + fileName);
+        }
+      }
+    }
+    localData.reset();
+    BL_MPI_REQUIRE( MPI_Comm_free(&aggComm) );
+
+    // ---- the header:  the ranks of an aggregator are in rank order in its file
+    if(myProc == coordinatorProc) {
+      const BoxArray &mfBA = mf.boxArray();
+      const DistributionMapping &mfDM = mf.DistributionMap();
+      Vector<Vector<int> > rankBoxes(nProcs);
+      for(int i(0); i < mfBA.size(); ++i) {
+        rankBoxes[mfDM[i]].push_back(i);
+      }
+      std::map<int, long> fileOffset;  // ---- [aggregator rank, offset]
+      for(int rank(0); rank < nProcs; ++rank) {
+        const int agg(aggregators[rank]);
+        const std::string fileName(VisMF::BaseName(NFilesIter::FileName(aggFileNumber[agg],
+                                                                         filePrefix)));
+        long &offset = fileOffset[agg];
+        for(int i : rankBoxes[rank]) {
+          long fabHeaderBytes(0);
+          if(oldHeader) {
+            std::stringstream hss;
+            FArrayBox tempFab(mf.fabbox(i), mf.nComp(), false);  // ---- no alloc
+            fio.write_header(hss, tempFab, tempFab.nComp());
+            fabHeaderBytes = static_cast<std::streamoff>(hss.tellp());
+          }
+          hdr.m_fod[i].m_name = fileName;
+          hdr.m_fod[i].m_head = offset;
+          offset += mf.fabbox(i).numPts() * mf.nComp() * whichRDBytes + fabHeaderBytes;
+        }
+      }
+    }
+
+    if(currentVersion == VisMF::Header::Version_v1 ||
+       currentVersion == VisMF::Header::NoFabHeaderMinMax_v1)
+    {
+      hdr.CalculateMinMax(mf, coordinatorProc);
+    }
+
+    bytesWritten += VisMF::WriteHeader(mf_name, hdr, coordinatorProc);
+
+    return bytesWritten;
+}
+#endif
+
+
+#ifdef BL_USE_MPI
+void
+VisMF::ReadAggregated (FabArray<FArrayBox> &mf,
+                       const std::string   &mf_name,
+                       const VisMF::Header &hdr,
+                       int                  coordinatorProc)
+{
+    BL_PROFILE("VisMF::ReadAggregated()");
+
+    const int myProc(ParallelDescriptor::MyProc());
+    MPI_Comm comm(ParallelDescriptor::Communicator());
+    const DistributionMapping &dm = mf.DistributionMap();
+    const bool noFabHeader(NoFabHeader(hdr));
+    const bool doConvert(hdr.m_writtenRD != FPC::NativeRealDescriptor());
+    const int nBoxes(hdr.m_ba.size());
+
+    // ---- the fabs are read and received whole, into mf
+    AMREX_ALWAYS_ASSERT(mf.nGrowVect() == hdr.m_ngrow && mf.nComp() == hdr.m_ncomp);
+
+    // ---- the fabs in each file, by offset
+    std::map<std::string, Vector<FabReadLink> > fileExtents;  // ---- [filename, extents]
+    for(int i(0); i < nBoxes; ++i) {
+      fileExtents[hdr.m_fod[i].m_name].push_back(FabReadLink(dm[i], i, hdr.m_fod[i].m_head, hdr.m_ba[i]));
+    }
+    Vector<std::string> fileNames;
+    for(auto &fe : fileExtents) {
+      std::sort(fe.second.begin(), fe.second.end(), [] (const FabReadLink &a, const FabReadLink &b)
+                                                      { return a.fileOffset < b.fileOffset; } );
+      fileNames.push_back(fe.first);
+    }
+    const int nFiles(fileNames.size());
+
+    // ---- the length of a fab on disk.  With fab headers, the fabs in
+    // ---- a file are contiguous and the last one ends at the end of the file.
+    Vector<long> fileSize(nFiles, 0);
+    if( ! noFabHeader) {
+      if(myProc == coordinatorProc) {
+        for(int f(0); f < nFiles; ++f) {
+          std::ifstream ifs((VisMF::DirName(mf_name) + fileNames[f]).c_str(), std::ios::in | std::ios::binary);
+          if( ! ifs.good()) {
+            amrex::FileOpenFailed(VisMF::DirName(mf_name) + fileNames[f]);
+          }
+          ifs.seekg(0, std::ios::end);
+          fileSize[f] = static_cast<std::streamoff>(ifs.tellg());
+        }
+      }
+      ParallelDescriptor::Bcast(fileSize.dataPtr(), fileSize.size(), coordinatorProc);
+    }
+    Vector<long> fabBytes(nBoxes);
+    Vector<long> fileBytes(nFiles, 0);
+    for(int f(0); f < nFiles; ++f) {
+      const Vector<FabReadLink> &frl = fileExtents[fileNames[f]];
+      for(int e(0); e < frl.size(); ++e) {
+        const int i(frl[e].faIndex);
+        if(noFabHeader) {
+          fabBytes[i] = amrex::grow(frl[e].box, hdr.m_ngrow).numPts() * hdr.m_ncomp
+                        * hdr.m_writtenRD.numBytes();
+        } else {
+          fabBytes[i] = ((e+1 < frl.size()) ? frl[e+1].fileOffset : fileSize[f]) - frl[e].fileOffset;
+        }
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(fabBytes[i] > 0 && fabBytes[i] <= std::numeric_limits<int>::max(),
+                                         "VisMF::ReadAggregated:  a fab does not fit in one message");
+        fileBytes[f] += fabBytes[i];
+      }
+    }
+
+    // ---- split the files into ranges of whole fabs, so that a large file
+    // ---- is read by several aggregators, and give the ranges to the
+    // ---- aggregators, largest first to the least loaded one
+    const Vector<int> aggregators(VisMF::Aggregators());  // ---- [rank]
+    std::set<int> aggSet(aggregators.begin(), aggregators.end());
+    const Vector<int> aggRanks(aggSet.begin(), aggSet.end());
+    const int nAgg(aggRanks.size());
+    long totalBytes(0);
+    for(int f(0); f < nFiles; ++f) {
+      totalBytes += fileBytes[f];
+    }
+    const long maxRangeBytes(std::max(aggregatorBufferSize, (totalBytes + 2 * nAgg - 1) / (2 * nAgg)));
+    struct FileRange {
+      int  file;
+      int  eBegin, eEnd;  // ---- fabs [eBegin, eEnd) of the file, in offset order
+      long nBytes;
+    };
+    Vector<FileRange> ranges;
+    for(int f(0); f < nFiles; ++f) {
+      const Vector<FabReadLink> &frl = fileExtents[fileNames[f]];
+      FileRange range = { f, 0, 0, 0 };
+      for(int e(0); e < frl.size(); ++e) {
+        const long nb(fabBytes[frl[e].faIndex]);
+        if(range.eEnd > range.eBegin && range.nBytes + nb > maxRangeBytes) {
+          ranges.push_back(range);
+          range = { f, e, e, 0 };
+        }
+        range.eEnd = e + 1;
+        range.nBytes += nb;
+      }
+      if(range.eEnd > range.eBegin) {
+        ranges.push_back(range);
+      }
+    }
+    const int nRanges(ranges.size());
+    Vector<int> rangeOrder(nRanges);
+    for(int r(0); r < nRanges; ++r) {
+      rangeOrder[r] = r;
+    }
+    std::stable_sort(rangeOrder.begin(), rangeOrder.end(), [&] (int a, int b)
+                                                             { return ranges[a].nBytes > ranges[b].nBytes; } );
+    Vector<long> aggLoad(nAgg, 0);
+    Vector<Vector<int> > aggRanges(nAgg);  // ---- [aggregator, ranges]
+    for(int r : rangeOrder) {
+      const int a(std::min_element(aggLoad.begin(), aggLoad.end()) - aggLoad.begin());
+      aggRanges[a].push_back(r);
+      aggLoad[a] += ranges[r].nBytes;
+    }
+    for(auto &ar : aggRanges) {
+      std::sort(ar.begin(), ar.end());  // ---- file and offset order
+    }
+
+    // ---- a fab with a header is parsed from its bytes, otherwise they
+    // ---- are the data, maybe to be converted
+    auto unpackFab = [&] (int i, char *data) {
+      FArrayBox &fab = mf[i];
+      if(noFabHeader) {
+        if(doConvert) {
+          RealDescriptor::convertToNativeFormat(fab.dataPtr(), fab.box().numPts() * fab.nComp(),
+                                                data, hdr.m_writtenRD);
+        } else {
+          memcpy(fab.dataPtr(), data, fab.nBytes());
+        }
+      } else {
+        MemoryStreamBuf msb(data, fabBytes[i]);
+        std::istream is(&msb);
+        fab.readFrom(is);
+      }
+    };
+
+    // ---- the fabs this rank receives from each aggregator, in the order it sends them
+    const int readTag(ParallelDescriptor::SeqNum());
+    const bool recvInPlace(noFabHeader && ! doConvert);
+    Vector<std::deque<int> > recvQueue(nAgg);  // ---- [aggregator, fabs]
+    for(int a(0); a < nAgg; ++a) {
+      if(aggRanks[a] == myProc) {
+        continue;
+      }
+      for(int r : aggRanges[a]) {
+        const Vector<FabReadLink> &frl = fileExtents[fileNames[ranges[r].file]];
+        for(int e(ranges[r].eBegin); e < ranges[r].eEnd; ++e) {
+          if(frl[e].rankToRead == myProc) {
+            recvQueue[a].push_back(frl[e].faIndex);
+          }
+        }
+      }
+    }
+
+    // ---- the posted receives, in slots whose buffers are reused.  Receives
+    // ---- in place need no buffer and are all posted at once.  Otherwise each
+    // ---- aggregator has one receive posted, and more while the buffered
+    // ---- bytes fit in aggregatorBufferSize.
+    Vector<MPI_Request> recvReqs;                  // ---- [slot]
+    Vector<int> recvFab, recvAgg;                  // ---- [slot]
+    Vector<std::unique_ptr<char[]> > recvBuffers;  // ---- [slot]
+    Vector<long> recvBufferSize;                   // ---- [slot]
+    Vector<int> freeSlots;
+    Vector<int> aggInFlight(nAgg, 0);
+    int nInFlight(0);
+    long bytesInFlight(0);
+
+    auto postRecvs = [&] () {
+      for(int a(0); a < nAgg; ++a) {
+        while( ! recvQueue[a].empty()) {
+          const int i(recvQueue[a].front());
+          if( ! recvInPlace && aggInFlight[a] > 0 && bytesInFlight + fabBytes[i] > aggregatorBufferSize) {
+            break;
+          }
+          recvQueue[a].pop_front();
+          int s;
+          if(freeSlots.empty()) {
+            s = recvReqs.size();
+            recvReqs.push_back(MPI_REQUEST_NULL);
+            recvFab.push_back(-1);
+            recvAgg.push_back(-1);
+            recvBuffers.emplace_back();
+            recvBufferSize.push_back(0);
+          } else {
+            s = freeSlots.back();
+            freeSlots.pop_back();
+          }
+          char *buf;
+          if(recvInPlace) {
+            buf = reinterpret_cast<char *>(mf[i].dataPtr());
+          } else {
+            if(recvBufferSize[s] < fabBytes[i]) {
+              recvBuffers[s].reset(new char[fabBytes[i]]);
+              recvBufferSize[s] = fabBytes[i];
+            }
+            buf = recvBuffers[s].get();
+            bytesInFlight += fabBytes[i];
+          }
+          recvFab[s] = i;
+          recvAgg[s] = a;
+          ++aggInFlight[a];
+          ++nInFlight;
+          BL_MPI_REQUIRE( MPI_Irecv(buf, static_cast<int>(fabBytes[i]), MPI_CHAR,
+                                    aggRanks[a], readTag, comm, &recvReqs[s]) );
+        }
+      }
+    };
+
+    // ---- wait for the sends in sendReqs, or for all the receives if there
+    // ---- are none, while unpacking the fabs received and posting more
+    // ---- receives.  An aggregator waiting for its sends thus keeps
+    // ---- receiving, so the aggregators do not wait for each other.
+    Vector<MPI_Request> waitReqs;
+    Vector<int> doneReqs;
+    auto waitAndReceive = [&] (Vector<MPI_Request> &sendReqs) {
+      const bool untilReceived(sendReqs.empty());
+      while(true) {
+        const bool sending(std::any_of(sendReqs.begin(), sendReqs.end(), [] (const MPI_Request &req)
+                                                                          { return req != MPI_REQUEST_NULL; } ));
+        if( ! sending && ( ! untilReceived || nInFlight == 0)) {
+          break;
+        }
+        const int nRecvSlots(recvReqs.size());
+        waitReqs = recvReqs;
+        waitReqs.insert(waitReqs.end(), sendReqs.begin(), sendReqs.end());
+        doneReqs.resize(waitReqs.size());
+        int nDone(0);
+        BL_MPI_REQUIRE( MPI_Waitsome(static_cast<int>(waitReqs.size()), waitReqs.dataPtr(), &nDone,
+                                     doneReqs.dataPtr(), MPI_STATUSES_IGNORE) );
+        std::copy(waitReqs.begin(), waitReqs.begin() + nRecvSlots, recvReqs.begin());
+        std::copy(waitReqs.begin() + nRecvSlots, waitReqs.end(), sendReqs.begin());
+        for(int k(0); k < nDone; ++k) {
+          const int s(doneReqs[k]);
+          if(s < nRecvSlots) {
+            const int i(recvFab[s]);
+            if( ! recvInPlace) {
+              unpackFab(i, recvBuffers[s].get());
+              bytesInFlight -= fabBytes[i];
+            }
+            --aggInFlight[recvAgg[s]];
+            --nInFlight;
+            recvFab[s] = -1;
+            freeSlots.push_back(s);
+          }
+        }
+        postRecvs();
+      }
+      sendReqs.clear();
+    };
+
+    postRecvs();
+
+    // ---- the aggregators read their ranges in batches of about
+    // ---- aggregatorBufferSize bytes, and send the fabs to their owners
+    const int myAgg(std::find(aggRanks.begin(), aggRanks.end(), myProc) - aggRanks.begin());
+    if(myAgg < nAgg) {
+      std::unique_ptr<char[]> buffers[2];
+      long bufferSize[2] = { 0, 0 };
+      Vector<MPI_Request> sendReqs[2];
+      int whichBuffer(0);
+
+      for(int r : aggRanges[myAgg]) {
+        const FileRange &range = ranges[r];
+        const std::string fullName(VisMF::DirName(mf_name) + fileNames[range.file]);
+        const Vector<FabReadLink> &frl = fileExtents[fileNames[range.file]];
+
+        // ---- whole fabs, at least one per batch
+        Vector<int> batchStart(1, range.eBegin);
+        for(int e(range.eBegin + 1); e < range.eEnd; ++e) {
+          const long end(frl[e].fileOffset + fabBytes[frl[e].faIndex]);
+          if(end - frl[batchStart.back()].fileOffset > aggregatorBufferSize) {
+            batchStart.push_back(e);
+          }
+        }
+        batchStart.push_back(range.eEnd);
+        auto batchBytes = [&] (int b) {
+          const FabReadLink &last = frl[batchStart[b+1] - 1];
+          return last.fileOffset + fabBytes[last.faIndex] - frl[batchStart[b]].fileOffset;
+        };
+
+        const int fd(::open(fullName.c_str(), O_RDONLY));
+        if(fd < 0) {
+          amrex::FileOpenFailed(fullName);
+        }
+#ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise(fd, frl[range.eBegin].fileOffset, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+        for(int b(0); b + 1 < batchStart.size(); ++b) {
+          const int eBegin(batchStart[b]), eEnd(batchStart[b+1]);
+          const long nBytes(batchBytes(b));
+
+#ifdef POSIX_FADV_WILLNEED
+          // ---- the kernel reads the next batch while this one is sent
+          if(b + 2 < batchStart.size()) {
+            posix_fadvise(fd, frl[eEnd].fileOffset, batchBytes(b+1), POSIX_FADV_WILLNEED);
+          }
+#endif
+
+          // ---- this buffer's fabs must have been sent
+          Vector<MPI_Request> &breqs = sendReqs[whichBuffer];
+          if( ! breqs.empty()) {
+            waitAndReceive(breqs);
+          }
+          if(bufferSize[whichBuffer] < nBytes) {
+            buffers[whichBuffer].reset(new char[nBytes]);
+            bufferSize[whichBuffer] = nBytes;
+          }
+          char *buffer = buffers[whichBuffer].get();
+
+          long nRead(0);
+          while(nRead < nBytes) {
+            const ssize_t n(::pread(fd, buffer + nRead, nBytes - nRead,
+                                    frl[eBegin].fileOffset + nRead));
+            if(n < 0 && errno == EINTR) {
+              continue;
+            }
+            if(n <= 0) {
+              amrex::Error("VisMF::ReadAggregated:  error reading " + fullName);
+            }
+            nRead += n;
+          }
+
+          for(int e(eBegin); e < eEnd; ++e) {
+            const int i(frl[e].faIndex);
+            char *fabData = buffer + (frl[e].fileOffset - frl[eBegin].fileOffset);
+            if(frl[e].rankToRead == myProc) {
+              unpackFab(i, fabData);
+            } else {
+              breqs.push_back(MPI_REQUEST_NULL);
+              BL_MPI_REQUIRE( MPI_Isend(fabData, static_cast<int>(fabBytes[i]), MPI_CHAR,
+                                        frl[e].rankToRead, readTag, comm, &breqs.back()) );
+            }
+          }
+          whichBuffer = 1 - whichBuffer;
+        }
+
+        ::close(fd);
+      }
+
+      for(auto &breqs : sendReqs) {
+        if( ! breqs.empty()) {
+          waitAndReceive(breqs);
+        }
+      }
+    }
+
+    Vector<MPI_Request> noSends;
+    waitAndReceive(noSends);
+
+    if(verbose && myProc == coordinatorProc) {
+      amrex::AllPrint() << "VisMF::ReadAggregated:  " << nFiles << " files in " << nRanges
+                        << " ranges, " << nAgg << " aggregators" << std::endl;
+    }
+}
+#endif
+
+
 long
 VisMF::WriteOnlyHeader (const FabArray<FArrayBox> & mf,
                         const std::string         & mf_name,
@@ -1135,7 +1764,7 @@ VisMF::FindOffsets (const FabArray<FArrayBox> &mf,
     Vector<int> nmtags(nProcs,0);
     Vector<int> offset(nProcs,0);
 
-    const Vector<int> &pmap = mf.DistributionMap().ProcessorMap();
+    const DistributionMapping& pmap = mf.DistributionMap();
 
     for(int i(0), N(mf.size()); i < N; ++i) {
         ++nmtags[pmap[i]];
@@ -1479,7 +2108,11 @@ VisMF::Read (FabArray<FArrayBox> &mf,
   int nProcs(ParallelDescriptor::NProcs());
   bool noFabHeader(NoFabHeader(hdr));
 
-  if(noFabHeader && useSynchronousReads) {
+  if(useAggregatedReads && nProcs > 1 && mf.nGrowVect() == hdr.m_ngrow && mf.nComp() == hdr.m_ncomp) {
+
+    VisMF::ReadAggregated(mf, mf_name, hdr, coordinatorProc);
+
+  } else if(noFabHeader && useSynchronousReads) {
 
     // ---- This code is only for reading in file order
     bool doConvert(hdr.m_writtenRD != FPC::NativeRealDescriptor());
@@ -7,23 +7,37 @@
 #include <AMReX_EB2_IF_Sphere.H>
 #include <AMReX_EB2_IF_Torus.H>
 #include <AMReX_EB2_IF_Spline.H>
+#include <AMReX_EB2_IF_STL.H>
 #include <AMReX_EB2_GeometryShop.H>
 #include <AMReX_EB2.H>
 #include <AMReX_ParmParse.H>
+#include <AMReX_Utility.H>
 #include <AMReX.H>
 
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
 namespace amrex { namespace EB2 {
 
 Vector<std::unique_ptr<IndexSpace> > IndexSpace::m_instance;
 
 int max_grid_size = 64;
 bool compare_with_ch_eb = false;
+std::string cache_dir;
+std::string cache_key;
+bool lazy_coarsening = false;
 
 void Initialize ()
 {
     ParmParse pp("eb2");
     pp.query("max_grid_size", max_grid_size);
     pp.query("compare_with_ch_eb", compare_with_ch_eb);
+    pp.query("cache_dir", cache_dir);
+    pp.query("cache_key", cache_key);
+    pp.query("lazy_coarsening", lazy_coarsening);
 
     amrex::ExecOnFinalize(Finalize);
 }
@@ -140,12 +154,182 @@ Build (const Geometry& geom, int required_coarsening_level,
         EB2::Build(gshop, geom, required_coarsening_level,
                    max_coarsening_level, ngrow);
     }
+#if (AMREX_SPACEDIM == 3)
+    else if (geom_type == "stl")
+    {
+        std::string stl_file;
+        pp.get("stl_file", stl_file);
+
+        Real scale = 1.0;
+        pp.query("stl_scale", scale);
+
+        RealArray center {0.0, 0.0, 0.0};
+        pp.query("stl_center", center);
+
+        bool has_fluid_inside = false;
+        pp.query("stl_has_fluid_inside", has_fluid_inside);
+
+        // Only the sign matters away from the surface
+        Real max_distance = 4.0*(*std::max_element(geom.CellSize(),
+                                                   geom.CellSize()+AMREX_SPACEDIM));
+        pp.query("stl_max_distance", max_distance);
+
+        Vector<Real> tri = EB2::STLIF::readSTL(stl_file);
+        for (long i = 0; i < tri.size(); ++i) {
+            tri[i] = tri[i]*scale + center[i%3];
+        }
+
+        EB2::STLIF sf(std::move(tri), has_fluid_inside, max_distance);
+
+        EB2::GeometryShop<EB2::STLIF> gshop(sf);
+        EB2::Build(gshop, geom, required_coarsening_level,
+                   max_coarsening_level, ngrow);
+    }
+#endif
     else
     {
         amrex::Abort("geom_type "+geom_type+ " not supported");
     }
 }
 
+namespace {
+    const char* index_space_version = "EB2_IndexSpace_V2";
+
+    // 64-bit FNV-1a
+    std::string hashBytes (const char* p, std::size_t n)
+    {
+        std::uint64_t h = 14695981039346656037ULL;
+        for (std::size_t i = 0; i < n; ++i) {
+            h ^= static_cast<unsigned char>(p[i]);
+            h *= 1099511628211ULL;
+        }
+        std::ostringstream key;
+        key << std::hex << std::setw(16) << std::setfill('0') << h;
+        return key.str();
+    }
+}
+
+std::string
+digest (const BaseFab<Real>& fab)
+{
+    return hashBytes(reinterpret_cast<const char*>(fab.dataPtr()),
+                     fab.nBytes());
+}
+
+std::string
+cacheKey (const Geometry& geom, int required_coarsening_level,
+          int max_coarsening_level, int ngrow, const std::string& geom_digest)
+{
+    std::ostringstream os;
+    os << std::setprecision(17)
+       << AMREX_SPACEDIM << " " << geom.Domain() << " " << geom.ProbDomain() << " "
+       << AMREX_D_TERM(Geometry::isPeriodic(0), << Geometry::isPeriodic(1), << Geometry::isPeriodic(2))
+       << " " << required_coarsening_level << " "
+       << max_coarsening_level << " " << ngrow << " " << EB2::max_grid_size << " "
+       << geom_digest << " " << cache_key << "\n";
+
+    std::ostringstream table;
+    ParmParse::dumpTable(table);
+    std::istringstream is(table.str());
+    std::string line;
+    while (std::getline(is, line)) {
+        // these do not change the index space that is written
+        if (line.compare(0, 4, "eb2.") == 0 && line.compare(0, 13, "eb2.cache_dir") != 0
+                                            && line.compare(0, 19, "eb2.lazy_coarsening") != 0) {
+            os << line << "\n";
+        }
+    }
+
+    const std::string& s = os.str();
+    return hashBytes(s.data(), s.size());
+}
+
+bool
+cacheMatches (const std::string& dir, const std::string& key)
+{
+    Vector<char> buf;
+    ParallelDescriptor::ReadAndBcastFile(dir+"/Header", buf, false);
+    if (buf.empty()) return false;
+
+    std::istringstream is(buf.dataPtr(), std::istringstream::in);
+    std::string version, file_key;
+    is >> version >> file_key;
+    return version == index_space_version && file_key == key;
+}
+
+void
+IndexSpace::write (const std::string& dir, const std::string& key) const
+{
+    BL_PROFILE("EB2::IndexSpace::write()");
+
+    if (ParallelDescriptor::IOProcessor()) {
+        if (!amrex::UtilCreateDirectory(dir, 0755)) {
+            amrex::CreateDirectoryFailed(dir);
+        }
+        // Invalidate an old cache until the new one is complete
+        std::remove((dir+"/Header").c_str());
+    }
+    ParallelDescriptor::Barrier();
+
+    const int nlevels = numLevels();
+    for (int ilev = 0; ilev < nlevels; ++ilev) {
+        levelAt(ilev).write(dir+"/Level_"+std::to_string(ilev));
+    }
+
+    ParallelDescriptor::Barrier();
+    if (ParallelDescriptor::IOProcessor()) {
+        std::ofstream os((dir+"/Header").c_str());
+        os << index_space_version << "\n" << key << "\n" << nlevels << "\n";
+        for (int ilev = 0; ilev < nlevels; ++ilev) {
+            os << levelAt(ilev).Geom().Domain() << "\n";
+        }
+        if (!os.good()) {
+            amrex::FileOpenFailed(dir+"/Header");
+        }
+    }
+}
+
+IndexSpaceFile::IndexSpaceFile (const std::string& dir, const Geometry& geom)
+{
+    BL_PROFILE("EB2::IndexSpaceFile()");
+
+    Vector<char> buf;
+    ParallelDescriptor::ReadAndBcastFile(dir+"/Header", buf);
+    std::istringstream is(buf.dataPtr(), std::istringstream::in);
+    std::string version, key;
+    int nlevels;
+    is >> version >> key >> nlevels;
+
+    m_level.reserve(nlevels);
+    for (int ilev = 0; ilev < nlevels; ++ilev) {
+        Box domain;
+        is >> domain;
+        if (ilev == 0) {
+            AMREX_ALWAYS_ASSERT_WITH_MESSAGE(domain == geom.Domain(),
+                                             "IndexSpaceFile: domain does not match");
+            m_geom.push_back(geom);
+        } else {
+            m_geom.push_back(Geometry(domain));
+        }
+        m_domain.push_back(domain);
+        m_level.emplace_back(this, m_geom.back(), dir+"/Level_"+std::to_string(ilev));
+    }
+}
+
+const Level&
+IndexSpaceFile::getLevel (const Geometry& geom) const
+{
+    auto it = std::find(std::begin(m_domain), std::end(m_domain), geom.Domain());
+    if (it == m_domain.end()) {
+        std::ostringstream os;
+        os << "IndexSpaceFile: no EB level for domain " << geom.Domain()
+           << "; the coarsest is " << m_domain.back();
+        amrex::Abort(os.str());
+    }
+    int i = std::distance(m_domain.begin(), it);
+    return m_level[i];
+}
+
 namespace {
 static int comp_max_crse_level (Box cdomain, const Box& domain)
 {
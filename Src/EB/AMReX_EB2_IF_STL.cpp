@@ -0,0 +1,458 @@
+
+#include <AMReX_EB2_IF_STL.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_Print.H>
+#include <AMReX_BLProfiler.H>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+namespace amrex { namespace EB2 {
+
+#if (AMREX_SPACEDIM == 3)
+
+namespace {
+
+    inline Real dot (const Real* a, const Real* b) {
+        return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+    }
+
+    inline void sub (const Real* a, const Real* b, Real* c) {
+        c[0] = a[0]-b[0];  c[1] = a[1]-b[1];  c[2] = a[2]-b[2];
+    }
+
+    inline void cross (const Real* a, const Real* b, Real* c) {
+        c[0] = a[1]*b[2] - a[2]*b[1];
+        c[1] = a[2]*b[0] - a[0]*b[2];
+        c[2] = a[0]*b[1] - a[1]*b[0];
+    }
+
+    // Squared distance from p to triangle (a,b,c) (Ericson, Real-Time
+    // Collision Detection, 5.1.5)
+    Real pointTriangleDist2 (const Real* p, const Real* a, const Real* b, const Real* c)
+    {
+        Real ab[3], ac[3], ap[3], q[3];
+        sub(b, a, ab);  sub(c, a, ac);  sub(p, a, ap);
+
+        const Real d1 = dot(ab,ap), d2 = dot(ac,ap);
+        if (d1 <= 0.0 && d2 <= 0.0) {
+            q[0] = a[0];  q[1] = a[1];  q[2] = a[2];
+        } else {
+            Real bp[3];  sub(p, b, bp);
+            const Real d3 = dot(ab,bp), d4 = dot(ac,bp);
+            Real cp[3];  sub(p, c, cp);
+            const Real d5 = dot(ab,cp), d6 = dot(ac,cp);
+            const Real vc = d1*d4 - d3*d2;
+            const Real vb = d5*d2 - d1*d6;
+            const Real va = d3*d6 - d5*d4;
+            if (d3 >= 0.0 && d4 <= d3) {
+                q[0] = b[0];  q[1] = b[1];  q[2] = b[2];
+            } else if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) {
+                const Real v = d1 / (d1-d3);
+                for (int i = 0; i < 3; ++i) q[i] = a[i] + v*ab[i];
+            } else if (d6 >= 0.0 && d5 <= d6) {
+                q[0] = c[0];  q[1] = c[1];  q[2] = c[2];
+            } else if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) {
+                const Real w = d2 / (d2-d6);
+                for (int i = 0; i < 3; ++i) q[i] = a[i] + w*ac[i];
+            } else if (va <= 0.0 && (d4-d3) >= 0.0 && (d5-d6) >= 0.0) {
+                const Real w = (d4-d3) / ((d4-d3) + (d5-d6));
+                for (int i = 0; i < 3; ++i) q[i] = b[i] + w*(c[i]-b[i]);
+            } else {
+                const Real denom = 1.0 / (va+vb+vc);
+                const Real v = vb*denom, w = vc*denom;
+                for (int i = 0; i < 3; ++i) q[i] = a[i] + ab[i]*v + ac[i]*w;
+            }
+        }
+
+        Real pq[3];
+        sub(p, q, pq);
+        return dot(pq,pq);
+    }
+
+    // Does the ray p + t*d, t > 0, cross triangle (a,b,c)? (Moller-Trumbore)
+    bool rayTriangle (const Real* p, const Real* d, const Real* a, const Real* b, const Real* c)
+    {
+        Real e1[3], e2[3], h[3], s[3], q[3];
+        sub(b, a, e1);  sub(c, a, e2);
+        cross(d, e2, h);
+        const Real det = dot(e1,h);
+        if (det == 0.0) return false;
+        const Real inv = 1.0/det;
+        sub(p, a, s);
+        const Real u = inv*dot(s,h);
+        if (u < 0.0 || u > 1.0) return false;
+        cross(s, e1, q);
+        const Real v = inv*dot(d,q);
+        if (v < 0.0 || u+v > 1.0) return false;
+        return inv*dot(e2,q) > 0.0;
+    }
+
+    // Generic directions, so that rays rarely hit edges or vertices exactly
+    const Real ray_dir[3][3] = { { 0.8017837257372732,  0.5345224838248488,  0.2672612419124244},
+                                 {-0.3015113445777636,  0.9045340337332909, -0.3015113445777636},
+                                 { 0.2357022603955158, -0.4714045207910317,  0.8498365855987975} };
+}
+
+class STLIF::BVH
+{
+public:
+
+    explicit BVH (Vector<Real>&& a_tri);
+
+    int numTriangles () const { return m_ntri; }
+
+    //! Squared distance to the nearest triangle, or max_dist2 if there is
+    //! none closer
+    Real distance2 (const Real* p, Real max_dist2) const;
+    bool inside (const Real* p) const;
+    bool overlaps (const Real* lo, const Real* hi) const;
+
+    const Real* lo () const { return m_nodes[0].lo; }
+    const Real* hi () const { return m_nodes[0].hi; }
+
+private:
+
+    // Internal nodes have count == 0, their children are the next node and
+    // node "right".  Leaves hold the triangles start .. start+count-1.
+    struct Node
+    {
+        Real lo[3];
+        Real hi[3];
+        int  start = 0;
+        int  count = 0;
+        int  right = 0;
+    };
+
+    static constexpr int leaf_size = 4;
+    static constexpr int max_depth = 128;
+
+    int build (Vector<int>& ids, const Vector<Real>& centroid, int begin, int end);
+
+    int rayCrossings (const Real* p, const Real* d) const;
+
+    Real boxDist2 (const Node& node, const Real* p) const {
+        Real r = 0.0;
+        for (int i = 0; i < 3; ++i) {
+            const Real e = std::max(std::max(node.lo[i]-p[i], p[i]-node.hi[i]), Real(0.0));
+            r += e*e;
+        }
+        return r;
+    }
+
+    const Real* tri (int i) const { return &m_tri[9*i]; }
+
+    int          m_ntri;
+    Vector<Real> m_tri;
+    Vector<Node> m_nodes;
+};
+
+STLIF::BVH::BVH (Vector<Real>&& a_tri)
+    : m_ntri(a_tri.size()/9),
+      m_tri(std::move(a_tri))
+{
+    BL_PROFILE("EB2::STLIF::BVH()");
+
+    if (m_ntri == 0) {
+        amrex::Abort("STLIF: no triangles");
+    }
+
+    Vector<Real> centroid(3*m_ntri);
+    for (int i = 0; i < m_ntri; ++i) {
+        const Real* t = tri(i);
+        for (int d = 0; d < 3; ++d) {
+            centroid[3*i+d] = (t[d] + t[3+d] + t[6+d]) * (1./3.);
+        }
+    }
+
+    Vector<int> ids(m_ntri);
+    std::iota(ids.begin(), ids.end(), 0);
+
+    m_nodes.reserve(2*(m_ntri/leaf_size+1));
+    build(ids, centroid, 0, m_ntri);
+
+    // Store the triangles in leaf order
+    Vector<Real> sorted(m_tri.size());
+    for (int i = 0; i < m_ntri; ++i) {
+        std::memcpy(&sorted[9*i], tri(ids[i]), 9*sizeof(Real));
+    }
+    m_tri.swap(sorted);
+}
+
+int
+STLIF::BVH::build (Vector<int>& ids, const Vector<Real>& centroid, int begin, int end)
+{
+    const int inode = m_nodes.size();
+    m_nodes.emplace_back();
+
+    Node node;
+    Real clo[3], chi[3];
+    for (int d = 0; d < 3; ++d) {
+        node.lo[d] = clo[d] = std::numeric_limits<Real>::max();
+        node.hi[d] = chi[d] = std::numeric_limits<Real>::lowest();
+    }
+    for (int n = begin; n < end; ++n) {
+        const Real* t = tri(ids[n]);
+        for (int d = 0; d < 3; ++d) {
+            node.lo[d] = std::min({node.lo[d], t[d], t[3+d], t[6+d]});
+            node.hi[d] = std::max({node.hi[d], t[d], t[3+d], t[6+d]});
+            clo[d] = std::min(clo[d], centroid[3*ids[n]+d]);
+            chi[d] = std::max(chi[d], centroid[3*ids[n]+d]);
+        }
+    }
+
+    int dir = 0;
+    for (int d = 1; d < 3; ++d) {
+        if (chi[d]-clo[d] > chi[dir]-clo[dir]) dir = d;
+    }
+
+    if (end-begin <= leaf_size || chi[dir] == clo[dir]) {
+        node.start = begin;
+        node.count = end-begin;
+    } else {
+        // Median split along the longest extent of the centroids
+        const int mid = (begin+end)/2;
+        std::nth_element(ids.begin()+begin, ids.begin()+mid, ids.begin()+end,
+                         [&] (int a, int b) { return centroid[3*a+dir] < centroid[3*b+dir]; });
+        build(ids, centroid, begin, mid);
+        node.right = build(ids, centroid, mid, end);
+    }
+
+    m_nodes[inode] = node;
+    return inode;
+}
+
+Real
+STLIF::BVH::distance2 (const Real* p, Real max_dist2) const
+{
+    Real best = max_dist2;
+
+    int stack[max_depth];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const Node& node = m_nodes[stack[--top]];
+        if (boxDist2(node, p) >= best) continue;
+
+        if (node.count > 0) {
+            for (int i = node.start; i < node.start+node.count; ++i) {
+                const Real* t = tri(i);
+                best = std::min(best, pointTriangleDist2(p, t, t+3, t+6));
+            }
+        } else {
+            // Visit the nearer child first
+            const int left = &node - m_nodes.data() + 1;
+            const Real dl = boxDist2(m_nodes[left], p);
+            const Real dr = boxDist2(m_nodes[node.right], p);
+            if (dl < dr) {
+                if (dr < best) stack[top++] = node.right;
+                if (dl < best) stack[top++] = left;
+            } else {
+                if (dl < best) stack[top++] = left;
+                if (dr < best) stack[top++] = node.right;
+            }
+        }
+    }
+
+    return best;
+}
+
+int
+STLIF::BVH::rayCrossings (const Real* p, const Real* d) const
+{
+    int ncross = 0;
+
+    int stack[max_depth];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const Node& node = m_nodes[stack[--top]];
+
+        // Slab test for t >= 0
+        Real tmin = 0.0, tmax = std::numeric_limits<Real>::max();
+        bool hit = true;
+        for (int i = 0; i < 3 && hit; ++i) {
+            if (d[i] == 0.0) {
+                hit = (p[i] >= node.lo[i] && p[i] <= node.hi[i]);
+            } else {
+                const Real inv = 1.0/d[i];
+                Real t0 = (node.lo[i]-p[i])*inv;
+                Real t1 = (node.hi[i]-p[i])*inv;
+                if (t0 > t1) std::swap(t0,t1);
+                tmin = std::max(tmin, t0);
+                tmax = std::min(tmax, t1);
+                hit = (tmin <= tmax);
+            }
+        }
+        if (!hit) continue;
+
+        if (node.count > 0) {
+            for (int i = node.start; i < node.start+node.count; ++i) {
+                const Real* t = tri(i);
+                if (rayTriangle(p, d, t, t+3, t+6)) ++ncross;
+            }
+        } else {
+            stack[top++] = node.right;
+            stack[top++] = &node - m_nodes.data() + 1;
+        }
+    }
+
+    return ncross;
+}
+
+bool
+STLIF::BVH::inside (const Real* p) const
+{
+    for (int i = 0; i < 3; ++i) {
+        if (p[i] < lo()[i] || p[i] > hi()[i]) return false;
+    }
+
+    int nodd = 0;
+    for (int r = 0; r < 3; ++r) {
+        if (rayCrossings(p, ray_dir[r]) % 2 == 1) ++nodd;
+        if (nodd == 2 || (r == 1 && nodd == 0)) break;
+    }
+    return nodd >= 2;
+}
+
+bool
+STLIF::BVH::overlaps (const Real* lo, const Real* hi) const
+{
+    int stack[max_depth];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const Node& node = m_nodes[stack[--top]];
+
+        bool hit = true;
+        for (int i = 0; i < 3; ++i) {
+            hit = hit && (node.lo[i] <= hi[i] && node.hi[i] >= lo[i]);
+        }
+        if (!hit) continue;
+
+        if (node.count > 0) {
+            for (int n = node.start; n < node.start+node.count; ++n) {
+                const Real* t = tri(n);
+                bool thit = true;
+                for (int i = 0; i < 3; ++i) {
+                    thit = thit && std::min({t[i],t[3+i],t[6+i]}) <= hi[i]
+                                && std::max({t[i],t[3+i],t[6+i]}) >= lo[i];
+                }
+                if (thit) return true;
+            }
+        } else {
+            stack[top++] = node.right;
+            stack[top++] = &node - m_nodes.data() + 1;
+        }
+    }
+
+    return false;
+}
+
+STLIF::STLIF (const std::string& a_filename, bool a_inside, Real a_max_distance)
+    : STLIF(readSTL(a_filename), a_inside, a_max_distance)
+{}
+
+STLIF::STLIF (Vector<Real> a_triangles, bool a_inside, Real a_max_distance)
+    : m_bvh(std::make_shared<BVH>(std::move(a_triangles))),
+      m_sign(a_inside ? -1.0 : 1.0),
+      m_max_dist2(a_max_distance < std::sqrt(std::numeric_limits<Real>::max())
+                  ? a_max_distance*a_max_distance : std::numeric_limits<Real>::max())
+{}
+
+Real
+STLIF::operator() (const RealArray& p) const
+{
+    const Real d2 = m_bvh->distance2(p.data(), m_max_dist2);
+    if (d2 == 0.0) return 0.0;
+    const Real d = std::sqrt(d2);
+    return m_bvh->inside(p.data()) ? m_sign*d : -m_sign*d;
+}
+
+IFInterval
+STLIF::bound (const RealArray& lo, const RealArray& hi) const
+{
+    if (m_bvh->overlaps(lo.data(), hi.data())) {
+        return IFInterval::unbounded();
+    }
+
+    // The surface does not touch the box, so the sign is constant over it.
+    RealArray center {0.5*(lo[0]+hi[0]), 0.5*(lo[1]+hi[1]), 0.5*(lo[2]+hi[2])};
+    const Real s = m_bvh->inside(center.data()) ? m_sign : -m_sign;
+    return IFInterval{std::numeric_limits<Real>::min(),
+                      std::numeric_limits<Real>::max()} * s;
+}
+
+int
+STLIF::numTriangles () const
+{
+    return m_bvh->numTriangles();
+}
+
+RealArray
+STLIF::surfaceLo () const
+{
+    return RealArray{m_bvh->lo()[0], m_bvh->lo()[1], m_bvh->lo()[2]};
+}
+
+RealArray
+STLIF::surfaceHi () const
+{
+    return RealArray{m_bvh->hi()[0], m_bvh->hi()[1], m_bvh->hi()[2]};
+}
+
+Vector<Real>
+STLIF::readSTL (const std::string& a_filename)
+{
+    BL_PROFILE("EB2::STLIF::readSTL()");
+
+    Vector<char> buf;
+    ParallelDescriptor::ReadAndBcastFile(a_filename, buf);
+    const long len = buf.size()-1;   // ReadAndBcastFile appends '\0'
+
+    Vector<Real> tri;
+
+    // Binary: 80 byte header, uint32 count, 50 bytes per triangle
+    std::uint32_t nbin = 0;
+    if (len >= 84) {
+        std::memcpy(&nbin, buf.data()+80, sizeof(nbin));
+    }
+    if (len >= 84 && len == 84 + 50*long(nbin)) {
+        tri.resize(9*long(nbin));
+        for (long i = 0; i < nbin; ++i) {
+            float v[9];
+            std::memcpy(v, buf.data() + 84 + 50*i + 12, sizeof(v));   // skip the normal
+            for (int j = 0; j < 9; ++j) tri[9*i+j] = v[j];
+        }
+    } else {
+        // ASCII: collect the coordinates following each "vertex" keyword
+        const char* s = buf.data();
+        const char* end = buf.data() + len;
+        while ((s = std::strstr(s, "vertex")) != nullptr && s < end) {
+            s += 6;
+            for (int j = 0; j < 3; ++j) {
+                char* next;
+                tri.push_back(std::strtod(s, &next));
+                if (next == s) amrex::Abort("STLIF: error reading "+a_filename);
+                s = next;
+            }
+        }
+        if (tri.size() % 9 != 0) amrex::Abort("STLIF: error reading "+a_filename);
+    }
+
+    amrex::Print() << "STLIF: read " << tri.size()/9 << " triangles from " << a_filename << "\n";
+
+    return tri;
+}
+
+#endif
+
+}}
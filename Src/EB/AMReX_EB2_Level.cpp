@@ -1,7 +1,11 @@
 
 #include <AMReX_EB2_Level.H>
 #include <AMReX_IArrayBox.H>
+#include <AMReX_Utility.H>
 #include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
 
 namespace amrex { namespace EB2 {
 
@@ -154,15 +158,28 @@ Level::coarsenFromFine (Level& fineLevel, bool fill_boundary)
     {
         const Geometry& fine_geom = fineLevel.m_geom;
         const auto& fine_period = fine_geom.periodicity();
-        f_cellflag.FillBoundary(fine_period);
-        f_volfrac.FillBoundary(fine_period);
-        f_centroid.FillBoundary(fine_period);
-        f_bndryarea.FillBoundary(fine_period);
-        f_bndrycent.FillBoundary(fine_period);
-        f_bndrynorm.FillBoundary(fine_period);
+        // Post the messages of all the data before waiting on any, so
+        // that there is one round of communication instead of one per
+        // MultiFab.
+        f_cellflag.FillBoundary_nowait(fine_period);
+        f_volfrac.FillBoundary_nowait(fine_period);
+        f_centroid.FillBoundary_nowait(fine_period);
+        f_bndryarea.FillBoundary_nowait(fine_period);
+        f_bndrycent.FillBoundary_nowait(fine_period);
+        f_bndrynorm.FillBoundary_nowait(fine_period);
         for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
-            f_areafrac[idim].FillBoundary(fine_period);
-            f_facecent[idim].FillBoundary(fine_period);
+            f_areafrac[idim].FillBoundary_nowait(fine_period);
+            f_facecent[idim].FillBoundary_nowait(fine_period);
+        }
+        f_cellflag.FillBoundary_finish();
+        f_volfrac.FillBoundary_finish();
+        f_centroid.FillBoundary_finish();
+        f_bndryarea.FillBoundary_finish();
+        f_bndrycent.FillBoundary_finish();
+        f_bndrynorm.FillBoundary_finish();
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+            f_areafrac[idim].FillBoundary_finish();
+            f_facecent[idim].FillBoundary_finish();
         }
 
         if (!fine_covered_grids.empty())
@@ -279,7 +296,10 @@ void
 Level::buildCellFlag ()
 {
     for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
-        m_areafrac[idim].FillBoundary(0,1,{AMREX_D_DECL(1,1,1)},m_geom.periodicity());
+        m_areafrac[idim].FillBoundary_nowait(0,1,{AMREX_D_DECL(1,1,1)},m_geom.periodicity());
+    }
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+        m_areafrac[idim].FillBoundary_finish();
     }
 
 #ifdef _OPENMP
@@ -665,4 +685,120 @@ Level::fillLevelSet (MultiFab& levelset, const Geometry& geom) const
     }
 }
         
+void
+Level::write (const std::string& dir) const
+{
+    BL_PROFILE("EB2::Level::write()");
+
+    if (ParallelDescriptor::IOProcessor()) {
+        if (!amrex::UtilCreateDirectory(dir, 0755)) {
+            amrex::CreateDirectoryFailed(dir);
+        }
+        std::ofstream os((dir+"/LevelHeader").c_str());
+        os << m_allregular << " " << m_ok << " " << m_volfrac.nGrow()
+           << " " << m_levelset.nGrow() << "\n"
+           << m_ngrow << "\n";
+        m_grids.writeOn(os);
+        // BoxArray::readFrom cannot read an empty BoxArray
+        os << "\n" << m_covered_grids.size() << "\n";
+        if (!m_covered_grids.empty()) {
+            m_covered_grids.writeOn(os);
+            os << "\n";
+        }
+        if (!os.good()) {
+            amrex::FileOpenFailed(dir+"/LevelHeader");
+        }
+    }
+    ParallelDescriptor::Barrier();
+
+    if (m_allregular) return;
+
+    VisMF::Write(m_levelset, dir+"/levelset");
+
+    // The 32-bit cell flags are stored as their low and high 16 bits,
+    // which are exact as Reals of any precision and in any output format.
+    MultiFab flag(m_grids, m_dmap, 2, m_cellflag.nGrow());
+    for (MFIter mfi(flag); mfi.isValid(); ++mfi) {
+        const EBCellFlag* src = m_cellflag[mfi].dataPtr();
+        Real* lo = flag[mfi].dataPtr(0);
+        Real* hi = flag[mfi].dataPtr(1);
+        const long n = flag[mfi].box().numPts();
+        for (long i = 0; i < n; ++i) {
+            std::uint32_t v;
+            std::memcpy(&v, src+i, sizeof(v));
+            lo[i] = v & 0xffffu;
+            hi[i] = v >> 16;
+        }
+    }
+    VisMF::Write(flag, dir+"/cellflag");
+
+    VisMF::Write(m_volfrac,   dir+"/volfrac");
+    VisMF::Write(m_centroid,  dir+"/centroid");
+    VisMF::Write(m_bndryarea, dir+"/bndryarea");
+    VisMF::Write(m_bndrycent, dir+"/bndrycent");
+    VisMF::Write(m_bndrynorm, dir+"/bndrynorm");
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+        VisMF::Write(m_areafrac[idim], dir+"/areafrac_"+std::to_string(idim));
+        VisMF::Write(m_facecent[idim], dir+"/facecent_"+std::to_string(idim));
+    }
+}
+
+void
+Level::read (const std::string& dir)
+{
+    BL_PROFILE("EB2::Level::read()");
+
+    int ng = 0, ng_ls = 0;
+    {
+        Vector<char> buf;
+        ParallelDescriptor::ReadAndBcastFile(dir+"/LevelHeader", buf);
+        std::istringstream is(buf.dataPtr(), std::istringstream::in);
+        is >> m_allregular >> m_ok >> ng >> ng_ls >> m_ngrow;
+        m_grids.readFrom(is);
+        int ncovered = 0;
+        is >> ncovered;
+        if (ncovered > 0) {
+            m_covered_grids.readFrom(is);
+        }
+    }
+
+    if (m_allregular) return;
+
+    m_dmap = DistributionMapping(m_grids);
+
+    auto read_mf = [&] (MultiFab& mf, const BoxArray& ba, int ncomp, int ngrow,
+                        const std::string& name)
+    {
+        mf.define(ba, m_dmap, ncomp, ngrow);
+        VisMF::Read(mf, dir+"/"+name);
+    };
+
+    read_mf(m_levelset, amrex::convert(m_grids,IntVect::TheNodeVector()), 1, ng_ls, "levelset");
+
+    MultiFab flag;
+    read_mf(flag, m_grids, 2, ng, "cellflag");
+    m_cellflag.define(m_grids, m_dmap, 1, ng);
+    for (MFIter mfi(flag); mfi.isValid(); ++mfi) {
+        const Real* lo = flag[mfi].dataPtr(0);
+        const Real* hi = flag[mfi].dataPtr(1);
+        EBCellFlag* dst = m_cellflag[mfi].dataPtr();
+        const long n = flag[mfi].box().numPts();
+        for (long i = 0; i < n; ++i) {
+            dst[i] = static_cast<std::uint32_t>(lo[i])
+                  | (static_cast<std::uint32_t>(hi[i]) << 16);
+        }
+    }
+
+    read_mf(m_volfrac,   m_grids, 1,              ng, "volfrac");
+    read_mf(m_centroid,  m_grids, AMREX_SPACEDIM, ng, "centroid");
+    read_mf(m_bndryarea, m_grids, 1,              ng, "bndryarea");
+    read_mf(m_bndrycent, m_grids, AMREX_SPACEDIM, ng, "bndrycent");
+    read_mf(m_bndrynorm, m_grids, AMREX_SPACEDIM, ng, "bndrynorm");
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+        const BoxArray& fba = amrex::convert(m_grids, IntVect::TheDimensionVector(idim));
+        read_mf(m_areafrac[idim], fba, 1,                ng, "areafrac_"+std::to_string(idim));
+        read_mf(m_facecent[idim], fba, AMREX_SPACEDIM-1, ng, "facecent_"+std::to_string(idim));
+    }
+}
+
 }}
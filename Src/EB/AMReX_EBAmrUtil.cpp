@@ -3,6 +3,9 @@
 #include <AMReX_EBAmrUtil_F.H>
 #include <AMReX_EBFArrayBox.H>
 #include <AMReX_EBCellFlag.H>
+#include <AMReX_EBCellFlag_F.H>
+#include <AMReX_EB2_Level.H>
+#include <AMReX_ParmParse.H>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -40,4 +43,121 @@ TagCutCells (TagBoxArray& tags, const MultiFab& state)
     }
 }
 
+namespace {
+
+// Number of regular, cut and covered cells of every box of flags
+Vector<Real>
+count_cells (const FabArray<EBCellFlagFab>& flags)
+{
+    const int nboxes = flags.size();
+    Vector<Real> counts(3*nboxes, 0.0);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(flags); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.validbox();
+        const auto& flag = flags[mfi];
+        Real* c = counts.data() + 3*mfi.index();
+        if (flag.getType() == FabType::regular) {
+            c[0] = bx.d_numPts();
+        } else if (flag.getType() == FabType::covered) {
+            c[2] = bx.d_numPts();
+        } else {
+            int nregular, nsingle, nmulti, ncovered;
+            amrex_ebcellflag_count(BL_TO_FORTRAN_BOX(bx),
+                                   BL_TO_FORTRAN_ANYD(flag),
+                                   &nregular, &nsingle, &nmulti, &ncovered);
+            c[0] = nregular;
+            c[1] = nsingle + nmulti;
+            c[2] = ncovered;
+        }
+    }
+
+    ParallelAllReduce::Sum(counts.data(), counts.size(), ParallelContext::CommunicatorSub());
+
+    return counts;
+}
+
+Vector<Real>
+count_cells (const EB2::Level& eb_level, const Geometry& geom, const BoxArray& ba)
+{
+    const BoxArray& cba = amrex::convert(ba, IntVect::TheZeroVector());
+    FabArray<EBCellFlagFab> flags(cba, DistributionMapping(cba), 1, 0, MFInfo(),
+                                  DefaultFabFactory<EBCellFlagFab>());
+    eb_level.fillEBCellFlag(flags, geom);
+    return count_cells(flags);
+}
+
+Vector<Real>
+cost_from_counts (const Vector<Real>& counts, const EBCostWeights& w)
+{
+    const int nboxes = counts.size()/3;
+    Vector<Real> cost(nboxes);
+    for (int i = 0; i < nboxes; ++i) {
+        cost[i] = w.regular*counts[3*i] + w.cut*counts[3*i+1] + w.covered*counts[3*i+2];
+    }
+    return cost;
+}
+
+}
+
+EBCostWeights
+EBCostWeights::fromParmParse ()
+{
+    EBCostWeights w;
+    ParmParse pp("eb_cost");
+    pp.query("regular", w.regular);
+    pp.query("cut", w.cut);
+    pp.query("covered", w.covered);
+    return w;
+}
+
+Vector<Real>
+EBCost (const FabArray<EBCellFlagFab>& flags, const EBCostWeights& w)
+{
+    BL_PROFILE("EBCost()");
+    return cost_from_counts(count_cells(flags), w);
+}
+
+Vector<Real>
+EBCost (const EB2::Level& eb_level, const Geometry& geom, const BoxArray& ba,
+        const EBCostWeights& w)
+{
+    BL_PROFILE("EBCost()");
+    return cost_from_counts(count_cells(eb_level, geom, ba), w);
+}
+
+DistributionMapping
+makeEBDistributionMap (const EB2::Level& eb_level, const Geometry& geom, const BoxArray& ba,
+                       const EBCostWeights& w)
+{
+    BL_PROFILE("makeEBDistributionMap()");
+
+    const Vector<Real>& cost = EBCost(eb_level, geom, ba, w);
+    if (DistributionMapping::strategy() == DistributionMapping::KNAPSACK) {
+        return DistributionMapping::makeKnapSack(cost);
+    } else {
+        return DistributionMapping::makeSFC(cost, ba);
+    }
+}
+
+BoxArray
+removeCoveredBoxes (const EB2::Level& eb_level, const Geometry& geom, const BoxArray& ba)
+{
+    BL_PROFILE("removeCoveredBoxes()");
+
+    const Vector<Real>& counts = count_cells(eb_level, geom, ba);
+
+    BoxList bl(ba.ixType());
+    const int nboxes = ba.size();
+    for (int i = 0; i < nboxes; ++i) {
+        if (counts[3*i] + counts[3*i+1] > 0.0) {
+            bl.push_back(ba[i]);
+        }
+    }
+    return BoxArray(std::move(bl));
+}
+
 }
@@ -0,0 +1,82 @@
+
+#include <AMReX_EBCutCellList.H>
+#include <AMReX_FArrayBox.H>
+
+namespace amrex {
+
+void
+EBCutCellList::define (const EBCellFlagFab& flag)
+{
+    m_box = flag.box();
+    m_cut.clear();
+    m_covered.clear();
+    m_vfrac.clear();
+    m_barea.clear();
+    m_bcent.clear();
+    m_bnorm.clear();
+
+    if (flag.getType() != FabType::singlevalued) return;
+
+    const Box& bx = m_box;
+    const int ilo = bx.smallEnd(0);
+    const int ihi = bx.bigEnd(0);
+    Box rows = bx;
+    rows.setBig(0, ilo);
+    for (IntVect iv = rows.smallEnd(); iv <= rows.bigEnd(); rows.next(iv))
+    {
+        IntVect row = iv;
+        int run_start = ihi+1;
+        for (int i = ilo; i <= ihi; ++i)
+        {
+            row[0] = i;
+            const EBCellFlag& f = flag(row);
+            if (f.isCovered()) {
+                if (run_start > ihi) run_start = i;
+                continue;
+            }
+            if (run_start <= ihi) {
+                IntVect lo = row;
+                lo[0] = run_start;
+                m_covered.push_back(EBCellRun{lo, i-run_start});
+                run_start = ihi+1;
+            }
+            if (f.isSingleValued()) {
+                m_cut.push_back(row);
+            }
+        }
+        if (run_start <= ihi) {
+            IntVect lo = row;
+            lo[0] = run_start;
+            m_covered.push_back(EBCellRun{lo, ihi+1-run_start});
+        }
+    }
+}
+
+void
+EBCutCellList::gather (const FArrayBox* vfrac, const FArrayBox* bndryarea,
+                       const FArrayBox* bndrycent, const FArrayBox* bndrynorm)
+{
+    const int n = numCutCells();
+    if (n == 0) return;
+
+    auto gather_comps = [&] (const FArrayBox* fab, int ncomp, Vector<Real>& v)
+    {
+        if (fab == nullptr) return;
+        const Box& fbx = fab->box();
+        v.resize(n*ncomp);
+        for (int comp = 0; comp < ncomp; ++comp) {
+            Real* AMREX_RESTRICT p = v.data() + comp*n;
+            for (int i = 0; i < n; ++i) {
+                // the data may have fewer ghost cells than the flags
+                p[i] = fbx.contains(m_cut[i]) ? (*fab)(m_cut[i], comp) : 0.0;
+            }
+        }
+    };
+
+    gather_comps(vfrac, 1, m_vfrac);
+    gather_comps(bndryarea, 1, m_barea);
+    gather_comps(bndrycent, AMREX_SPACEDIM, m_bcent);
+    gather_comps(bndrynorm, AMREX_SPACEDIM, m_bnorm);
+}
+
+}
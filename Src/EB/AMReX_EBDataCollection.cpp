@@ -2,6 +2,8 @@
 #include <AMReX_EBDataCollection.H>
 #include <AMReX_MultiFab.H>
 #include <AMReX_MultiCutFab.H>
+#include <AMReX_LayoutData.H>
+#include <AMReX_EBCutCellList.H>
 
 #include <AMReX_EB2_Level.H>
 
@@ -57,11 +59,33 @@ EBDataCollection::EBDataCollection (const EB2::Level& a_level,
         a_level.fillAreaFrac(m_areafrac, m_geom);
         a_level.fillFaceCent(m_facecent, m_geom);
     }
+
+    if (m_support >= EBSupport::basic)
+    {
+        m_cutcells = new LayoutData<EBCutCellList>(a_ba, a_dm);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        for (MFIter mfi(*m_cutcells); mfi.isValid(); ++mfi)
+        {
+            EBCutCellList& cl = (*m_cutcells)[mfi];
+            cl.define((*m_cellflags)[mfi]);
+            if (cl.numCutCells() > 0 && m_support >= EBSupport::volume)
+            {
+                const bool full = m_support == EBSupport::full;
+                cl.gather(&(*m_volfrac)[mfi],
+                          full ? &(*m_bndryarea)[mfi] : nullptr,
+                          full ? &(*m_bndrycent)[mfi] : nullptr,
+                          full ? &(*m_bndrynorm)[mfi] : nullptr);
+            }
+        }
+    }
 }
 
 EBDataCollection::~EBDataCollection ()
 {
     delete m_cellflags;
+    delete m_cutcells;
     delete m_volfrac;
     delete m_centroid;
     delete m_bndrycent;
@@ -80,6 +104,13 @@ EBDataCollection::getMultiEBCellFlagFab () const
     return *m_cellflags;
 }
 
+const LayoutData<EBCutCellList>&
+EBDataCollection::getCutCellList () const
+{
+    AMREX_ASSERT(m_cutcells != nullptr);
+    return *m_cutcells;
+}
+
 const MultiFab&
 EBDataCollection::getVolFrac () const
 {
@@ -103,6 +103,16 @@ EBFArrayBoxFactory::maxCoarseningLevel () const
     }
 }
 
+void
+EBFArrayBoxFactory::buildCoarseLevels (int max_coarsening) const
+{
+    EB2::IndexSpace const* ebis = (m_parent) ? m_parent->getEBIndexSpace()
+                                             : &EB2::IndexSpace::top();
+    if (ebis) {
+        ebis->buildCoarseLevels(m_geom, max_coarsening);
+    }
+}
+
 const DistributionMapping&
 EBFArrayBoxFactory::DistributionMap () const
 {
@@ -2,6 +2,7 @@
 #include <AMReX_EBFluxRegister.H>
 #include <AMReX_EBFluxRegister_F.H>
 #include <AMReX_EBFArrayBox.H>
+#include <AMReX_EBFabFactory.H>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -220,6 +221,9 @@ EBFluxRegister::Reflux (MultiFab& crse_state, const amrex::MultiFab& crse_vfrac,
         
         auto const& factory = dynamic_cast<EBFArrayBoxFactory const&>(crse_state.Factory());
         auto const& flags = factory.getMultiEBCellFlagFab();
+        auto const& cutcells = factory.getCutCellList();
+        AMREX_ALWAYS_ASSERT(m_crse_data.boxArray() == cutcells.boxArray() &&
+                            m_crse_data.DistributionMap() == cutcells.DistributionMap());
 
 #ifdef _OPENMP
 #pragma omp parallel
@@ -234,9 +238,10 @@ EBFluxRegister::Reflux (MultiFab& crse_state, const amrex::MultiFab& crse_vfrac,
                     const Box& bx = mfi.tilebox();
                     
                     const auto& ebflag = flags[mfi];
+                    const auto& cl = cutcells[mfi];
                     
-                    if (ebflag.getType(bx) != FabType::covered) {
-                        if (ebflag.getType(amrex::grow(bx,1)) == FabType::regular)
+                    if (getFabType(ebflag, cl, bx) != FabType::covered) {
+                        if (getFabType(ebflag, cl, amrex::grow(bx,1)) == FabType::regular)
                         {
                             // no re-reflux or re-re-redistribution
                             m_crse_data[mfi].plus(grown_crse_data[mfi],bx,0,0,m_ncomp);
@@ -270,6 +275,9 @@ EBFluxRegister::Reflux (MultiFab& crse_state, const amrex::MultiFab& crse_vfrac,
 
     auto const& factory = dynamic_cast<EBFArrayBoxFactory const&>(fine_state.Factory());
     auto const& flags = factory.getMultiEBCellFlagFab();
+    auto const& cutcells = factory.getCutCellList();
+    AMREX_ALWAYS_ASSERT(fine_state.boxArray() == cutcells.boxArray() &&
+                        fine_state.DistributionMap() == cutcells.DistributionMap());
 
 #ifdef _OPENMP
 #pragma omp parallel
@@ -281,7 +289,7 @@ EBFluxRegister::Reflux (MultiFab& crse_state, const amrex::MultiFab& crse_vfrac,
         
         const auto& ebflag = flags[mfi];
         
-        if (ebflag.getType(fbx) != FabType::covered)
+        if (getFabType(ebflag, cutcells[mfi], fbx) != FabType::covered)
         {
             amrex_eb_rereflux_to_fine(BL_TO_FORTRAN_BOX(cbx),
                                       BL_TO_FORTRAN_ANYD(fine_state[mfi]),
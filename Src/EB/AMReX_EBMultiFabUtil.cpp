@@ -12,9 +12,75 @@
 #include <omp.h>
 #endif
 
+#include <algorithm>
+
 namespace amrex
 {
 
+namespace {
+
+// Volume fraction weighted average down of the coarse cells of bx that
+// have cut or covered children.  The other coarse cells are assumed to
+// hold the regular average already.
+void
+eb_avgdown_cut_cells (const Box& bx, FArrayBox& crsefab, int ccomp,
+                      const FArrayBox& finefab, int fcomp, const FArrayBox& vfracfab,
+                      const EBCutCellList& cutcells, int ncomp, const IntVect& ratio)
+{
+    const Box& fbx = amrex::refine(bx, ratio);
+
+    Vector<char> mask(bx.numPts(), 0);
+    cutcells.forEachCutCell(fbx, [&] (int, const IntVect& iv) {
+        mask[bx.index(amrex::coarsen(iv,ratio))] = 1;
+    });
+    cutcells.forEachCoveredRun(fbx, [&] (const IntVect& lo, int len) {
+        IntVect hi = lo;
+        hi[0] += len-1;
+        const IntVect clo = amrex::coarsen(lo,ratio);
+        const long c0 = bx.index(clo);
+        const int nc = amrex::coarsen(hi,ratio)[0] - clo[0] + 1;
+        std::fill(mask.begin()+c0, mask.begin()+c0+nc, 1);
+    });
+
+    const auto len = length(bx);
+    const auto clo = lbound(bx);
+    const auto flo = refine(clo,ratio);
+    const auto crse = crsefab.view(clo,ccomp);
+    const auto fine = finefab.view(flo,fcomp);
+    const auto vfrac = vfracfab.view(flo);
+
+    const int facx = ratio[0];
+    const int facy = (AMREX_SPACEDIM >= 2) ? ratio[1] : 1;
+    const int facz = (AMREX_SPACEDIM == 3) ? ratio[2] : 1;
+
+    long m = 0;
+    for         (int k = 0; k < len.z; ++k) {
+        for     (int j = 0; j < len.y; ++j) {
+            for (int i = 0; i < len.x; ++i, ++m) {
+                if (!mask[m]) continue;
+                const int ii = i*facx;
+                const int jj = j*facy;
+                const int kk = k*facz;
+                for (int n = 0; n < ncomp; ++n) {
+                    Real cv = 0.0, c = 0.0;
+                    for         (int kref = 0; kref < facz; ++kref) {
+                        for     (int jref = 0; jref < facy; ++jref) {
+                            for (int iref = 0; iref < facx; ++iref) {
+                                const Real v = vfrac(ii+iref,jj+jref,kk+kref);
+                                cv += v;
+                                c += fine(ii+iref,jj+jref,kk+kref,n)*v;
+                            }
+                        }
+                    }
+                    crse(i,j,k,n) = (cv > 1.e-30) ? c/cv : fine(ii,jj,kk,n); // covered cell
+                }
+            }
+        }
+    }
+}
+
+}
+
 void
 EB_set_covered (MultiFab& mf, Real val)
 {
@@ -27,6 +93,58 @@ EB_set_covered (MultiFab& mf, int icomp, int ncomp, const Vector<Real>& vals)
 {
     AMREX_ALWAYS_ASSERT(mf.ixType().cellCentered() || mf.ixType().nodeCentered());
     bool is_cell_centered = mf.ixType().cellCentered();
+
+    const auto factory = dynamic_cast<EBFArrayBoxFactory const*>(&(mf.Factory()));
+    if (is_cell_centered && factory != nullptr
+        && mf.boxArray() == factory->getCutCellList().boxArray()
+        && mf.DistributionMap() == factory->getCutCellList().DistributionMap())
+    {
+        // Only touch the covered cells, using the covered runs of the
+        // cut cell lists
+        const auto& cutcells = factory->getCutCellList();
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        for (MFIter mfi(mf,true); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.tilebox();
+            FArrayBox& fab = mf[mfi];
+            const auto& flagfab = amrex::getEBCellFlagFab(fab);
+            if (flagfab.getType() == FabType::regular) continue;
+
+            if (flagfab.getType() == FabType::multivalued) {
+                // no cut cell lists for multivalued boxes
+                amrex_eb_set_covered(BL_TO_FORTRAN_BOX(bx),
+                                     BL_TO_FORTRAN_N_ANYD(fab,icomp),
+                                     BL_TO_FORTRAN_ANYD(flagfab),
+                                     vals.data(),&ncomp);
+                continue;
+            }
+
+            const EBCutCellList& cl = cutcells[mfi];
+            const FabType typ = (flagfab.getType() == FabType::covered)
+                ? FabType::covered : cl.getType(bx);
+            if (typ == FabType::covered) {
+                for (int n = 0; n < ncomp; ++n) {
+                    fab.setVal(vals[n], bx, icomp+n, 1);
+                }
+            } else if (typ == FabType::singlevalued) {
+                const Box& fbx = fab.box();
+                cl.forEachCoveredRun(bx, [&] (const IntVect& lo, int len)
+                {
+                    for (int n = 0; n < ncomp; ++n) {
+                        Real* AMREX_RESTRICT p = fab.dataPtr(icomp+n) + fbx.index(lo);
+                        const Real v = vals[n];
+                        for (int i = 0; i < len; ++i) {
+                            p[i] = v;
+                        }
+                    }
+                });
+            }
+        }
+        return;
+    }
+
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
@@ -155,9 +273,13 @@ EB_average_down (const MultiFab& S_fine, MultiFab& S_crse, int scomp, int ncomp,
     {
         const auto& factory = dynamic_cast<EBFArrayBoxFactory const&>(S_fine.Factory());
         const auto& vfrac_fine = factory.getVolFrac();
+        const auto& cutcells = factory.getCutCellList();
 
         BL_ASSERT(S_crse.nComp() == S_fine.nComp());
         BL_ASSERT(S_crse.is_cell_centered() && S_fine.is_cell_centered());
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(S_fine.boxArray() == cutcells.boxArray() &&
+                                         S_fine.DistributionMap() == cutcells.DistributionMap(),
+                                         "EB_average_down: S_fine is not defined on the grids of its factory");
 
         BoxArray crse_S_fine_BA = S_fine.boxArray(); crse_S_fine_BA.coarsen(ratio);
 
@@ -174,14 +296,21 @@ EB_average_down (const MultiFab& S_fine, MultiFab& S_crse, int scomp, int ncomp,
                 const auto& fine_fab = S_fine[mfi];
 
                 const auto& flag_fab = amrex::getEBCellFlagFab(fine_fab);
-                FabType typ = flag_fab.getType(amrex::refine(tbx,ratio));
+                FabType typ = getFabType(flag_fab, cutcells[mfi], amrex::refine(tbx,ratio));
 
                 if (typ == FabType::regular || typ == FabType::covered)
                 {
                     amrex_avgdown(tbx,crse_fab,fine_fab,scomp,scomp,ncomp,ratio);
                 }
+                else if (typ == FabType::singlevalued)
+                {
+                    amrex_avgdown(tbx,crse_fab,fine_fab,scomp,scomp,ncomp,ratio);
+                    eb_avgdown_cut_cells(tbx, crse_fab, scomp, fine_fab, scomp, vfrac_fine[mfi],
+                                         cutcells[mfi], ncomp, ratio);
+                }
                 else
                 {
+                    // no cut cell lists for multivalued boxes
                     amrex_eb_avgdown(BL_TO_FORTRAN_BOX(tbx),
                                      BL_TO_FORTRAN_N_ANYD(fine_fab,scomp),
                                      BL_TO_FORTRAN_N_ANYD(crse_fab,scomp),
@@ -205,7 +334,7 @@ EB_average_down (const MultiFab& S_fine, MultiFab& S_crse, int scomp, int ncomp,
                 const auto& fine_fab = S_fine[mfi];
                 
                 const auto& flag_fab = amrex::getEBCellFlagFab(fine_fab);
-                FabType typ = flag_fab.getType(amrex::refine(tbx,ratio));
+                FabType typ = getFabType(flag_fab, cutcells[mfi], amrex::refine(tbx,ratio));
                 
                 if (typ == FabType::regular || typ == FabType::covered)
                 {
@@ -213,11 +342,9 @@ EB_average_down (const MultiFab& S_fine, MultiFab& S_crse, int scomp, int ncomp,
                 }
                 else if (typ == FabType::singlevalued)
                 {
-                    amrex_eb_avgdown(BL_TO_FORTRAN_BOX(tbx),
-                                     BL_TO_FORTRAN_N_ANYD(fine_fab,scomp),
-                                     BL_TO_FORTRAN_N_ANYD(crse_fab,0),
-                                     BL_TO_FORTRAN_ANYD(vfrac_fine[mfi]),
-                                     ratio.getVect(),&ncomp);
+                    amrex_avgdown(tbx,crse_fab,fine_fab,0,scomp,ncomp,ratio);
+                    eb_avgdown_cut_cells(tbx, crse_fab, 0, fine_fab, scomp, vfrac_fine[mfi],
+                                         cutcells[mfi], ncomp, ratio);
                 }
                 else
                 {
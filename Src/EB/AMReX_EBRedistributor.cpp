@@ -0,0 +1,313 @@
+
+#include <AMReX_EBRedistributor.H>
+#include <AMReX_EBCutCellList.H>
+#include <AMReX_BaseFab.H>
+
+namespace amrex {
+
+namespace {
+    constexpr int nnbrs  = AMREX_D_TERM(3,*3,*3);
+    constexpr int center = nnbrs/2;
+
+    IntVect nbr_offset (int s) {
+        return IntVect(AMREX_D_DECL(s%3-1, (s/3)%3-1, s/9-1));
+    }
+
+    // linear offsets of the 3^SPACEDIM neighbors in a fab over b
+    void nbr_strides (const Box& b, long* off) {
+        const IntVect len = b.length();
+        for (int s = 0; s < nnbrs; ++s) {
+            const IntVect d = nbr_offset(s);
+            off[s] = AMREX_D_TERM(d[0], + d[1]*long(len[0]), + d[2]*long(len[0])*long(len[1]));
+        }
+    }
+}
+
+EBRedistributor::EBRedistributor (const EBFArrayBoxFactory& factory, Real target_vfrac)
+{
+    define(factory, target_vfrac);
+}
+
+void
+EBRedistributor::define (const EBFArrayBoxFactory& factory, Real target_vfrac)
+{
+    BL_PROFILE("EBRedistributor::define()");
+
+    const auto& flags = factory.getMultiEBCellFlagFab();
+    const MultiFab& vfrac = factory.getVolFrac();
+    const int ng = std::min(flags.nGrow(), vfrac.nGrow());
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(ng >= 2, "EBRedistributor: the factory needs at least 2 ghost cells");
+
+    m_grids = flags.boxArray();
+    m_dmap = flags.DistributionMap();
+    m_target_vfrac = target_vfrac;
+    m_has_state = (ng >= 3);
+
+    m_flux.define(m_grids, m_dmap);
+    if (m_has_state) {
+        m_state.define(m_grids, m_dmap);
+    } else {
+        m_state = LayoutData<StateNbhd>();
+    }
+
+    const auto& cutcells = factory.getCutCellList();
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(m_flux, MFItInfo().SetDynamic(true)); mfi.isValid(); ++mfi)
+    {
+        m_flux[mfi] = FluxNbhd();
+        if (m_has_state) m_state[mfi] = StateNbhd();
+        if (flags[mfi].getType() != FabType::singlevalued) continue;
+
+        const Box& vbx = mfi.validbox();
+        defineFlux(vbx, flags[mfi], vfrac[mfi], cutcells[mfi], m_flux[mfi]);
+        if (m_has_state) {
+            defineState(vbx, flags[mfi], vfrac[mfi], cutcells[mfi], m_state[mfi]);
+        }
+    }
+}
+
+void
+EBRedistributor::defineFlux (const Box& vbx, const EBCellFlagFab& flag, const FArrayBox& vfrac,
+                             const EBCutCellList& cutcells, FluxNbhd& nb) const
+{
+    nb.start.push_back(0);
+    cutcells.forEachCutCell(amrex::grow(vbx,1), [&] (int, const IntVect& iv)
+    {
+        Real vtot = 0.0;
+        for (int s = 0; s < nnbrs; ++s) {
+            const IntVect d = nbr_offset(s);
+            if (s != center && flag(iv).isConnected(d)) {
+                vtot += vfrac(iv+d);
+            }
+        }
+        // an isolated cut cell keeps its conservative update
+        if (vtot <= 0.0) return;
+
+        nb.cell.push_back(iv);
+        nb.vfrac.push_back(vfrac(iv));
+        nb.wtotinv.push_back(1.0/vtot);
+        for (int s = 0; s < nnbrs; ++s) {
+            const IntVect d = nbr_offset(s);
+            if (s != center && flag(iv).isConnected(d)) {
+                nb.nbr.push_back(s);
+                nb.nbrvfrac.push_back(vfrac(iv+d));
+                nb.wnc.push_back(vfrac(iv+d)/vtot);
+                nb.nbrvalid.push_back(vbx.contains(iv+d));
+            }
+        }
+        nb.start.push_back(nb.nbr.size());
+    });
+}
+
+void
+EBRedistributor::defineState (const Box& vbx, const EBCellFlagFab& flag, const FArrayBox& vfrac,
+                              const EBCutCellList& cutcells, StateNbhd& nb) const
+{
+    auto is_small = [&] (const IntVect& iv) {
+        return flag(iv).isSingleValued() && vfrac(iv) < m_target_vfrac;
+    };
+
+    // number of neighborhoods each cell belongs to
+    const Box& nbx = amrex::grow(vbx,2);
+    BaseFab<int> num(nbx, 1);
+    num.setVal(1);
+    bool any_small = false;
+    cutcells.forEachCutCell(amrex::grow(vbx,3), [&] (int, const IntVect& iv)
+    {
+        if (!is_small(iv)) return;
+        any_small = true;
+        for (int s = 0; s < nnbrs; ++s) {
+            const IntVect d = nbr_offset(s);
+            if (s != center && flag(iv).isConnected(d) && nbx.contains(iv+d)) {
+                num(iv+d) += 1;
+            }
+        }
+    });
+    if (!any_small) return;
+
+    for (IntVect iv = vbx.smallEnd(); iv <= vbx.bigEnd(); vbx.next(iv)) {
+        const bool small = is_small(iv);
+        if (small || num(iv) > 1) {
+            nb.reset_cell.push_back(iv);
+            nb.reset_coef.push_back(small ? 0.0 : 1.0/num(iv));
+        }
+    }
+
+    nb.start.push_back(0);
+    cutcells.forEachCutCell(amrex::grow(vbx,1), [&] (int, const IntVect& iv)
+    {
+        if (!is_small(iv)) return;
+
+        Vector<int> members;
+        for (int s = 0; s < nnbrs; ++s) {
+            if (s == center || flag(iv).isConnected(nbr_offset(s))) {
+                members.push_back(s);
+            }
+        }
+        bool touches_valid = false;
+        Real vhat = 0.0;
+        for (int s : members) {
+            const IntVect jv = iv + nbr_offset(s);
+            touches_valid = touches_valid || vbx.contains(jv);
+            vhat += vfrac(jv)/num(jv);
+        }
+        if (!touches_valid) return;
+
+        nb.cell.push_back(iv);
+        for (int s : members) {
+            const IntVect jv = iv + nbr_offset(s);
+            nb.nbr.push_back(s);
+            nb.q.push_back(vfrac(jv)/num(jv)/vhat);
+            nb.invn.push_back(vbx.contains(jv) ? 1.0/num(jv) : 0.0);
+        }
+        nb.start.push_back(nb.nbr.size());
+    });
+}
+
+void
+EBRedistributor::FluxRedistribute (MultiFab& dudt, int dcomp, const MultiFab& divc, int scomp, int ncomp,
+                                   const MultiFab* weights, int wcomp) const
+{
+    BL_PROFILE("EBRedistributor::FluxRedistribute()");
+
+    AMREX_ASSERT(dudt.boxArray() == m_grids && dudt.DistributionMap() == m_dmap);
+    AMREX_ASSERT(divc.nGrow() >= 2);
+    AMREX_ASSERT(weights == nullptr || weights->nGrow() >= 1);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(dudt, MFItInfo().SetDynamic(true)); mfi.isValid(); ++mfi)
+    {
+        const Box& vbx = mfi.validbox();
+        FArrayBox& dfab = dudt[mfi];
+        const FArrayBox& sfab = divc[mfi];
+        dfab.copy(sfab, vbx, scomp, vbx, dcomp, ncomp);
+
+        const FluxNbhd& nb = m_flux[mfi];
+        const int ncells = nb.cell.size();
+        if (ncells == 0) continue;
+
+        long doff[nnbrs], soff[nnbrs], woff[nnbrs];
+        nbr_strides(dfab.box(), doff);
+        nbr_strides(sfab.box(), soff);
+
+        // 1/(sum of the weighted neighbor volume fractions)
+        Vector<Real> wtotinv;
+        const Real* w = nullptr;
+        Vector<long> wi(ncells);
+        if (weights) {
+            const FArrayBox& wfab = (*weights)[mfi];
+            nbr_strides(wfab.box(), woff);
+            w = wfab.dataPtr(wcomp);
+            wtotinv.resize(ncells);
+            for (int c = 0; c < ncells; ++c) {
+                wi[c] = wfab.box().index(nb.cell[c]);
+                Real wtot = 0.0;
+                for (int m = nb.start[c]; m < nb.start[c+1]; ++m) {
+                    wtot += nb.nbrvfrac[m] * w[wi[c]+woff[nb.nbr[m]]];
+                }
+                wtotinv[c] = 1.0/wtot;
+            }
+        }
+
+        for (int n = 0; n < ncomp; ++n)
+        {
+            const Real* AMREX_RESTRICT sp = sfab.dataPtr(scomp+n);
+            Real* AMREX_RESTRICT dp = dfab.dataPtr(dcomp+n);
+            for (int c = 0; c < ncells; ++c)
+            {
+                const IntVect& iv = nb.cell[c];
+                const long si = sfab.box().index(iv);
+                const long di = dfab.box().index(iv);
+
+                Real divnc = 0.0;
+                for (int m = nb.start[c]; m < nb.start[c+1]; ++m) {
+                    divnc += nb.wnc[m] * sp[si+soff[nb.nbr[m]]];
+                }
+                const Real optmp = (1.0-nb.vfrac[c])*(divnc - sp[si]);
+                const Real delm = -nb.vfrac[c]*optmp;
+
+                if (vbx.contains(iv)) dp[di] += optmp;
+
+                if (w) {
+                    const Real scale = delm*wtotinv[c];
+                    for (int m = nb.start[c]; m < nb.start[c+1]; ++m) {
+                        if (nb.nbrvalid[m]) {
+                            dp[di+doff[nb.nbr[m]]] += scale * w[wi[c]+woff[nb.nbr[m]]];
+                        }
+                    }
+                } else {
+                    const Real scale = delm*nb.wtotinv[c];
+                    for (int m = nb.start[c]; m < nb.start[c+1]; ++m) {
+                        if (nb.nbrvalid[m]) {
+                            dp[di+doff[nb.nbr[m]]] += scale;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void
+EBRedistributor::StateRedistribute (MultiFab& unew, int dcomp, const MultiFab& u, int scomp, int ncomp) const
+{
+    BL_PROFILE("EBRedistributor::StateRedistribute()");
+
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(m_has_state,
+                                     "EBRedistributor::StateRedistribute: the factory needs at least 3 ghost cells");
+    AMREX_ASSERT(unew.boxArray() == m_grids && unew.DistributionMap() == m_dmap);
+    AMREX_ASSERT(u.nGrow() >= 2);
+    AMREX_ASSERT(&unew != &u);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(unew, MFItInfo().SetDynamic(true)); mfi.isValid(); ++mfi)
+    {
+        const Box& vbx = mfi.validbox();
+        FArrayBox& dfab = unew[mfi];
+        const FArrayBox& sfab = u[mfi];
+        dfab.copy(sfab, vbx, scomp, vbx, dcomp, ncomp);
+
+        const StateNbhd& nb = m_state[mfi];
+        const int ncells = nb.cell.size();
+        if (ncells == 0) continue;
+
+        long doff[nnbrs], soff[nnbrs];
+        nbr_strides(dfab.box(), doff);
+        nbr_strides(sfab.box(), soff);
+
+        for (int n = 0; n < ncomp; ++n)
+        {
+            const Real* AMREX_RESTRICT sp = sfab.dataPtr(scomp+n);
+            Real* AMREX_RESTRICT dp = dfab.dataPtr(dcomp+n);
+
+            for (int r = 0, nr = nb.reset_cell.size(); r < nr; ++r) {
+                const IntVect& iv = nb.reset_cell[r];
+                dp[dfab.box().index(iv)] = nb.reset_coef[r] * sp[sfab.box().index(iv)];
+            }
+
+            for (int c = 0; c < ncells; ++c)
+            {
+                const long si = sfab.box().index(nb.cell[c]);
+                const long di = dfab.box().index(nb.cell[c]);
+                Real qhat = 0.0;
+                for (int m = nb.start[c]; m < nb.start[c+1]; ++m) {
+                    qhat += nb.q[m] * sp[si+soff[nb.nbr[m]]];
+                }
+                for (int m = nb.start[c]; m < nb.start[c+1]; ++m) {
+                    if (nb.invn[m] > 0.0) {
+                        dp[di+doff[nb.nbr[m]]] += qhat * nb.invn[m];
+                    }
+                }
+            }
+        }
+    }
+}
+
+}
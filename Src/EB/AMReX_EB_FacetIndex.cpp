@@ -0,0 +1,164 @@
+#include "AMReX_EB_FacetIndex.H"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace amrex {
+
+EBFacetIndex::EBFacetIndex(const Vector<Real> & facets, Real bucket_size)
+    : m_facets(facets),
+      m_nfacets(facets.size()/6),
+      m_bucket_size(bucket_size),
+      m_lo{0., 0., 0.},
+      m_nb{1, 1, 1}
+{
+    if (m_nfacets == 0) return;
+
+    // Bounding box of the facet centres
+    Point hi;
+    for (int d = 0; d < 3; ++d) {
+        m_lo[d] = std::numeric_limits<Real>::max();
+        hi[d]   = std::numeric_limits<Real>::lowest();
+    }
+    for (int i = 0; i < m_nfacets; ++i) {
+        for (int d = 0; d < 3; ++d) {
+            m_lo[d] = std::min(m_lo[d], m_facets[6*i + d]);
+            hi[d]   = std::max(hi[d],   m_facets[6*i + d]);
+        }
+    }
+    for (int d = 0; d < 3; ++d) {
+        m_nb[d] = static_cast<int>((hi[d] - m_lo[d]) / m_bucket_size) + 1;
+    }
+
+    // Counting sort of the facets into buckets (stable => original order is
+    // kept inside each bucket)
+    const long nbuckets = long(m_nb[0]) * m_nb[1] * m_nb[2];
+    Vector<int> bucket(m_nfacets);
+    m_start.assign(nbuckets + 1, 0);
+    for (int i = 0; i < m_nfacets; ++i) {
+        const int b = (bucket_index(2, m_facets[6*i+2]) * m_nb[1]
+                       + bucket_index(1, m_facets[6*i+1])) * m_nb[0]
+                       + bucket_index(0, m_facets[6*i  ]);
+        bucket[i] = b;
+        ++m_start[b+1];
+    }
+    for (long b = 0; b < nbuckets; ++b) {
+        m_start[b+1] += m_start[b];
+    }
+    m_ids.resize(m_nfacets);
+    Vector<int> pos(m_start.begin(), m_start.end()-1);
+    for (int i = 0; i < m_nfacets; ++i) {
+        m_ids[pos[bucket[i]]++] = i;
+    }
+}
+
+
+
+int EBFacetIndex::bucket_index(int dir, Real x) const {
+    const int i = static_cast<int>(std::floor((x - m_lo[dir]) / m_bucket_size));
+    return std::max(0, std::min(m_nb[dir] - 1, i));
+}
+
+
+
+Real EBFacetIndex::nearest_distance(const Point & p) const {
+
+    if (m_nfacets == 0) return std::numeric_limits<Real>::max();
+
+    // Bucket containing p (may lie outside of the bucket grid)
+    std::array<int,3> ip;
+    for (int d = 0; d < 3; ++d)
+        ip[d] = static_cast<int>(std::floor((p[d] - m_lo[d]) / m_bucket_size));
+
+    // First and last rings (Chebyshev distance in buckets) that touch the grid
+    int s_min = 0, s_max = 0;
+    for (int d = 0; d < 3; ++d) {
+        s_min = std::max(s_min, std::max(-ip[d], ip[d] - (m_nb[d] - 1)));
+        s_max = std::max(s_max, std::max(ip[d], (m_nb[d] - 1) - ip[d]));
+    }
+
+    Real min_dist2 = std::numeric_limits<Real>::max();
+
+    for (int s = s_min; s <= s_max; ++s) {
+        // Any facet in ring s is at least (s-1) buckets away from p
+        if (s > 0) {
+            const Real bound = (s - 1) * m_bucket_size;
+            if (bound * bound >= min_dist2) break;
+        }
+
+        std::array<int,3> lo, hi;
+        for (int d = 0; d < 3; ++d) {
+            lo[d] = std::max(0,            ip[d] - s);
+            hi[d] = std::min(m_nb[d] - 1,  ip[d] + s);
+        }
+
+        auto visit = [&] (int i, int j, int k) {
+            const long b = (long(k) * m_nb[1] + j) * m_nb[0] + i;
+            for (int n = m_start[b]; n < m_start[b+1]; ++n) {
+                const Real * f = & m_facets[6*m_ids[n]];
+                const Real dist2 = (p[0]-f[0])*(p[0]-f[0])
+                                 + (p[1]-f[1])*(p[1]-f[1])
+                                 + (p[2]-f[2])*(p[2]-f[2]);
+                min_dist2 = std::min(min_dist2, dist2);
+            }
+        };
+
+        // Only visit the shell of the ring
+        for (int k = lo[2]; k <= hi[2]; ++k) {
+            for (int j = lo[1]; j <= hi[1]; ++j) {
+                if (std::abs(k - ip[2]) == s || std::abs(j - ip[1]) == s) {
+                    for (int i = lo[0]; i <= hi[0]; ++i) visit(i, j, k);
+                } else {
+                    if (ip[0] - s >= lo[0])          visit(ip[0] - s, j, k);
+                    if (s > 0 && ip[0] + s <= hi[0]) visit(ip[0] + s, j, k);
+                }
+            }
+        }
+    }
+
+    return std::sqrt(min_dist2);
+}
+
+
+
+void EBFacetIndex::gather(const Point & p, Real radius, Vector<Real> & out) const {
+
+    if (m_nfacets == 0) return;
+
+    const Real radius2 = radius * radius;
+
+    std::array<int,3> lo, hi;
+    for (int d = 0; d < 3; ++d) {
+        // Skip the search if the sphere misses the bucket grid entirely
+        const Real x_lo = p[d] - radius, x_hi = p[d] + radius;
+        if (x_hi < m_lo[d] || x_lo > m_lo[d] + m_nb[d] * m_bucket_size) return;
+        lo[d] = bucket_index(d, x_lo);
+        hi[d] = bucket_index(d, x_hi);
+    }
+
+    Vector<int> ids;
+    for (int k = lo[2]; k <= hi[2]; ++k) {
+        for (int j = lo[1]; j <= hi[1]; ++j) {
+            for (int i = lo[0]; i <= hi[0]; ++i) {
+                const long b = (long(k) * m_nb[1] + j) * m_nb[0] + i;
+                for (int n = m_start[b]; n < m_start[b+1]; ++n) {
+                    const Real * f = & m_facets[6*m_ids[n]];
+                    const Real dist2 = (p[0]-f[0])*(p[0]-f[0])
+                                     + (p[1]-f[1])*(p[1]-f[1])
+                                     + (p[2]-f[2])*(p[2]-f[2]);
+                    if (dist2 <= radius2) ids.push_back(m_ids[n]);
+                }
+            }
+        }
+    }
+
+    std::sort(ids.begin(), ids.end());
+
+    out.reserve(out.size() + 6*ids.size());
+    for (int id : ids) {
+        out.insert(out.end(), & m_facets[6*id], & m_facets[6*id] + 6);
+    }
+}
+
+}
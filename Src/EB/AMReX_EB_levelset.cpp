@@ -18,6 +18,36 @@
 
 namespace amrex {
 
+namespace {
+
+// Same as amrex_eb_fill_levelset_bcs: fill the ghost nodes of `phi` that lie
+// outside of the non-periodic faces of `domain`, but using the facet index.
+void fill_levelset_bcs(FArrayBox & phi, IArrayBox & valid,
+                       const IntVect & periodic, const Box & domain,
+                       const EBFacetIndex & facet_index,
+                       const RealVect & dx, const RealVect & dx_eb, Real band) {
+
+    const Box & phi_box = phi.box();
+
+    for (int d = AMREX_SPACEDIM-1; d >= 0; --d) {
+        if (periodic[d]) continue;
+
+        if (phi_box.smallEnd(d) < domain.smallEnd(d)) {
+            Box bx = phi_box;
+            bx.setBig(d, domain.smallEnd(d) - 1);
+            LSFactory::fill_levelset(bx, facet_index, valid, phi, dx, dx_eb, band);
+        }
+
+        if (phi_box.bigEnd(d) > domain.bigEnd(d)) {
+            Box bx = phi_box;
+            bx.setSmall(d, domain.bigEnd(d) + 1);
+            LSFactory::fill_levelset(bx, facet_index, valid, phi, dx, dx_eb, band);
+        }
+    }
+}
+
+}
+
 LSFactory::LSFactory(int lev, int ls_ref, int eb_ref, int ls_pad, int eb_pad,
                      const BoxArray & ba, const Geometry & geom, const DistributionMapping & dm,
                      int eb_tile_size)
@@ -30,7 +60,8 @@ LSFactory::LSFactory(int lev, int ls_ref, int eb_ref, int ls_pad, int eb_pad,
       dx_eb_vect(AMREX_D_DECL(geom.CellSize()[0]/eb_ref,
                               geom.CellSize()[1]/eb_ref,
                               geom.CellSize()[2]/eb_ref)),
-      eb_tile_size(eb_tile_size)
+      eb_tile_size(eb_tile_size),
+      ls_band(-1)
 {
     // Init geometry over which the level set and EB are defined
     init_geom(ba, geom, dm);
@@ -83,6 +114,7 @@ LSFactory::LSFactory(const LSFactory & other) :
 {
     //ls_grid  = other.copy_data();
     //ls_valid = other.copy_valid();
+    ls_band = other.get_narrow_band();
 }
 
 
@@ -553,6 +585,88 @@ void LSFactory::set_data(const MultiFab & mf_ls){
 
 
 
+Real LSFactory::facet_bucket_size(const RealVect & dx_eb) {
+    // Facets live on the EB grid => buckets of 2^3 EB cells hold a handful of
+    // facets each
+    return 2. * dx_eb[dx_eb.maxDir(false)];
+}
+
+
+
+Real LSFactory::narrow_band_width() const {
+    if (ls_band < 0) return -1.;
+    return ls_band * dx_eb_vect[dx_eb_vect.minDir(false)];
+}
+
+
+
+void LSFactory::fill_levelset(const Box & tile_box,
+                              const EBFacetIndex & facet_index,
+                              IArrayBox & valid, FArrayBox & phi,
+                              const RealVect & dx, const RealVect & dx_eb,
+                              Real band) {
+
+    BL_PROFILE("LSFactory::fill_levelset()");
+
+    // Edge length (in level-set nodes) of the blocks sharing a facet list
+    const int block_size = 4;
+
+    // The facet centre (bndrycent) can be anywhere in its EB cell, and
+    // amrex_eb_fill_levelset accepts projections anywhere in that cell =>
+    // a point on a facet can be a full EB cell diagonal from its centre
+    Real facet_radius = 0.;
+    for (int d = 0; d < AMREX_SPACEDIM; ++d)
+        facet_radius += dx_eb[d] * dx_eb[d];
+    facet_radius = std::sqrt(facet_radius);
+
+    // Blocks are formed in the index space of tile_box, regardless of its type
+    Box ibox = tile_box;
+    ibox.setType(IndexType::TheCellType());
+    const Box cbox = amrex::coarsen(ibox, block_size);
+
+    Vector<Real> local_facets;
+
+    for (IntVect civ = cbox.smallEnd(); civ <= cbox.bigEnd(); cbox.next(civ)) {
+
+        Box block = amrex::refine(Box(civ, civ), block_size) & ibox;
+        block.setType(tile_box.ixType());
+
+        // Block centre and radius (level-set nodes are at i*dx)
+        EBFacetIndex::Point centre = {0., 0., 0.};
+        Real radius = 0.;
+        for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+            const Real x_lo = block.smallEnd(d) * dx[d];
+            const Real x_hi = block.bigEnd(d)   * dx[d];
+            centre[d] = 0.5 * (x_lo + x_hi);
+            radius   += 0.25 * (x_hi - x_lo) * (x_hi - x_lo);
+        }
+        radius = std::sqrt(radius);
+
+        const Real dist = facet_index.nearest_distance(centre);
+
+        // The whole block lies outside of the narrow band
+        if (band > 0. && dist - radius - facet_radius >= band) {
+            phi.setVal(band, block);
+            valid.setVal(0, block);
+            continue;
+        }
+
+        // The nearest facet centre of any node in the block is within
+        // dist + 2*radius of the block centre
+        local_facets.clear();
+        facet_index.gather(centre, (dist + 2.*radius) * (1. + 1.e-12), local_facets);
+        int len_facets = local_facets.size();
+
+        amrex_eb_fill_levelset(BL_TO_FORTRAN_BOX(block),
+                               local_facets.dataPtr(), & len_facets,
+                               BL_TO_FORTRAN_3D(valid),
+                               BL_TO_FORTRAN_3D(phi),
+                               dx.dataPtr(), dx_eb.dataPtr() );
+    }
+}
+
+
+
 void LSFactory::fill_data (MultiFab & data, iMultiFab & valid,
                            const EBFArrayBoxFactory & eb_factory,
                            const MultiFab & eb_impfunc,
@@ -723,14 +837,19 @@ void LSFactory::fill_data (MultiFab & data, iMultiFab & valid,
 
 
         //_______________________________________________________________________
-        // Fill local level-set
+        // Threshold for local level-set
+        Real ls_threshold = min_dx * (eb_pad+1); //eb_pad => we know that any EB
+                                                 //is _at least_ eb_pad away from
+                                                 //the edge of the eb search box
+
+
+        //_______________________________________________________________________
+        // Fill local level-set. Values beyond ls_threshold are clamped below,
+        // so they don't need to be computed exactly (narrow band).
         if (len_facets > 0) {
 
-            amrex_eb_fill_levelset(BL_TO_FORTRAN_BOX(tile_box),
-                                   facets->dataPtr(), & len_facets,
-                                   BL_TO_FORTRAN_3D(v_tile),
-                                   BL_TO_FORTRAN_3D(ls_tile),
-                                   dx.dataPtr(), dx_eb.dataPtr() );
+            EBFacetIndex facet_index(* facets, facet_bucket_size(dx_eb));
+            fill_levelset(tile_box, facet_index, v_tile, ls_tile, dx, dx_eb, ls_threshold);
 
             region_tile.setVal(1);
         } else {
@@ -740,9 +859,6 @@ void LSFactory::fill_data (MultiFab & data, iMultiFab & valid,
 
         //_______________________________________________________________________
         // Threshold local level-set
-        Real ls_threshold = min_dx * (eb_pad+1); //eb_pad => we know that any EB
-                                                 //is _at least_ eb_pad away from
-                                                 //the edge of the eb search box
         amrex_eb_threshold_levelset(BL_TO_FORTRAN_BOX(tile_box), & ls_threshold,
                                     BL_TO_FORTRAN_3D(ls_tile));
 
@@ -809,6 +925,10 @@ std::unique_ptr<iMultiFab> LSFactory::intersection_ebf(const EBFArrayBoxFactory
     std::unique_ptr<Vector<Real>> facets = eb_facets(eb_factory);
     int len_facets = facets->size();
 
+    // Spatial index => each level-set node only tests nearby facets
+    EBFacetIndex facet_index(* facets, facet_bucket_size(dx_eb_vect));
+    const Real band = narrow_band_width();
+
     // What if there are no facets in this core domain? => do nothing in terms
     // of filling, but make sure that the region valid is still set to 0 =>
     // dont just return here.
@@ -844,11 +964,8 @@ std::unique_ptr<iMultiFab> LSFactory::intersection_ebf(const EBFArrayBoxFactory
         auto & ls_tile = eb_ls[mfi];
         const auto & if_tile = impfunct[mfi];
         if(len_facets > 0) {
-            amrex_eb_fill_levelset(lo, hi,
-                                   facets->dataPtr(), & len_facets,
-                                   BL_TO_FORTRAN_3D(v_tile),
-                                   BL_TO_FORTRAN_3D(ls_tile),
-                                   dx_vect.dataPtr(), dx_eb_vect.dataPtr() );
+            fill_levelset(tile_box, facet_index, v_tile, ls_tile,
+                          dx_vect, dx_eb_vect, band);
 
             amrex_eb_validate_levelset(lo, hi, & ls_grid_ref,
                                        BL_TO_FORTRAN_3D(if_tile),
@@ -886,11 +1003,8 @@ std::unique_ptr<iMultiFab> LSFactory::intersection_ebf(const EBFArrayBoxFactory
         const auto & if_tile = impfunct[mfi];
 
         if(len_facets > 0) {
-            amrex_eb_fill_levelset_bcs( BL_TO_FORTRAN_3D(ls_tile),
-                                        BL_TO_FORTRAN_3D(v_tile),
-                                        periodic.getVect(), domain.loVect(), domain.hiVect(),
-                                        facets->dataPtr(), & len_facets,
-                                        dx_vect.dataPtr(), dx_eb_vect.dataPtr() );
+            fill_levelset_bcs(ls_tile, v_tile, periodic, domain, facet_index,
+                              dx_vect, dx_eb_vect, band);
 
             amrex_eb_validate_levelset_bcs( BL_TO_FORTRAN_3D(ls_tile),
                                             BL_TO_FORTRAN_3D(v_tile),
@@ -917,6 +1031,10 @@ std::unique_ptr<iMultiFab> LSFactory::union_ebf(const EBFArrayBoxFactory & eb_fa
     std::unique_ptr<Vector<Real>> facets = eb_facets(eb_factory);
     int len_facets = facets->size();
 
+    // Spatial index => each level-set node only tests nearby facets
+    EBFacetIndex facet_index(* facets, facet_bucket_size(dx_eb_vect));
+    const Real band = narrow_band_width();
+
     // Local MultiFab storing level-set data for this eb_factory
     MultiFab eb_ls;
     iMultiFab eb_valid;
@@ -949,11 +1067,8 @@ std::unique_ptr<iMultiFab> LSFactory::union_ebf(const EBFArrayBoxFactory & eb_fa
         const auto & if_tile = impfunct[mfi];
 
         if(len_facets > 0) {
-            amrex_eb_fill_levelset(lo, hi,
-                                   facets->dataPtr(), & len_facets,
-                                   BL_TO_FORTRAN_3D(v_tile),
-                                   BL_TO_FORTRAN_3D(ls_tile),
-                                   dx_vect.dataPtr(), dx_eb_vect.dataPtr());
+            fill_levelset(tile_box, facet_index, v_tile, ls_tile,
+                          dx_vect, dx_eb_vect, band);
 
             amrex_eb_validate_levelset(lo, hi, & ls_grid_ref,
                                        BL_TO_FORTRAN_3D(if_tile),
@@ -992,11 +1107,8 @@ std::unique_ptr<iMultiFab> LSFactory::union_ebf(const EBFArrayBoxFactory & eb_fa
         const auto & if_tile = impfunct[mfi];
 
         if(len_facets > 0) {
-            amrex_eb_fill_levelset_bcs( BL_TO_FORTRAN_3D(ls_tile),
-                                        BL_TO_FORTRAN_3D(v_tile),
-                                        periodic.getVect(), domain.loVect(), domain.hiVect(),
-                                        facets->dataPtr(), & len_facets,
-                                        dx_vect.dataPtr(), dx_eb_vect.dataPtr() );
+            fill_levelset_bcs(ls_tile, v_tile, periodic, domain, facet_index,
+                              dx_vect, dx_eb_vect, band);
 
             amrex_eb_validate_levelset_bcs( BL_TO_FORTRAN_3D(ls_tile),
                                             BL_TO_FORTRAN_3D(v_tile),
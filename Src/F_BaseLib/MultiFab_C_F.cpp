@@ -33,7 +33,10 @@ MultiFab_C_to_F::MultiFab_C_to_F (const Geometry& geom,
 	pm[i] = geom.isPeriodic(i)? 1 : 0;
     }
 
-    const Vector<int>& pmap = dmap.ProcessorMap();
+    Vector<int> pmap(nb);
+    for ( int i = 0; i < nb; ++i ) {
+	pmap[i] = dmap[i];
+    }
 
     build_layout_from_c(nb, dm, &lo[0], &hi[0], 
 			domain.loVect(), domain.hiVect(), 
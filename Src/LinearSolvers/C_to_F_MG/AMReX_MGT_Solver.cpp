@@ -215,10 +215,14 @@ MGT_Solver::Build(const Vector<Geometry>& geom,
 
   for ( int lev = 0; lev < m_nlevel; ++lev )
     {
-      const Vector<int>& pmap = dmap[lev].ProcessorMap();
       Box domain = geom[lev].Domain();
 
       int nb = m_grids[lev].size();
+      Vector<int> pmap(nb);
+      for ( int i = 0; i < nb; ++i )
+      {
+        pmap[i] = dmap[lev][i];
+      }
       Vector<int> lo(nb*dm);
       Vector<int> hi(nb*dm);
 
@@ -3,6 +3,7 @@
 #include <AMReX_MultiFabUtil.H>
 #include <AMReX_EBMultiFabUtil.H>
 #include <AMReX_EBFArrayBox.H>
+#include <AMReX_ParmParse.H>
 
 #include <AMReX_MLEBABecLap_F.H>
 #include <AMReX_MLLinOp_F.H>
@@ -11,6 +12,10 @@
 #include <AMReX_MG_F.H>
 #include <AMReX_EBMultiFabUtil_F.H>
 
+#if (AMREX_SPACEDIM == 3)
+#include <AMReX_MLEBABecLap_3D_C.H>
+#endif
+
 #ifdef AMREX_USE_HYPRE
 #include <AMReX_HypreABecLap3.H>
 #endif
@@ -56,6 +61,11 @@ MLEBABecLap::define (const Vector<Geometry>& a_geom,
 
     MLCellABecLap::define(a_geom, a_grids, a_dmap, a_info, _factory);
 
+    {
+        ParmParse pp("mlebabeclap");
+        pp.query("precompute_stencil", m_precompute_stencil);
+    }
+
     m_a_coeffs.resize(m_num_amr_levels);
     m_b_coeffs.resize(m_num_amr_levels);
     m_cc_mask.resize(m_num_amr_levels);
@@ -271,6 +281,65 @@ MLEBABecLap::averageDownCoeffsToCoarseAmrLevel (int flev)
     }
 }
 
+void
+MLEBABecLap::buildCutStencil ()
+{
+    m_cut_stencil.clear();
+
+#if (AMREX_SPACEDIM == 3)
+    if (!m_precompute_stencil) return;
+
+    BL_PROFILE("MLEBABecLap::buildCutStencil()");
+
+    const int is_eb_dirichlet = isEBDirichlet();
+
+    m_cut_stencil.resize(m_num_amr_levels);
+    for (int amrlev = 0; amrlev < m_num_amr_levels; ++amrlev)
+    {
+        m_cut_stencil[amrlev].resize(m_num_mg_levels[amrlev]);
+        for (int mglev = 0; mglev < m_num_mg_levels[amrlev]; ++mglev)
+        {
+            auto factory = dynamic_cast<EBFArrayBoxFactory const*>(m_factory[amrlev][mglev].get());
+            if (factory == nullptr) continue;
+
+            auto& stencil = m_cut_stencil[amrlev][mglev];
+            stencil.define(m_grids[amrlev][mglev], m_dmap[amrlev][mglev]);
+
+            const auto& bcoef = m_b_coeffs[amrlev][mglev];
+            const iMultiFab& ccmask = m_cc_mask[amrlev][mglev];
+            const Real* dxinv = m_geom[amrlev][mglev].InvCellSize();
+            const auto& flags = factory->getMultiEBCellFlagFab();
+            const auto& cutcells = factory->getCutCellList();
+            const MultiFab& vfrac = factory->getVolFrac();
+            const auto area = factory->getAreaFrac();
+            const auto fcent = factory->getFaceCent();
+            const MultiCutFab& barea = factory->getBndryArea();
+            const MultiCutFab& bcent = factory->getBndryCent();
+            const MultiFab* beb = (is_eb_dirichlet) ? m_eb_b_coeffs[amrlev][mglev].get() : nullptr;
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+            for (MFIter mfi(stencil, MFItInfo().SetDynamic(true)); mfi.isValid(); ++mfi)
+            {
+                Vector<Real>& w = stencil[mfi];
+                if (flags[mfi].getType() != FabType::singlevalued) continue;
+
+                const EBCutCellList& cl = cutcells[mfi];
+                w.resize(mlebabeclap::nweights*cl.numCutCells());
+                amrex_mlebabeclap_stencil(mfi.validbox(), cl, w.data(),
+                                          bcoef[0][mfi], bcoef[1][mfi], bcoef[2][mfi],
+                                          ccmask[mfi], vfrac[mfi],
+                                          (*area[0])[mfi], (*area[1])[mfi], (*area[2])[mfi],
+                                          (*fcent[0])[mfi], (*fcent[1])[mfi], (*fcent[2])[mfi],
+                                          barea[mfi], bcent[mfi],
+                                          (beb) ? &(*beb)[mfi] : nullptr, dxinv);
+            }
+        }
+    }
+#endif
+}
+
 void
 MLEBABecLap::prepareForSolve ()
 {
@@ -311,6 +380,8 @@ MLEBABecLap::prepareForSolve ()
         }
     }
 
+    buildCutStencil();
+
     m_needs_update = false;
 }
 
@@ -340,6 +411,9 @@ MLEBABecLap::Fapply (int amrlev, int mglev, MultiFab& out, const MultiFab& in) c
     const int is_eb_dirichlet = isEBDirichlet();
     FArrayBox foo(Box::TheUnitBox());
 
+    const LayoutData<Vector<Real> >* cutstencil
+        = hasCutStencil(amrlev,mglev) ? &m_cut_stencil[amrlev][mglev] : nullptr;
+
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
@@ -353,7 +427,15 @@ MLEBABecLap::Fapply (int amrlev, int mglev, MultiFab& out, const MultiFab& in) c
                      const FArrayBox& byfab = bycoef[mfi];,
                      const FArrayBox& bzfab = bzcoef[mfi];);
 
-        auto fabtyp = (flags) ? (*flags)[mfi].getType(bx) : FabType::regular;
+        FabType fabtyp;
+        if (cutstencil) {
+            fabtyp = (*flags)[mfi].getType();
+            if (fabtyp == FabType::singlevalued) {
+                fabtyp = factory->getCutCellList()[mfi].getType(bx);
+            }
+        } else {
+            fabtyp = (flags) ? (*flags)[mfi].getType(bx) : FabType::regular;
+        }
 
         if (fabtyp == FabType::covered) {
             yfab.setVal(0.0, bx, 0, 1);
@@ -366,7 +448,16 @@ MLEBABecLap::Fapply (int amrlev, int mglev, MultiFab& out, const MultiFab& in) c
                                                BL_TO_FORTRAN_ANYD(byfab),
                                                BL_TO_FORTRAN_ANYD(bzfab)),
                                   dxinv, m_a_scalar, m_b_scalar);
-        } else {
+        }
+#if (AMREX_SPACEDIM == 3)
+        else if (cutstencil) {
+            const FArrayBox* phiebfab = (is_eb_dirichlet && m_is_eb_inhomog) ? &(*m_eb_phi[amrlev])[mfi] : nullptr;
+            amrex_mlebabeclap_adotx_sv(bx, yfab, xfab, afab, bxfab, byfab, bzfab,
+                                       factory->getCutCellList()[mfi], (*cutstencil)[mfi].data(),
+                                       phiebfab, dxinv, m_a_scalar, m_b_scalar);
+        }
+#endif
+        else {
 
             FArrayBox const& bebfab = (is_eb_dirichlet) ? (*m_eb_b_coeffs[amrlev][mglev])[mfi] : foo;
             FArrayBox const& phiebfab = (is_eb_dirichlet && m_is_eb_inhomog) ? (*m_eb_phi[amrlev])[mfi] : foo;
@@ -450,6 +541,9 @@ MLEBABecLap::Fsmooth (int amrlev, int mglev, MultiFab& sol, const MultiFab& rhs,
     const int is_eb_dirichlet = isEBDirichlet();
     FArrayBox foo(Box::TheUnitBox());
 
+    const LayoutData<Vector<Real> >* cutstencil
+        = hasCutStencil(amrlev,mglev) ? &m_cut_stencil[amrlev][mglev] : nullptr;
+
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
@@ -488,7 +582,15 @@ MLEBABecLap::Fsmooth (int amrlev, int mglev, MultiFab& sol, const MultiFab& rhs,
 #endif
 #endif
 
-        auto fabtyp = (flags) ? (*flags)[mfi].getType(tbx) : FabType::regular;
+        FabType fabtyp;
+        if (cutstencil) {
+            fabtyp = (*flags)[mfi].getType();
+            if (fabtyp == FabType::singlevalued) {
+                fabtyp = factory->getCutCellList()[mfi].getType(tbx);
+            }
+        } else {
+            fabtyp = (flags) ? (*flags)[mfi].getType(tbx) : FabType::regular;
+        }
 
         if (fabtyp == FabType::covered)
         {
@@ -552,6 +654,16 @@ MLEBABecLap::Fsmooth (int amrlev, int mglev, MultiFab& sol, const MultiFab& rhs,
                             &nc, h, &redblack);
 #endif
         }
+#if (AMREX_SPACEDIM == 3)
+        else if (cutstencil)
+        {
+            amrex_mlebabeclap_gsrb_sv(tbx, solnfab, rhsfab, afab, bxfab, byfab, bzfab,
+                                      m0, m1, m2, m3, m4, m5,
+                                      f0fab, f1fab, f2fab, f3fab, f4fab, f5fab,
+                                      factory->getCutCellList()[mfi], (*cutstencil)[mfi].data(),
+                                      dxinv, m_a_scalar, m_b_scalar, redblack);
+        }
+#endif
         else
         {
             FArrayBox const& bebfab = (is_eb_dirichlet) ? (*m_eb_b_coeffs[amrlev][mglev])[mfi] : foo;
@@ -987,6 +1099,8 @@ MLEBABecLap::update ()
         }
     }
 
+    buildCutStencil();
+
     m_needs_update = false;
 }
 
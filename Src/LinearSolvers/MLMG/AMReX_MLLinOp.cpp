@@ -1,12 +1,14 @@
 
 #include <cmath>
 #include <algorithm>
+#include <numeric>
 #include <AMReX_MLLinOp.H>
 #include <AMReX_ParmParse.H>
 
 #ifdef AMREX_USE_EB
 #include <AMReX_EB2.H>
 #include <AMReX_EBFabFactory.H>
+#include <AMReX_EBAmrUtil.H>
 #endif
 
 #ifdef AMREX_USE_PETSC
@@ -47,10 +49,11 @@ MLLinOp::define (const Vector<Geometry>& a_geom,
     }
 
     info = a_info;
-#if AMREX_USE_EB
+#ifdef AMREX_USE_EB
     if (!a_factory.empty()){
         auto f = dynamic_cast<EBFArrayBoxFactory const*>(a_factory[0]);
         if (f) {
+            f->buildCoarseLevels(info.max_coarsening_level);
             info.max_coarsening_level = std::min(info.max_coarsening_level,
                                                  f->maxCoarseningLevel());
         }
@@ -285,6 +288,20 @@ MLLinOp::defineGrids (const Vector<Geometry>& a_geom,
 
     if (agged)
     {
+#ifdef AMREX_USE_EB
+        // Balance the agglomerated levels with the EB cost of their boxes
+        auto f = a_factory.empty() ? nullptr
+            : dynamic_cast<EBFArrayBoxFactory const*>(a_factory[0]);
+        const EB2::IndexSpace* ebis = f ? f->getEBIndexSpace() : nullptr;
+        if (ebis) {
+            for (int i = 1, N = m_grids[0].size(); i < N; ++i) {
+                if (m_dmap[0][i].empty()) {
+                    m_dmap[0][i] = amrex::makeEBDistributionMap(ebis->getLevel(m_geom[0][i]),
+                                                                m_geom[0][i], m_grids[0][i]);
+                }
+            }
+        }
+#endif
         makeAgglomeratedDMap(m_grids[0], m_dmap[0]);
     }
     else if (coned)
@@ -382,10 +399,14 @@ MLLinOp::makeSubCommunicator (const DistributionMapping& dm)
 
     MPI_Comm_group(m_default_comm, &defgrp);
 
-    Vector<int> newgrp_ranks = dm.ProcessorMap();
-    std::sort(newgrp_ranks.begin(), newgrp_ranks.end());
-    auto last = std::unique(newgrp_ranks.begin(), newgrp_ranks.end());
-    newgrp_ranks.erase(last, newgrp_ranks.end());
+    Vector<char> in_newgrp(ParallelDescriptor::NProcs(), 0);
+    for (int i = 0, N = dm.size(); i < N; ++i) {
+        in_newgrp[dm[i]] = 1;
+    }
+    Vector<int> newgrp_ranks;
+    for (int r = 0; r < in_newgrp.size(); ++r) {
+        if (in_newgrp[r]) newgrp_ranks.push_back(r);
+    }
     
     if (ParallelContext::CommunicatorSub() == ParallelDescriptor::Communicator()) {
         MPI_Group_incl(defgrp, newgrp_ranks.size(), newgrp_ranks.data(), &newgrp);
@@ -443,6 +464,7 @@ MLLinOp::makeConsolidatedDMap (const Vector<BoxArray>& ba, Vector<DistributionMa
     BL_PROFILE("MLLinOp::makeConsolidatedDMap()");
 
     int factor = 1;
+    Vector<int> local_rank; // local rank of each global rank
     BL_ASSERT(!dm[0].empty());
     for (int i = 1, N=ba.size(); i < N; ++i)
     {
@@ -451,9 +473,17 @@ MLLinOp::makeConsolidatedDMap (const Vector<BoxArray>& ba, Vector<DistributionMa
             factor *= ratio;
 
             const int nprocs = ParallelContext::NProcsSub();
-            const auto& pmap_fine = dm[i-1].ProcessorMap();
-            Vector<int> pmap(pmap_fine.size());
-            ParallelContext::global_to_local_rank(pmap.data(), pmap_fine.data(), pmap.size()); 
+            if (local_rank.empty()) {
+                Vector<int> global_rank(ParallelDescriptor::NProcs());
+                std::iota(global_rank.begin(), global_rank.end(), 0);
+                local_rank.resize(global_rank.size());
+                ParallelContext::global_to_local_rank(local_rank.data(), global_rank.data(), global_rank.size());
+            }
+            const DistributionMapping& dm_fine = dm[i-1];
+            Vector<int> pmap(dm_fine.size());
+            for (int j = 0; j < pmap.size(); ++j) {
+                pmap[j] = local_rank[dm_fine[j]];
+            }
             if (strategy == 1) {
                 for (auto& x: pmap) {
                     x /= ratio;
@@ -0,0 +1,91 @@
+
+#include <iomanip>
+#include <functional>
+#include <limits>
+
+#include <AMReX.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_FabArrayExpr.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+// STREAM-like memory bandwidth of MultiFab operations.  The bandwidth is
+// the number of bytes read and written by the operation, summed over the
+// ranks, divided by its best time.
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 256, max_grid_size = 64, ncomp = 1, iters = 10;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("ncomp", ncomp);
+            pp.query("iters", iters);
+        }
+        bool use_huge_pages = false;
+        {
+            ParmParse pp("amrex");
+            pp.query("use_huge_pages", use_huge_pages);
+        }
+
+        BoxArray ba(Box(IntVect(0), IntVect(n_cell-1)));
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        MultiFab a(ba, dm, ncomp, 0);
+        MultiFab b(ba, dm, ncomp, 0);
+        MultiFab c(ba, dm, ncomp, 0);
+        a.setVal(1.0);
+        b.setVal(2.0);
+        c.setVal(0.0);
+
+        const Real q = 3.0;
+        const double words = double(ba.numPts()) * ncomp;
+
+        amrex::Print() << "n_cell " << n_cell << ", max_grid_size " << max_grid_size
+                       << ", ncomp " << ncomp << ", boxes " << ba.size()
+#ifdef _OPENMP
+                       << ", threads " << omp_get_max_threads()
+#endif
+                       << ", first_touch " << FabArrayBase::first_touch
+                       << ", huge pages " << use_huge_pages << "\n"
+                       << "  Function      Best GB/s   Avg time   Min time   Max time\n";
+
+        auto bench = [&] (const std::string& name, int nwords, const std::function<void()>& f)
+        {
+            f();  // warm up
+            Real tmin = std::numeric_limits<Real>::max(), tmax = 0.0, tsum = 0.0;
+            for (int it = 0; it < iters; ++it)
+            {
+                ParallelDescriptor::Barrier();
+                Real t = amrex::second();
+                f();
+                t = amrex::second() - t;
+                ParallelDescriptor::ReduceRealMax(t);
+                tmin = std::min(tmin, t);
+                tmax = std::max(tmax, t);
+                tsum += t;
+            }
+            amrex::Print() << "  " << std::left << std::setw(12) << name << std::right
+                           << std::setw(11) << std::fixed << std::setprecision(1)
+                           << nwords*words*sizeof(Real)/tmin*1.e-9
+                           << std::scientific << std::setprecision(3)
+                           << std::setw(11) << tsum/iters
+                           << std::setw(11) << tmin
+                           << std::setw(11) << tmax << "\n";
+        };
+
+        bench("Copy",  2, [&] () { MultiFab::Copy(c, a, 0, 0, ncomp, 0); });
+        bench("Scale", 2, [&] () { amrex::Assign(b, 0, ncomp, 0, q*Expr(c)); });
+        bench("Add",   3, [&] () { amrex::Assign(c, 0, ncomp, 0, Expr(a) + Expr(b)); });
+        bench("Triad", 3, [&] () { amrex::Assign(a, 0, ncomp, 0, Expr(b) + q*Expr(c)); });
+        bench("Saxpy", 3, [&] () { MultiFab::Saxpy(a, q, b, 0, 0, ncomp, 0); });
+        bench("setVal", 1, [&] () { c.setVal(1.0); });
+        bench("Dot",   1, [&] () { MultiFab::Dot(a, 0, a, 0, ncomp, 0); });
+    }
+    amrex::Finalize();
+}
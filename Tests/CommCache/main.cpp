@@ -0,0 +1,87 @@
+
+#include <AMReX.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+// A BoxArray of its own, so that each fine MultiFab has its own cache key.
+MultiFab
+makeFine (const Box& fine_domain)
+{
+    BoxArray ba(fine_domain);
+    ba.maxSize(8);
+    DistributionMapping dm(ba);
+    return MultiFab(ba, dm, 1, 2);
+}
+
+const FabArrayBase::CFinfo&
+getCFinfo (const MultiFab& fine, const Geometry& geom)
+{
+    return FabArrayBase::TheCFinfo(fine, geom, IntVect(2), true, false);
+}
+
+// Check that, with fabarray.comm_cache_max_mb, the coarse/fine boundary
+// cache evicts its least recently used entry, but not a locked one nor
+// the one that is being built.
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        Box domain(IntVect(0), IntVect(63));
+        RealBox rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        Geometry geom(domain, &rb);
+        const Box fine_domain(IntVect(16), IntVect(47));
+
+        MultiFab a = makeFine(fine_domain);
+        MultiFab b = makeFine(fine_domain);
+        MultiFab c = makeFine(fine_domain);
+
+        const auto& stats = FabArrayBase::m_CFinfo_stats;
+
+        // Room for two entries.
+        const long entry_bytes = getCFinfo(a, geom).bytes();
+        FabArrayBase::comm_cache_max_bytes = 2*entry_bytes + entry_bytes/2;
+        getCFinfo(b, geom);
+        AMREX_ALWAYS_ASSERT(stats.nbuild == 2 && stats.nevict == 0);
+
+        // a is used after b, so building c evicts b.
+        getCFinfo(a, geom);
+        getCFinfo(c, geom);
+        AMREX_ALWAYS_ASSERT(stats.nbuild == 3 && stats.nevict == 1);
+        getCFinfo(a, geom);
+        AMREX_ALWAYS_ASSERT(stats.nbuild == 3);
+        getCFinfo(b, geom);
+        AMREX_ALWAYS_ASSERT(stats.nbuild == 4 && stats.nevict == 2);  // and c is evicted
+
+        // b is the least recently used, but it is locked, so a is evicted.
+        {
+            getCFinfo(a, geom);
+            FabArrayBase::CFinfoLock lock(getCFinfo(b, geom));
+            getCFinfo(a, geom);
+            getCFinfo(c, geom);
+            AMREX_ALWAYS_ASSERT(stats.nbuild == 5 && stats.nevict == 3);
+            AMREX_ALWAYS_ASSERT(lock->m_fine_bdk == b.getBDKey());
+            getCFinfo(b, geom);
+            AMREX_ALWAYS_ASSERT(stats.nbuild == 5);
+        }
+
+        // Once unlocked, b can go.  c has been used since then.
+        getCFinfo(c, geom);
+        getCFinfo(a, geom);
+        AMREX_ALWAYS_ASSERT(stats.nbuild == 6 && stats.nevict == 4);
+        getCFinfo(c, geom);
+        AMREX_ALWAYS_ASSERT(stats.nbuild == 6);
+
+        // An entry over the whole budget is kept until the next one is built.
+        FabArrayBase::comm_cache_max_bytes = 1;
+        getCFinfo(b, geom);
+        AMREX_ALWAYS_ASSERT(stats.nbuild == 7 && stats.nevict == 6 && stats.size == 1);
+        getCFinfo(b, geom);
+        AMREX_ALWAYS_ASSERT(stats.nbuild == 7);
+
+        amrex::Print() << "passed!" << std::endl;
+    }
+    amrex::Finalize();
+}
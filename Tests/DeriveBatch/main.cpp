@@ -0,0 +1,252 @@
+
+#include <cmath>
+
+#include <AMReX.H>
+#include <AMReX_Amr.H>
+#include <AMReX_AmrLevel.H>
+#include <AMReX_LevelBld.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_PhysBCFunct.H>
+#include <AMReX_Print.H>
+#include <AMReX_PROB_AMR_F.H>
+
+using namespace amrex;
+
+extern "C" {
+    void amrex_probinit (const int* init,
+                         const int* name,
+                         const int* namelen,
+                         const amrex_real* problo,
+                         const amrex_real* probhi)
+    {}
+
+    // phis = (2 phi, 3 phi)
+    void derive_phis (Real* data, const int* dlo, const int* dhi, const int* nvar,
+                      const Real* compdat, const int* clo, const int* chi, const int* ncomp,
+                      const int* lo, const int* hi,
+                      const int* domain_lo, const int* domain_hi,
+                      const Real* delta, const Real* xlo,
+                      const Real* time, const Real* dt,
+                      const int* bcrec, const int* level, const int* grid_no)
+    {
+        const long dnx = dhi[0]-dlo[0]+1, dny = dhi[1]-dlo[1]+1, dnz = dhi[2]-dlo[2]+1;
+        const long cnx = chi[0]-clo[0]+1, cny = chi[1]-clo[1]+1;
+        for (int k = lo[2]; k <= hi[2]; ++k) {
+        for (int j = lo[1]; j <= hi[1]; ++j) {
+        for (int i = lo[0]; i <= hi[0]; ++i) {
+            const Real phi = compdat[(i-clo[0]) + cnx*((j-clo[1]) + cny*(k-clo[2]))];
+            const long d = (i-dlo[0]) + dnx*((j-dlo[1]) + dny*(k-dlo[2]));
+            data[d]             = 2.0*phi;
+            data[d+dnx*dny*dnz] = 3.0*phi;
+        }}}
+    }
+
+    // gradx = d psi / dx, centered, on the box grown by one
+    void derive_gradx (Real* data, const int* dlo, const int* dhi, const int* nvar,
+                       const Real* compdat, const int* clo, const int* chi, const int* ncomp,
+                       const int* lo, const int* hi,
+                       const int* domain_lo, const int* domain_hi,
+                       const Real* delta, const Real* xlo,
+                       const Real* time, const Real* dt,
+                       const int* bcrec, const int* level, const int* grid_no)
+    {
+        const long dnx = dhi[0]-dlo[0]+1, dny = dhi[1]-dlo[1]+1;
+        const long cnx = chi[0]-clo[0]+1, cny = chi[1]-clo[1]+1;
+        for (int k = lo[2]; k <= hi[2]; ++k) {
+        for (int j = lo[1]; j <= hi[1]; ++j) {
+        for (int i = lo[0]; i <= hi[0]; ++i) {
+            const long c = (i-clo[0]) + cnx*((j-clo[1]) + cny*(k-clo[2]));
+            data[(i-dlo[0]) + dnx*((j-dlo[1]) + dny*(k-dlo[2]))]
+                = (compdat[c+1] - compdat[c-1]) / (2.0*delta[0]);
+        }}}
+    }
+}
+
+namespace {
+
+CpuBndryFuncFab cpu_bndry_func(nullptr);
+
+void test_bcfill (Box const& bx, FArrayBox& data, const int dcomp, const int numcomp,
+                  Geometry const& geom, const Real time, const Vector<BCRec>& bcr,
+                  const int bcomp, const int scomp)
+{
+    cpu_bndry_func(bx, data, dcomp, numcomp, geom, time, bcr, bcomp, scomp);
+}
+
+}
+
+class TestLevel
+    : public AmrLevel
+{
+public:
+
+    enum StateType { State_Type = 0 };
+
+    TestLevel () {}
+
+    TestLevel (Amr& papa, int lev, const Geometry& level_geom, const BoxArray& ba,
+               const DistributionMapping& dm, Real time)
+        : AmrLevel(papa, lev, level_geom, ba, dm, time) {}
+
+    static void variableSetUp ()
+    {
+        desc_lst.addDescriptor(State_Type, IndexType::TheCellType(), StateDescriptor::Point,
+                               0, 2, &cell_cons_interp);
+        BCRec bc;
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+            bc.setLo(idim, BCType::foextrap);
+            bc.setHi(idim, BCType::foextrap);
+        }
+        StateDescriptor::BndryFunc bndryfunc(test_bcfill);
+        desc_lst.setComponent(State_Type, 0, "phi", bc, bndryfunc);
+        desc_lst.setComponent(State_Type, 1, "psi", bc, bndryfunc);
+
+        Vector<std::string> names = {"phi2", "phi3"};
+        derive_lst.add("phis", IndexType::TheCellType(), 2, names, derive_phis, DeriveRec::TheSameBox);
+        derive_lst.addComponent("phis", desc_lst, State_Type, 0, 1);
+
+        derive_lst.add("gradx", IndexType::TheCellType(), 1, derive_gradx, DeriveRec::GrowBoxByOne);
+        derive_lst.addComponent("gradx", desc_lst, State_Type, 1, 1);
+    }
+
+    static void variableCleanUp () { desc_lst.clear(); derive_lst.clear(); }
+
+    virtual void initData () override
+    {
+        MultiFab& S_new = get_new_data(State_Type);
+        const Real* dx = geom.CellSize();
+        for (MFIter mfi(S_new); mfi.isValid(); ++mfi) {
+            FArrayBox& fab = S_new[mfi];
+            for (BoxIterator bi(mfi.validbox()); bi.ok(); ++bi) {
+                Real x[AMREX_SPACEDIM];
+                for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                    x[idim] = (bi()[idim] + 0.5)*dx[idim];
+                }
+                fab(bi(), 0) = std::sin(3.0*x[0]) + x[1]*x[2];
+                fab(bi(), 1) = x[0]*x[0]*x[1] + std::cos(2.0*x[2]);
+            }
+        }
+    }
+
+    virtual void init (AmrLevel& old) override {}
+    virtual void init () override {}
+
+    virtual Real advance (Real time, Real dt, int iteration, int ncycle) override { return dt; }
+
+    virtual void post_timestep (int iteration) override {}
+
+    virtual void computeInitialDt (int finest_level, int sub_cycle, Vector<int>& n_cycle,
+                                   const Vector<IntVect>& ref_ratio, Vector<Real>& dt_level,
+                                   Real stop_time) override
+    {
+        for (int lev = 0; lev <= finest_level; ++lev) {
+            dt_level[lev] = 1.0;
+        }
+    }
+
+    virtual void computeNewDt (int finest_level, int sub_cycle, Vector<int>& n_cycle,
+                               const Vector<IntVect>& ref_ratio, Vector<Real>& dt_min,
+                               Vector<Real>& dt_level, Real stop_time, int post_regrid_flag) override {}
+
+    virtual void errorEst (TagBoxArray& tags, int clearval, int tagval, Real time,
+                           int n_error_buf, int ngrow) override
+    {
+        // A corner of the domain, so that the fine level has coarse/fine
+        // and physical boundaries.
+        const Real* dx = geom.CellSize();
+        for (MFIter mfi(tags); mfi.isValid(); ++mfi) {
+            TagBox& tb = tags[mfi];
+            for (BoxIterator bi(mfi.validbox()); bi.ok(); ++bi) {
+                bool tag = true;
+                for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                    tag = tag && (bi()[idim] + 0.5)*dx[idim] < 0.4;
+                }
+                if (tag) tb(bi()) = tagval;
+            }
+        }
+    }
+
+    virtual void post_regrid (int lbase, int new_finest) override {}
+    virtual void post_init (Real stop_time) override {}
+};
+
+class TestLevelBld
+    : public LevelBld
+{
+    virtual void variableSetUp () override { TestLevel::variableSetUp(); }
+    virtual void variableCleanUp () override { TestLevel::variableCleanUp(); }
+    virtual AmrLevel* operator() () override { return new TestLevel; }
+    virtual AmrLevel* operator() (Amr& papa, int lev, const Geometry& level_geom,
+                                  const BoxArray& ba, const DistributionMapping& dm,
+                                  Real time) override
+    {
+        return new TestLevel(papa, lev, level_geom, ba, dm, time);
+    }
+};
+
+TestLevelBld test_bld;
+
+LevelBld*
+getLevelBld ()
+{
+    return &test_bld;
+}
+
+// Compare AmrLevel::deriveBatch with one AmrLevel::derive call per
+// quantity, for state variables and derived quantities with and without
+// ghost cells of the source, on a two-level hierarchy.
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int ngrow = 1;
+        {
+            ParmParse pp;
+            pp.query("ngrow", ngrow);
+        }
+
+        Amr amr;
+        amr.init(0.0, -1.0);
+        AMREX_ALWAYS_ASSERT(amr.finestLevel() == 1);
+
+        const Vector<std::string> names = {"psi", "phis", "gradx", "phi"};
+        const int dcomp = 1;  // leave component 0 alone
+        const int ncomp = dcomp + 5;
+        const Real time = amr.cumTime();
+
+        for (int lev = 0; lev <= amr.finestLevel(); ++lev)
+        {
+            AmrLevel& level = amr.getLevel(lev);
+            MultiFab batch(amr.boxArray(lev), amr.DistributionMap(lev), ncomp, ngrow);
+            MultiFab separate(amr.boxArray(lev), amr.DistributionMap(lev), ncomp, ngrow);
+            batch.setVal(-1.0);
+            separate.setVal(-1.0);
+
+            level.deriveBatch(names, time, batch, dcomp);
+            int dc = dcomp;
+            for (const auto& name : names) {
+                level.derive(name, time, separate, dc);
+                const DeriveRec* rec = level.get_derive_lst().get(name);
+                dc += rec ? rec->numDerive() : 1;
+            }
+
+            // The state variables are the state data on the valid cells.
+            const MultiFab& S = level.get_new_data(TestLevel::State_Type);
+            for (MFIter mfi(S); mfi.isValid(); ++mfi) {
+                for (BoxIterator bi(mfi.validbox()); bi.ok(); ++bi) {
+                    AMREX_ALWAYS_ASSERT(separate[mfi](bi(),dcomp)   == S[mfi](bi(),1));
+                    AMREX_ALWAYS_ASSERT(separate[mfi](bi(),dcomp+4) == S[mfi](bi(),0));
+                }
+            }
+
+            MultiFab::Subtract(batch, separate, 0, 0, ncomp, ngrow);
+            for (int n = 0; n < ncomp; ++n) {
+                AMREX_ALWAYS_ASSERT(batch.norm0(n, ngrow) <= 1.e-12);
+            }
+            amrex::Print() << "level " << lev << " " << amr.boxArray(lev).size() << " grids match\n";
+        }
+
+        amrex::Print() << "passed!" << std::endl;
+    }
+    amrex::Finalize();
+}
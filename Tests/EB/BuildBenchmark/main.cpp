@@ -0,0 +1,87 @@
+
+#include <iomanip>
+
+#include <AMReX.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+#include <AMReX_EB2.H>
+#include <AMReX_EB2_IF_Sphere.H>
+#include <AMReX_EBFabFactory.H>
+
+using namespace amrex;
+
+// Time EB2::Build and the factories of the coarse levels an MLMG solver
+// would use, for eager and lazy construction of the coarse levels.
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 128, max_grid_size = 32;
+        Vector<int> max_coarsening_levels {0, 1, 2, 3, 4};
+        int mg_levels = 2;
+        Real radius = 0.3;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.queryarr("max_coarsening_levels", max_coarsening_levels);
+            pp.query("mg_levels", mg_levels);
+            pp.query("radius", radius);
+        }
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        RealBox rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        Geometry geom(domain, &rb);
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        EB2::SphereIF sphere(radius, {AMREX_D_DECL(0.5,0.5,0.5)}, false);
+        EB2::GeometryShop<EB2::SphereIF> gshop(sphere);
+
+        const bool lazy_default = EB2::lazy_coarsening;
+
+        amrex::Print() << "n_cell " << n_cell << ", max_grid_size " << max_grid_size
+                       << ", mg_levels " << mg_levels << "\n"
+                       << "  max_coarsening_level     lazy    EB2::Build   coarse factories\n";
+
+        for (int max_coarsening_level : max_coarsening_levels)
+        {
+            for (int lazy = 0; lazy <= 1; ++lazy)
+            {
+                EB2::lazy_coarsening = lazy;
+
+                ParallelDescriptor::Barrier();
+                Real t0 = amrex::second();
+                EB2::Build(gshop, geom, 0, max_coarsening_level);
+                Real t_build = amrex::second() - t0;
+
+                t0 = amrex::second();
+                const int nlev = std::min(mg_levels, EB2::maxCoarseningLevel(geom));
+                for (int ilev = 1; ilev <= nlev; ++ilev)
+                {
+                    const int rr = 1 << ilev;
+                    Geometry cgeom(amrex::coarsen(domain,rr), &rb);
+                    auto factory = makeEBFabFactory(cgeom, amrex::coarsen(ba,rr), dm,
+                                                    {2,2,2}, EBSupport::full);
+                }
+                Real t_factory = amrex::second() - t0;
+
+                ParallelDescriptor::ReduceRealMax(t_build);
+                ParallelDescriptor::ReduceRealMax(t_factory);
+
+                amrex::Print() << "  " << std::setw(20) << max_coarsening_level
+                               << std::setw(9) << lazy
+                               << std::setw(14) << t_build
+                               << std::setw(19) << t_factory << "\n";
+
+                EB2::IndexSpace::pop();
+            }
+        }
+
+        EB2::lazy_coarsening = lazy_default;
+    }
+    amrex::Finalize();
+}
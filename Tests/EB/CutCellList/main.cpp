@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include <AMReX.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_MultiFabUtil_C.H>
+#include <AMReX_Print.H>
+
+#include <AMReX_EB2.H>
+#include <AMReX_EB2_IF_Sphere.H>
+#include <AMReX_EBFabFactory.H>
+#include <AMReX_EBCutCellList.H>
+#include <AMReX_EBMultiFabUtil.H>
+#include <AMReX_EBMultiFabUtil_F.H>
+
+using namespace amrex;
+
+int makeMultiValued (const EBFArrayBoxFactory& factory, int stride);
+void checkLists (const EBFArrayBoxFactory& factory, std::mt19937& gen);
+void checkSetCovered (const EBFArrayBoxFactory& factory, const MultiFab& S);
+void checkAverageDown (const EBFArrayBoxFactory& factory, const MultiFab& S,
+                       const BoxArray& cba, const DistributionMapping& cdm);
+
+// Compare the paths driven by the cut cell lists of EBFArrayBoxFactory
+// with the full box paths they replace: the box types used by
+// EBFluxRegister::Reflux and EB_average_down, EB_set_covered, and
+// EB_average_down onto the coarsened grids and onto other grids.  Then
+// again after some singlevalued boxes are made multivalued, which have no
+// lists; EB_average_down onto other grids does not support those.
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 64, max_grid_size = 16, multivalued_stride = 3;
+        Real radius = 0.3;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("radius", radius);
+            pp.query("multivalued_stride", multivalued_stride);
+        }
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        RealBox rb({0.,0.,0.}, {1.,1.,1.});
+        Geometry geom(domain, &rb);
+        EB2::SphereIF sphere(radius, {0.5,0.5,0.5}, false);
+        EB2::Build(EB2::makeShop(sphere), geom, 0, 0);
+
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+        auto factory = makeEBFabFactory(geom, ba, dm, {2,2,2}, EBSupport::full);
+
+        const int ncomp = 2;
+        MultiFab S(ba, dm, ncomp, 2, MFInfo(), *factory);
+        for (MFIter mfi(S); mfi.isValid(); ++mfi)
+        {
+            for (BoxIterator bi(mfi.fabbox()); bi.ok(); ++bi)
+            {
+                const IntVect& iv = bi();
+                S[mfi](iv,0) = std::sin(0.3*iv[0] + 0.2*iv[1]) + 0.01*iv[2];
+                S[mfi](iv,1) = std::cos(0.1*iv[0]*iv[2]) - 0.5*iv[1];
+            }
+        }
+
+        const BoxArray cba = amrex::coarsen(ba, 2);
+        BoxArray cba2(cba.minimalBox());
+        cba2.maxSize(max_grid_size);
+        AMREX_ALWAYS_ASSERT(cba2 != cba);
+        const DistributionMapping dm2(cba2);
+
+        std::mt19937 gen(5);
+        checkLists(*factory, gen);
+        checkAverageDown(*factory, S, cba, dm);
+        checkAverageDown(*factory, S, cba2, dm2);
+        checkSetCovered(*factory, S);
+
+        int nmv = makeMultiValued(*factory, multivalued_stride);
+        ParallelDescriptor::ReduceIntSum(nmv);
+        AMREX_ALWAYS_ASSERT(multivalued_stride <= 0 || nmv > 0);
+
+        checkLists(*factory, gen);
+        checkAverageDown(*factory, S, cba, dm);
+        checkSetCovered(*factory, S);
+
+        amrex::Print() << nmv << " multivalued boxes\n";
+        amrex::Print() << "passed!" << std::endl;
+    }
+    amrex::Finalize();
+}
+
+// Give every stride-th singlevalued box a multivalued cell, as if EB2 had
+// made it, and redefine its cut cell list, which is then empty.
+int
+makeMultiValued (const EBFArrayBoxFactory& factory, int stride)
+{
+    if (stride <= 0) return 0;
+
+    auto& flags    = const_cast<FabArray<EBCellFlagFab>&>(factory.getMultiEBCellFlagFab());
+    auto& cutcells = const_cast<LayoutData<EBCutCellList>&>(factory.getCutCellList());
+
+    int nsv = 0, nmv = 0;
+    for (MFIter mfi(flags); mfi.isValid(); ++mfi)
+    {
+        EBCellFlagFab& flag = flags[mfi];
+        if (flag.getType() != FabType::singlevalued || nsv++ % stride != 0) continue;
+        for (BoxIterator bi(mfi.validbox()); bi.ok(); ++bi)
+        {
+            if (flag(bi()).isSingleValued())
+            {
+                flag(bi()).setMultiValued(2);
+                flag.setType(FabType::multivalued);
+                cutcells[mfi].define(flag);
+                AMREX_ALWAYS_ASSERT(cutcells[mfi].numCutCells() == 0);
+                ++nmv;
+                break;
+            }
+        }
+    }
+    return nmv;
+}
+
+// The lists against the flags, and the box types from the lists against
+// the types counted from the flags, on tiles, grown tiles and random boxes.
+void
+checkLists (const EBFArrayBoxFactory& factory, std::mt19937& gen)
+{
+    const auto& flags    = factory.getMultiEBCellFlagFab();
+    const auto& cutcells = factory.getCutCellList();
+
+    for (MFIter mfi(flags); mfi.isValid(); ++mfi)
+    {
+        const EBCellFlagFab& flag = flags[mfi];
+        const EBCutCellList& cl = cutcells[mfi];
+        const Box& fbx = flag.box();
+
+        if (flag.getType() == FabType::singlevalued)
+        {
+            long ncut = 0, ncovered = 0;
+            for (BoxIterator bi(fbx); bi.ok(); ++bi) {
+                if (flag(bi()).isSingleValued()) ++ncut;
+                if (flag(bi()).isCovered()) ++ncovered;
+            }
+            AMREX_ALWAYS_ASSERT(cl.numCutCells() == ncut);
+            for (const IntVect& iv : cl.cutCells()) {
+                AMREX_ALWAYS_ASSERT(flag(iv).isSingleValued());
+            }
+            for (const EBCellRun& run : cl.coveredRuns()) {
+                for (int i = 0; i < run.len; ++i) {
+                    IntVect iv = run.lo;
+                    iv[0] += i;
+                    AMREX_ALWAYS_ASSERT(flag(iv).isCovered());
+                    --ncovered;
+                }
+            }
+            AMREX_ALWAYS_ASSERT(ncovered == 0);
+        }
+
+        std::uniform_int_distribution<int> dist(0, fbx.length(0)-1);
+        for (int n = 0; n < 50; ++n)
+        {
+            IntVect lo, hi;
+            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                const int a = fbx.smallEnd(idim) + dist(gen);
+                const int b = fbx.smallEnd(idim) + dist(gen);
+                lo[idim] = std::min(a,b);
+                hi[idim] = std::max(a,b);
+            }
+            const Box bx(lo,hi);
+            AMREX_ALWAYS_ASSERT(getFabType(flag, cl, bx) == flag.getType(bx));
+        }
+    }
+
+    for (MFIter mfi(flags,true); mfi.isValid(); ++mfi)
+    {
+        const EBCellFlagFab& flag = flags[mfi];
+        for (int ng = 0; ng <= 2; ++ng)
+        {
+            const Box& bx = amrex::grow(mfi.tilebox(), ng) & flag.box();
+            AMREX_ALWAYS_ASSERT(getFabType(flag, cutcells[mfi], bx) == flag.getType(bx));
+        }
+    }
+}
+
+// EB_set_covered against amrex_eb_set_covered on every tile
+void
+checkSetCovered (const EBFArrayBoxFactory& factory, const MultiFab& S)
+{
+    const auto& flags = factory.getMultiEBCellFlagFab();
+    const int ncomp = S.nComp();
+    const int ngrow = S.nGrow();
+    const Vector<Real> vals {-1.0, 7.0};
+
+    MultiFab mf(S.boxArray(), S.DistributionMap(), ncomp, ngrow, MFInfo(), factory);
+    MultiFab ref(S.boxArray(), S.DistributionMap(), ncomp, ngrow);
+    MultiFab::Copy(mf,  S, 0, 0, ncomp, ngrow);
+    MultiFab::Copy(ref, S, 0, 0, ncomp, ngrow);
+
+    EB_set_covered(mf, 0, ncomp, vals);
+
+    for (MFIter mfi(ref,true); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.tilebox();
+        amrex_eb_set_covered(BL_TO_FORTRAN_BOX(bx),
+                             BL_TO_FORTRAN_N_ANYD(ref[mfi],0),
+                             BL_TO_FORTRAN_ANYD(flags[mfi]),
+                             vals.data(), &ncomp);
+    }
+
+    MultiFab::Subtract(ref, mf, 0, 0, ncomp, ngrow);
+    for (int n = 0; n < ncomp; ++n) {
+        AMREX_ALWAYS_ASSERT(ref.norm0(n, ngrow) == 0.0);
+    }
+}
+
+// EB_average_down onto cba against amrex_avgdown on the regular and
+// covered tiles and amrex_eb_avgdown on the others, computed on the
+// coarsened fine grids.
+void
+checkAverageDown (const EBFArrayBoxFactory& factory, const MultiFab& S,
+                  const BoxArray& cba, const DistributionMapping& cdm)
+{
+    const auto& flags = factory.getMultiEBCellFlagFab();
+    const auto& vfrac = factory.getVolFrac();
+    const int ncomp = S.nComp();
+    const IntVect ratio(2);
+
+    MultiFab fine_ref(amrex::coarsen(S.boxArray(), ratio), S.DistributionMap(), ncomp, 0);
+    for (MFIter mfi(fine_ref,true); mfi.isValid(); ++mfi)
+    {
+        const Box& tbx = mfi.tilebox();
+        const FabType typ = flags[mfi].getType(amrex::refine(tbx,ratio));
+        if (typ == FabType::regular || typ == FabType::covered)
+        {
+            amrex_avgdown(tbx, fine_ref[mfi], S[mfi], 0, 0, ncomp, ratio);
+        }
+        else
+        {
+            amrex_eb_avgdown(BL_TO_FORTRAN_BOX(tbx),
+                             BL_TO_FORTRAN_N_ANYD(S[mfi],0),
+                             BL_TO_FORTRAN_N_ANYD(fine_ref[mfi],0),
+                             BL_TO_FORTRAN_ANYD(vfrac[mfi]),
+                             ratio.getVect(), &ncomp);
+        }
+    }
+
+    MultiFab ref(cba, cdm, ncomp, 0);
+    ref.ParallelCopy(fine_ref);
+
+    MultiFab crse(cba, cdm, ncomp, 0);
+    EB_average_down(S, crse, 0, ncomp, ratio);
+    MultiFab::Subtract(crse, ref, 0, 0, ncomp, 0);
+    for (int n = 0; n < ncomp; ++n) {
+        AMREX_ALWAYS_ASSERT(crse.norm0(n) <= 1.e-14*ref.norm0(n));
+    }
+}
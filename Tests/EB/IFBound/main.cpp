@@ -0,0 +1,179 @@
+#include <array>
+#include <cmath>
+#include <random>
+
+#include <AMReX.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+#include <AMReX_EB2.H>
+#include <AMReX_EB2_IF_Box.H>
+#include <AMReX_EB2_IF_Cylinder.H>
+#include <AMReX_EB2_IF_Difference.H>
+#include <AMReX_EB2_IF_Intersection.H>
+#include <AMReX_EB2_IF_Plane.H>
+#include <AMReX_EB2_IF_Scale.H>
+#include <AMReX_EB2_IF_Sphere.H>
+#include <AMReX_EB2_IF_Union.H>
+#include <AMReX_EBFabFactory.H>
+
+using namespace amrex;
+
+namespace {
+
+// f without its bound, classified node by node
+template <class F>
+struct NoBoundIF
+{
+    F f;
+
+    Real operator() (const RealArray& p) const { return f(p); }
+};
+
+// A wavy surface, body above, that has no bound
+struct WavyIF
+{
+    Real operator() (const RealArray& p) const {
+        return p[2] - 0.9 - 0.04*std::sin(20.0*p[0]);
+    }
+};
+
+RealArray
+nodePos (const IntVect& iv, const Geometry& geom)
+{
+    const Real* problo = geom.ProbLo();
+    const Real* dx = geom.CellSize();
+    return RealArray{AMREX_D_DECL(problo[0]+iv[0]*dx[0],
+                                  problo[1]+iv[1]*dx[1],
+                                  problo[2]+iv[2]*dx[2])};
+}
+
+// Random boxes of nodes, and the grids EB2::Build classifies: the box type
+// from the bounds is the box type from every node, and the bound over a box
+// contains the function at its nodes.  Then EB2::Build must make the same
+// cells with and without the bounds.
+template <class F>
+void
+checkIF (const std::string& name, F const& f, const Geometry& geom, int max_grid_size,
+         int nboxes, std::mt19937& gen)
+{
+    const auto shop = EB2::makeShop(f);
+    const auto ref  = EB2::makeShop(NoBoundIF<F>{f});
+    using Shop = decltype(shop);
+
+    const Box nodes = amrex::surroundingNodes(geom.Domain());
+    BoxArray ba(geom.Domain());
+    ba.maxSize(max_grid_size);
+
+    Vector<Box> boxes;
+    for (int i = 0; i < ba.size(); ++i) {
+        boxes.push_back(amrex::surroundingNodes(ba[i]));
+    }
+    // every other box no longer than a grid
+    for (int n = 0; n < nboxes; ++n)
+    {
+        IntVect lo, hi;
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+            std::uniform_int_distribution<int> len(1, (n%2 == 0) ? max_grid_size+1
+                                                                 : nodes.length(idim));
+            const int l = len(gen);
+            std::uniform_int_distribution<int> start(0, nodes.length(idim)-l);
+            lo[idim] = nodes.smallEnd(idim) + start(gen);
+            hi[idim] = lo[idim] + l - 1;
+        }
+        boxes.push_back(Box(lo,hi));
+    }
+
+    std::array<int,3> count {0, 0, 0};
+    for (const Box& bx : boxes)
+    {
+        const int t = shop.getBoxType(bx, geom);
+        AMREX_ALWAYS_ASSERT(t == ref.getBoxType(bx, geom));
+        ++count[t-Shop::allregular];
+
+        const EB2::IFInterval b = EB2::IF_bound(f, nodePos(bx.smallEnd(),geom),
+                                                   nodePos(bx.bigEnd(),geom));
+        AMREX_ALWAYS_ASSERT(!b.isUnbounded());
+        for (BoxIterator bi(bx); bi.ok(); ++bi) {
+            const Real v = f(nodePos(bi(),geom));
+            AMREX_ALWAYS_ASSERT(b.lo <= v && v <= b.hi);
+        }
+    }
+    AMREX_ALWAYS_ASSERT(count[0] > 0 && count[1] > 0 && count[2] > 0);
+
+    DistributionMapping dm(ba);
+    EB2::Build(shop, geom, 0, 0);
+    auto factory = makeEBFabFactory(geom, ba, dm, {1,1,1}, EBSupport::volume);
+    EB2::Build(ref, geom, 0, 0);
+    auto ref_factory = makeEBFabFactory(geom, ba, dm, {1,1,1}, EBSupport::volume);
+
+    const auto& flags     = factory->getMultiEBCellFlagFab();
+    const auto& ref_flags = ref_factory->getMultiEBCellFlagFab();
+    for (MFIter mfi(flags); mfi.isValid(); ++mfi)
+    {
+        AMREX_ALWAYS_ASSERT(flags[mfi].getType() == ref_flags[mfi].getType());
+        for (BoxIterator bi(flags[mfi].box()); bi.ok(); ++bi) {
+            AMREX_ALWAYS_ASSERT(flags[mfi](bi()) == ref_flags[mfi](bi()));
+        }
+    }
+    MultiFab vfrac(ba, dm, 1, 0);
+    MultiFab::Copy(vfrac, factory->getVolFrac(), 0, 0, 1, 0);
+    MultiFab::Subtract(vfrac, ref_factory->getVolFrac(), 0, 0, 1, 0);
+    AMREX_ALWAYS_ASSERT(vfrac.norm0() == 0.0);
+
+    amrex::Print() << name << ": " << count[0] << " regular, " << count[1] << " cut, "
+                   << count[2] << " covered\n";
+}
+
+}
+
+// Classify boxes of nodes with the bounds of composite implicit functions,
+// and compare with classifying them node by node.
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 64, max_grid_size = 16, nboxes = 2000;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("nboxes", nboxes);
+        }
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        RealBox rb({0.,0.,0.}, {1.,1.,1.});
+        Geometry geom(domain, &rb);
+        std::mt19937 gen(11);
+
+        const auto u = EB2::makeUnion(EB2::SphereIF(0.2, {0.6,0.6,0.6}, false),
+                                      EB2::BoxIF({0.1,0.1,0.1}, {0.3,0.4,0.3}, false),
+                                      EB2::CylinderIF(0.1, 0.6, 2, {0.75,0.25,0.5}, false));
+        checkIF("union", u, geom, max_grid_size, nboxes, gen);
+
+        // a pipe through a spherical vessel
+        const auto i = EB2::makeIntersection(EB2::SphereIF(0.3, {0.5,0.5,0.5}, true),
+                                             EB2::CylinderIF(0.15, 0, {0.5,0.45,0.5}, true));
+        checkIF("intersection", i, geom, max_grid_size, nboxes, gen);
+
+        const auto d = EB2::makeDifference(EB2::BoxIF({0.2,0.2,0.2}, {0.8,0.8,0.8}, false),
+                                           EB2::SphereIF(0.3, {0.8,0.8,0.8}, false));
+        checkIF("difference", d, geom, max_grid_size, nboxes, gen);
+
+        // mirrored in y
+        const auto s = EB2::scale(EB2::makeUnion(EB2::SphereIF(0.2, {0.4,-0.5,0.3}, false),
+                                                 EB2::CylinderIF(0.15, 0.5, 0, {0.5,-0.2,0.4}, false)),
+                                  {1.2, -0.8, 1.5});
+        checkIF("scale", s, geom, max_grid_size, nboxes, gen);
+
+        // WavyIF has no bound, so the union only has a lower bound
+        const auto c = EB2::makeDifference(EB2::makeUnion(d, WavyIF()),
+                                           EB2::scale(EB2::SphereIF(0.15, {0.4,-0.6,0.3}, false),
+                                                      {1.2, -0.8, 1.5}));
+        checkIF("composite", c, geom, max_grid_size, nboxes, gen);
+
+        amrex::Print() << "passed!" << std::endl;
+    }
+    amrex::Finalize();
+}
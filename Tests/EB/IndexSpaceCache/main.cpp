@@ -0,0 +1,119 @@
+#include <AMReX.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+#include <AMReX_Utility.H>
+#include <AMReX_EB2.H>
+#include <AMReX_EBFabFactory.H>
+
+using namespace amrex;
+
+void compareFactories (const EBFArrayBoxFactory& a, const EBFArrayBoxFactory& b);
+void compareCutFabs (const MultiCutFab& a, const MultiCutFab& b);
+
+// Build the EB index space of eb2.geom_type, which writes it to
+// eb2.cache_dir, build it again, which reads it back, and check that every
+// level of both has the same EB data.  A different eb2.cache_key must
+// generate the index space again.
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int n_cell = 64;
+        int max_grid_size = 16;
+        int max_coarsening_level = 3;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("max_coarsening_level", max_coarsening_level);
+        }
+
+        AMREX_ALWAYS_ASSERT(!EB2::cache_dir.empty());
+        if (ParallelDescriptor::IOProcessor()) {
+            amrex::UtilCreateCleanDirectory(EB2::cache_dir, false);
+        }
+        ParallelDescriptor::Barrier();
+
+        RealBox rb({0.,0.,0.}, {1.,1.,1.});
+        Geometry geom(Box(IntVect(0), IntVect(n_cell-1)), &rb);
+
+        EB2::Build(geom, 0, max_coarsening_level);
+        const EB2::IndexSpace& generated = EB2::IndexSpace::top();
+        AMREX_ALWAYS_ASSERT(dynamic_cast<const EB2::IndexSpaceFile*>(&generated) == nullptr);
+
+        EB2::Build(geom, 0, max_coarsening_level);
+        const EB2::IndexSpace& cached = EB2::IndexSpace::top();
+        AMREX_ALWAYS_ASSERT(dynamic_cast<const EB2::IndexSpaceFile*>(&cached) != nullptr);
+        AMREX_ALWAYS_ASSERT(!EB2::cacheMatches(EB2::cache_dir, "not_a_key"));
+
+        Geometry cgeom = geom;
+        for (int ilev = 0; ilev <= max_coarsening_level; ++ilev)
+        {
+            BoxArray ba(cgeom.Domain());
+            ba.maxSize(max_grid_size);
+            DistributionMapping dm(ba);
+            EBFArrayBoxFactory a(generated.getLevel(cgeom), cgeom, ba, dm, {2,2,2}, EBSupport::full);
+            EBFArrayBoxFactory b(cached.getLevel(cgeom), cgeom, ba, dm, {2,2,2}, EBSupport::full);
+            compareFactories(a, b);
+            amrex::Print() << "level " << ilev << " " << cgeom.Domain() << " matches\n";
+
+            Box cdomain = cgeom.Domain();
+            cdomain.coarsen(2);
+            cgeom = Geometry(cdomain, &rb);
+        }
+
+        EB2::cache_key = "another geometry";
+        EB2::Build(geom, 0, max_coarsening_level);
+        AMREX_ALWAYS_ASSERT(dynamic_cast<const EB2::IndexSpaceFile*>(&EB2::IndexSpace::top()) == nullptr);
+
+        amrex::Print() << "passed!" << std::endl;
+    }
+    amrex::Finalize();
+}
+
+void
+compareFactories (const EBFArrayBoxFactory& a, const EBFArrayBoxFactory& b)
+{
+    const auto& aflag = a.getMultiEBCellFlagFab();
+    const auto& bflag = b.getMultiEBCellFlagFab();
+    for (MFIter mfi(aflag); mfi.isValid(); ++mfi)
+    {
+        AMREX_ALWAYS_ASSERT(aflag[mfi].getType() == bflag[mfi].getType());
+        const Box& bx = aflag[mfi].box();
+        for (BoxIterator bi(bx); bi.ok(); ++bi) {
+            AMREX_ALWAYS_ASSERT(aflag[mfi](bi()) == bflag[mfi](bi()));
+        }
+    }
+
+    MultiFab diff(a.getVolFrac().boxArray(), a.getVolFrac().DistributionMap(), 1, 2);
+    MultiFab::Copy(diff, a.getVolFrac(), 0, 0, 1, 2);
+    MultiFab::Subtract(diff, b.getVolFrac(), 0, 0, 1, 2);
+    AMREX_ALWAYS_ASSERT(diff.norm0(0, 2) == 0.0);
+
+    compareCutFabs(a.getCentroid(),    b.getCentroid());
+    compareCutFabs(a.getBndryCent(),   b.getBndryCent());
+    compareCutFabs(a.getBndryNormal(), b.getBndryNormal());
+    compareCutFabs(a.getBndryArea(),   b.getBndryArea());
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+        compareCutFabs(*a.getAreaFrac()[idim], *b.getAreaFrac()[idim]);
+        compareCutFabs(*a.getFaceCent()[idim], *b.getFaceCent()[idim]);
+    }
+}
+
+void
+compareCutFabs (const MultiCutFab& a, const MultiCutFab& b)
+{
+    for (MFIter mfi(a.boxArray(), a.DistributionMap()); mfi.isValid(); ++mfi)
+    {
+        AMREX_ALWAYS_ASSERT(a.ok(mfi) == b.ok(mfi));
+        if (!a.ok(mfi)) continue;
+        const CutFab& fa = a[mfi];
+        const CutFab& fb = b[mfi];
+        AMREX_ALWAYS_ASSERT(fa.box() == fb.box() && fa.nComp() == fb.nComp());
+        for (int n = 0; n < fa.nComp(); ++n) {
+            for (BoxIterator bi(fa.box()); bi.ok(); ++bi) {
+                AMREX_ALWAYS_ASSERT(fa(bi(),n) == fb(bi(),n));
+            }
+        }
+    }
+}
@@ -0,0 +1,261 @@
+
+#include <random>
+
+#include <AMReX.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+#include <AMReX_EB2.H>
+#include <AMReX_EBFabFactory.H>
+#include <AMReX_EB_levelset.H>
+#include <AMReX_EB_utils.H>
+#include <AMReX_EB_F.H>
+
+using namespace amrex;
+
+// Union of solid spheres (>0 inside the spheres => body)
+class SpherePackIF
+{
+public:
+    SpherePackIF (const Vector<RealArray>& centers, Real radius)
+        : m_centers(centers), m_radius2(radius*radius) {}
+
+    Real operator() (const RealArray& p) const {
+        Real r = std::numeric_limits<Real>::lowest();
+        for (const auto& c : m_centers) {
+            const Real d2 = AMREX_D_TERM(  (p[0]-c[0])*(p[0]-c[0]),
+                                         + (p[1]-c[1])*(p[1]-c[1]),
+                                         + (p[2]-c[2])*(p[2]-c[2]));
+            r = std::max(r, m_radius2 - d2);
+        }
+        return r;
+    }
+
+private:
+    Vector<RealArray> m_centers;
+    Real m_radius2;
+};
+
+Vector<RealArray>
+make_packing (int n_spheres, Real radius)
+{
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<Real> dist(radius, 1.0-radius);
+
+    Vector<RealArray> centers;
+    int n_tries = 0;
+    while (centers.size() < n_spheres && n_tries < 1000*n_spheres) {
+        ++n_tries;
+        RealArray c {AMREX_D_DECL(dist(gen), dist(gen), dist(gen))};
+        bool overlap = false;
+        for (const auto& o : centers) {
+            const Real d2 = AMREX_D_TERM(  (c[0]-o[0])*(c[0]-o[0]),
+                                         + (c[1]-o[1])*(c[1]-o[1]),
+                                         + (c[2]-o[2])*(c[2]-o[2]));
+            if (d2 < 9.0*radius*radius) { overlap = true; break; }
+        }
+        if (!overlap) centers.push_back(c);
+    }
+    return centers;
+}
+
+// Compare LSFactory::fill_levelset against amrex_eb_fill_levelset with the
+// full facet list of each box, without a narrow band and, inside the band,
+// with the narrow band of `narrow_band` EB cells
+void
+check_fill (const LSFactory& level_set, const EBFArrayBoxFactory& eb_factory, int narrow_band)
+{
+    const Geometry& geom_eb = level_set.get_eb_geom();
+    const int ls_ref = level_set.get_ls_ref();
+    const int eb_ref = level_set.get_eb_ref();
+    const int eb_pad = level_set.get_eb_pad();
+
+    RealVect dx(AMREX_D_DECL(level_set.get_ls_geom().CellSize()[0],
+                             level_set.get_ls_geom().CellSize()[1],
+                             level_set.get_ls_geom().CellSize()[2]));
+    RealVect dx_eb(AMREX_D_DECL(geom_eb.CellSize()[0],
+                                geom_eb.CellSize()[1],
+                                geom_eb.CellSize()[2]));
+
+    MultiFab normal(level_set.get_eb_ba(), level_set.get_dm(), 3, eb_pad);
+    FillEBNormals(normal, eb_factory, geom_eb);
+
+    const auto& flags = eb_factory.getMultiEBCellFlagFab();
+    const MultiCutFab& bndrycent = eb_factory.getBndryCent();
+    const MultiFab& ls = * level_set.get_data();
+
+    const Real band = narrow_band * dx_eb[dx_eb.minDir(false)];
+
+    Real t_full = 0., t_index = 0., max_diff = 0.;
+    long n_valid_diff = 0, n_band = 0;
+
+    for (MFIter mfi(ls); mfi.isValid(); ++mfi) {
+        if (! bndrycent.ok(mfi)) continue;
+
+        const Box& bx = mfi.validbox();
+
+        Box eb_search = bx;
+        eb_search.coarsen(ls_ref);
+        eb_search.refine(eb_ref);
+        eb_search.enclosedCells();
+        eb_search.grow(eb_pad);
+
+        std::unique_ptr<Vector<Real>> facets =
+            LSFactory::eb_facets(normal[mfi], bndrycent[mfi], flags[mfi], dx_eb, eb_search);
+        int len_facets = facets->size();
+        if (len_facets == 0) continue;
+
+        FArrayBox phi_full(bx), phi_index(bx), phi_band(bx);
+        IArrayBox v_full(bx), v_index(bx), v_band(bx);
+
+        Real t0 = amrex::second();
+        amrex_eb_fill_levelset(BL_TO_FORTRAN_BOX(bx), facets->dataPtr(), & len_facets,
+                               BL_TO_FORTRAN_3D(v_full), BL_TO_FORTRAN_3D(phi_full),
+                               dx.dataPtr(), dx_eb.dataPtr());
+        Real t1 = amrex::second();
+        EBFacetIndex facet_index(* facets, LSFactory::facet_bucket_size(dx_eb));
+        LSFactory::fill_levelset(bx, facet_index, v_index, phi_index, dx, dx_eb);
+        Real t2 = amrex::second();
+
+        t_full  += t1 - t0;
+        t_index += t2 - t1;
+
+        if (narrow_band > 0) {
+            LSFactory::fill_levelset(bx, facet_index, v_band, phi_band, dx, dx_eb, band);
+        }
+
+        for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+            max_diff = std::max(max_diff, std::abs(phi_full(iv) - phi_index(iv)));
+            if (v_full(iv) != v_index(iv)) ++n_valid_diff;
+            // Nodes closer to a facet than the band must not be cut off
+            if (narrow_band > 0 && std::abs(phi_full(iv)) < band) {
+                AMREX_ALWAYS_ASSERT(phi_band(iv) == phi_full(iv) && v_band(iv) == v_full(iv));
+                ++n_band;
+            }
+        }
+    }
+
+    ParallelDescriptor::ReduceRealMax(max_diff);
+    ParallelDescriptor::ReduceRealMax(t_full);
+    ParallelDescriptor::ReduceRealMax(t_index);
+    ParallelDescriptor::ReduceLongSum(n_valid_diff);
+    ParallelDescriptor::ReduceLongSum(n_band);
+
+    amrex::Print() << "  check: full facet scan " << t_full << " s, indexed " << t_index << " s\n"
+                   << "  check: max |phi_full - phi_index| = " << max_diff
+                   << ", valid mismatches = " << n_valid_diff << "\n"
+                   << "  check: " << n_band << " nodes inside the narrow band match\n";
+
+    AMREX_ALWAYS_ASSERT(max_diff == 0. && n_valid_diff == 0);
+}
+
+// A single facet on the diagonal plane x = y of the EB cell [0,1]^3, with its
+// centre at the corner at the origin: the level-set nodes near the opposite
+// corner are on the facet but more than half a cell diagonal from its centre,
+// so the narrow band must not cut them off
+void
+check_band_corner ()
+{
+    const Real s = 1. / std::sqrt(2.);
+    const Vector<Real> facet {0.001, 0.001, 0.001, s, -s, 0.};
+    int len_facets = facet.size();
+
+    const RealVect dx(AMREX_D_DECL(0.05, 0.05, 0.05));
+    const RealVect dx_eb(AMREX_D_DECL(1., 1., 1.));
+    const Real band = 0.45;
+    const Box bx(IntVect(0), IntVect(19), IndexType::TheNodeType());
+
+    FArrayBox phi_full(bx), phi_band(bx);
+    IArrayBox v_full(bx), v_band(bx);
+    amrex_eb_fill_levelset(BL_TO_FORTRAN_BOX(bx), facet.dataPtr(), & len_facets,
+                           BL_TO_FORTRAN_3D(v_full), BL_TO_FORTRAN_3D(phi_full),
+                           dx.dataPtr(), dx_eb.dataPtr());
+    EBFacetIndex facet_index(facet, LSFactory::facet_bucket_size(dx_eb));
+    LSFactory::fill_levelset(bx, facet_index, v_band, phi_band, dx, dx_eb, band);
+
+    for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+        if (std::abs(phi_full(iv)) < band) {
+            AMREX_ALWAYS_ASSERT(phi_band(iv) == phi_full(iv) && v_band(iv) == v_full(iv));
+        }
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 64, max_grid_size = 32;
+        int n_spheres = 200;
+        Real radius = 0.04;
+        int ls_ref = 2, eb_ref = 1, eb_pad = 2;
+        int narrow_band = 4;
+        int check = 1;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("n_spheres", n_spheres);
+            pp.query("radius", radius);
+            pp.query("ls_ref", ls_ref);
+            pp.query("eb_ref", eb_ref);
+            pp.query("eb_pad", eb_pad);
+            pp.query("narrow_band", narrow_band);
+            pp.query("check", check);
+        }
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        RealBox rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        Geometry geom(domain, &rb);
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        Vector<RealArray> centers = make_packing(n_spheres, radius);
+        amrex::Print() << "Sphere packing: " << centers.size() << " spheres of radius " << radius << "\n";
+
+        LSFactory level_set(0, ls_ref, eb_ref, 1, eb_pad, ba, geom, dm);
+        Geometry geom_eb = LSUtility::make_eb_geometry(level_set, geom);
+
+        SpherePackIF impfunc(centers, radius);
+        EB2::GeometryShop<SpherePackIF> gshop(impfunc);
+
+        Real t0 = amrex::second();
+        EB2::Build(gshop, geom_eb, 0, 0);
+        Real t_build = amrex::second() - t0;
+
+        GShopLSFactory<SpherePackIF> gshop_ls(gshop, level_set);
+        std::unique_ptr<MultiFab> mf_impfunc = gshop_ls.fill_impfunc();
+
+        const EB2::Level& eb_level = EB2::IndexSpace::top().getLevel(geom_eb);
+        EBFArrayBoxFactory eb_factory(eb_level, geom_eb, level_set.get_eb_ba(), dm,
+                                      {eb_pad, eb_pad, eb_pad}, EBSupport::full);
+
+        // Local fill (LSFactory::fill => fill_data, narrow band = eb_pad+1)
+        t0 = amrex::second();
+        level_set.fill(eb_factory, * mf_impfunc);
+        Real t_fill = amrex::second() - t0;
+
+        // Global facet list (intersection_ebf), optional narrow band
+        LSFactory level_set_global(level_set);
+        level_set_global.set_narrow_band(narrow_band);
+        t0 = amrex::second();
+        level_set_global.intersection_ebf(eb_factory, * mf_impfunc);
+        Real t_global = amrex::second() - t0;
+
+        ParallelDescriptor::ReduceRealMax(t_build);
+        ParallelDescriptor::ReduceRealMax(t_fill);
+        ParallelDescriptor::ReduceRealMax(t_global);
+
+        amrex::Print() << "  EB2::Build                   " << t_build  << " s\n"
+                       << "  LSFactory::fill              " << t_fill   << " s\n"
+                       << "  LSFactory::intersection_ebf  " << t_global << " s"
+                       << " (narrow band " << narrow_band << ")\n";
+
+        if (check) {
+            check_band_corner();
+            check_fill(level_set, eb_factory, narrow_band);
+        }
+    }
+    amrex::Finalize();
+}
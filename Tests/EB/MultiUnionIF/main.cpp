@@ -0,0 +1,131 @@
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include <AMReX.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+#include <AMReX_EB2.H>
+#include <AMReX_EB2_IF_MultiUnion.H>
+#include <AMReX_EB2_IF_Sphere.H>
+#include <AMReX_EBFabFactory.H>
+
+using namespace amrex;
+
+namespace {
+
+// The union of all the spheres, evaluating every one of them
+struct AllSpheresIF
+{
+    const Vector<EB2::SphereIF>* spheres;
+
+    Real operator() (const RealArray& p) const {
+        Real r = std::numeric_limits<Real>::lowest();
+        for (const auto& s : *spheres) {
+            r = std::max(r, s(p));
+        }
+        return r;
+    }
+};
+
+}
+
+// Compare a MultiUnionIF of spheres with the union that evaluates every
+// sphere: the sign everywhere, the value where it is not negative, the
+// continuity across the buckets, and the volume fractions of EB2::Build.
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 64, max_grid_size = 32, nspheres = 200, npoints = 100000;
+        Real radius = 0.03;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("nspheres", nspheres);
+            pp.query("radius", radius);
+            pp.query("npoints", npoints);
+        }
+
+        // Non-overlapping spheres, leaving empty buckets between them.
+        std::mt19937 gen(7);
+        std::uniform_real_distribution<Real> center(0.1, 0.9);
+        Vector<EB2::SphereIF> spheres;
+        Vector<RealArray> lo, hi, centers;
+        for (int tries = 0; spheres.size() < nspheres && tries < 100*nspheres; ++tries)
+        {
+            const RealArray c {AMREX_D_DECL(center(gen), center(gen), center(gen))};
+            bool ok = true;
+            for (const auto& q : centers) {
+                Real d2 = 0.0;
+                for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                    d2 += (c[d]-q[d])*(c[d]-q[d]);
+                }
+                ok = ok && d2 > 9.0*radius*radius;
+            }
+            if (!ok) continue;
+            centers.push_back(c);
+            spheres.emplace_back(radius, c, false);
+            lo.push_back({AMREX_D_DECL(c[0]-radius, c[1]-radius, c[2]-radius)});
+            hi.push_back({AMREX_D_DECL(c[0]+radius, c[1]+radius, c[2]+radius)});
+        }
+
+        const auto multi = EB2::makeMultiUnion(spheres, lo, hi);
+        const AllSpheresIF all {&spheres};
+
+        // Random points: the same sign everywhere, the same value where
+        // the union is not negative.
+        std::uniform_real_distribution<Real> point(0.0, 1.0);
+        for (int i = 0; i < npoints; ++i)
+        {
+            const RealArray p {AMREX_D_DECL(point(gen), point(gen), point(gen))};
+            const Real a = multi(p);
+            const Real b = all(p);
+            AMREX_ALWAYS_ASSERT((a > 0.0) == (b > 0.0) && (a == 0.0) == (b == 0.0));
+            AMREX_ALWAYS_ASSERT(b < 0.0 || a == b);
+        }
+
+        // Lines through the domain, crossing spheres and empty buckets: the
+        // value changes by O(step) between neighboring points.
+        const int nsteps = 100000;
+        const Real step = 1.0/nsteps;
+        for (int line = 0; line < 20; ++line)
+        {
+            RealArray p {AMREX_D_DECL(0.0, point(gen), point(gen))};
+            Real prev = multi(p);
+            for (int i = 1; i <= nsteps; ++i)
+            {
+                p[0] = i*step;
+                const Real v = multi(p);
+                AMREX_ALWAYS_ASSERT(std::abs(v-prev) < 100.0*step);
+                prev = v;
+            }
+        }
+
+        // EB2::Build with either function
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        RealBox rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        Geometry geom(domain, &rb);
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        EB2::Build(EB2::makeShop(multi), geom, 0, 0);
+        auto multi_factory = makeEBFabFactory(geom, ba, dm, {1,1,1}, EBSupport::volume);
+        EB2::Build(EB2::makeShop(all), geom, 0, 0);
+        auto all_factory = makeEBFabFactory(geom, ba, dm, {1,1,1}, EBSupport::volume);
+
+        MultiFab vfrac(ba, dm, 1, 0);
+        MultiFab::Copy(vfrac, multi_factory->getVolFrac(), 0, 0, 1, 0);
+        MultiFab::Subtract(vfrac, all_factory->getVolFrac(), 0, 0, 1, 0);
+        AMREX_ALWAYS_ASSERT(vfrac.norm0() < 1.e-10);
+
+        amrex::Print() << "passed!" << std::endl;
+    }
+    amrex::Finalize();
+}
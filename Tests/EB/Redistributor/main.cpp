@@ -0,0 +1,133 @@
+
+#include <algorithm>
+#include <cmath>
+
+#include <AMReX.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+#include <AMReX_EB2.H>
+#include <AMReX_EB2_IF_Sphere.H>
+#include <AMReX_EBFabFactory.H>
+#include <AMReX_EBRedistributor.H>
+
+using namespace amrex;
+
+namespace {
+
+// sum of vfrac*mf over the valid cells
+Real
+volumeSum (const MultiFab& mf, int comp, const MultiFab& vfrac)
+{
+    Real s = 0.0;
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+    {
+        for (BoxIterator bi(mfi.validbox()); bi.ok(); ++bi) {
+            s += vfrac[mfi](bi()) * mf[mfi](bi(),comp);
+        }
+    }
+    ParallelDescriptor::ReduceRealSum(s);
+    return s;
+}
+
+}
+
+// Check that the flux and state redistributions of EBRedistributor around
+// a sphere are conservative, that the state redistribution preserves
+// constant states, and that the results do not depend on the boxes.
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 64, max_grid_size = 16;
+        Real radius = 0.25, target_vfrac = 0.5;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("radius", radius);
+            pp.query("target_vfrac", target_vfrac);
+        }
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        RealBox rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        Geometry geom(domain, &rb);
+        EB2::SphereIF sphere(radius, {AMREX_D_DECL(0.5,0.5,0.5)}, false);
+        EB2::Build(EB2::makeShop(sphere), geom, 0, 0);
+
+        // The results of both redistributions, on one box and on boxes of
+        // max_grid_size, copied to a single box.
+        BoxArray ba_all(domain);
+        DistributionMapping dm_all(ba_all);
+        MultiFab result[2];
+
+        const int ncomp = 2;
+        for (int layout = 0; layout < 2; ++layout)
+        {
+            BoxArray ba(domain);
+            ba.maxSize(layout == 0 ? n_cell : max_grid_size);
+            DistributionMapping dm(ba);
+            auto factory = makeEBFabFactory(geom, ba, dm, {3,3,3}, EBSupport::full);
+            const MultiFab& vfrac = factory->getVolFrac();
+
+            MultiFab divc(ba, dm, ncomp, 2, MFInfo(), *factory);
+            MultiFab rho(ba, dm, 1, 2, MFInfo(), *factory);
+            for (MFIter mfi(divc); mfi.isValid(); ++mfi)
+            {
+                for (BoxIterator bi(mfi.fabbox()); bi.ok(); ++bi)
+                {
+                    const IntVect& iv = bi();
+                    divc[mfi](iv,0) = std::sin(0.3*iv[0] + 0.7*iv[1]) + 0.05*iv[2];
+                    divc[mfi](iv,1) = std::cos(0.1*iv[0]*iv[2]);
+                    rho[mfi](iv) = 1.0 + 0.2*std::sin(0.4*iv[1]);
+                }
+            }
+
+            EBRedistributor redist(*factory, target_vfrac);
+            AMREX_ALWAYS_ASSERT(redist.hasStateRedistribution());
+
+            MultiFab dudt(ba, dm, ncomp, 0, MFInfo(), *factory);
+            MultiFab dwdt(ba, dm, ncomp, 0, MFInfo(), *factory);
+            MultiFab unew(ba, dm, ncomp, 0, MFInfo(), *factory);
+            redist.FluxRedistribute(dudt, 0, divc, 0, ncomp);
+            redist.FluxRedistribute(dwdt, 0, divc, 0, ncomp, &rho, 0);
+            redist.StateRedistribute(unew, 0, divc, 0, ncomp);
+
+            for (int n = 0; n < ncomp; ++n)
+            {
+                const Real total = volumeSum(divc, n, vfrac);
+                const Real scale = std::max(1.0, std::abs(total));
+                AMREX_ALWAYS_ASSERT(std::abs(volumeSum(dudt, n, vfrac) - total) <= 1.e-12*scale);
+                AMREX_ALWAYS_ASSERT(std::abs(volumeSum(dwdt, n, vfrac) - total) <= 1.e-12*scale);
+                AMREX_ALWAYS_ASSERT(std::abs(volumeSum(unew, n, vfrac) - total) <= 1.e-12*scale);
+            }
+
+            // The small cells do redistribute.
+            MultiFab diff(ba, dm, ncomp, 0);
+            MultiFab::Copy(diff, dudt, 0, 0, ncomp, 0);
+            MultiFab::Subtract(diff, divc, 0, 0, ncomp, 0);
+            AMREX_ALWAYS_ASSERT(diff.norm0() > 0.0);
+
+            // A constant state is not changed.
+            MultiFab u(ba, dm, 1, 2, MFInfo(), *factory);
+            MultiFab uc(ba, dm, 1, 0, MFInfo(), *factory);
+            u.setVal(3.0);
+            redist.StateRedistribute(uc, 0, u, 0, 1);
+            uc.plus(-3.0, 0, 1, 0);
+            AMREX_ALWAYS_ASSERT(uc.norm0() <= 1.e-12);
+
+            result[layout].define(ba_all, dm_all, 2*ncomp, 0);
+            result[layout].copy(dudt, 0, 0, ncomp);
+            result[layout].copy(unew, 0, ncomp, ncomp);
+        }
+
+        MultiFab::Subtract(result[1], result[0], 0, 0, 2*ncomp, 0);
+        for (int n = 0; n < 2*ncomp; ++n) {
+            AMREX_ALWAYS_ASSERT(result[1].norm0(n) <= 1.e-12);
+        }
+
+        amrex::Print() << "passed!" << std::endl;
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,194 @@
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <random>
+
+#include <AMReX.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+#include <AMReX_EB2.H>
+#include <AMReX_EB2_IF_STL.H>
+#include <AMReX_EB2_IF_Sphere.H>
+#include <AMReX_EBFabFactory.H>
+
+using namespace amrex;
+
+namespace {
+
+// Triangles of a sphere with nth latitude bands and 2 nth longitudes.
+// Every other triangle is listed with the opposite orientation.
+Vector<Real>
+triangulateSphere (int nth, Real r, const RealArray& c)
+{
+    const int nph = 2*nth;
+    auto vertex = [&] (int i, int j) {
+        const Real th = M_PI*i/nth;
+        const Real ph = 2.0*M_PI*j/nph;
+        return RealArray{c[0] + r*std::sin(th)*std::cos(ph),
+                         c[1] + r*std::sin(th)*std::sin(ph),
+                         c[2] + r*std::cos(th)};
+    };
+    Vector<Real> tri;
+    int ntri = 0;
+    auto add = [&] (const RealArray& a, const RealArray& b, const RealArray& d) {
+        const RealArray v[3] = {a, (ntri % 2) ? d : b, (ntri % 2) ? b : d};
+        for (const auto& x : v) {
+            tri.insert(tri.end(), x.begin(), x.end());
+        }
+        ++ntri;
+    };
+    for (int i = 0; i < nth; ++i) {
+        for (int j = 0; j < nph; ++j) {
+            if (i > 0)     add(vertex(i,j), vertex(i+1,j),   vertex(i,j+1));
+            if (i < nth-1) add(vertex(i+1,j), vertex(i+1,j+1), vertex(i,j+1));
+        }
+    }
+    return tri;
+}
+
+void
+writeBinarySTL (const std::string& name, const Vector<Real>& tri)
+{
+    std::ofstream os(name, std::ios::binary);
+    const char header[80] = "STLIF test";
+    os.write(header, 80);
+    const std::uint32_t ntri = tri.size()/9;
+    os.write(reinterpret_cast<const char*>(&ntri), 4);
+    for (std::uint32_t i = 0; i < ntri; ++i) {
+        float f[12] = {0};  // normal, then the vertices
+        for (int k = 0; k < 9; ++k) {
+            f[3+k] = tri[9*i+k];
+        }
+        os.write(reinterpret_cast<const char*>(f), sizeof(f));
+        const std::uint16_t attr = 0;
+        os.write(reinterpret_cast<const char*>(&attr), 2);
+    }
+}
+
+void
+writeAsciiSTL (const std::string& name, const Vector<Real>& tri)
+{
+    std::ofstream os(name);
+    os << std::setprecision(17) << "solid sphere\n";
+    for (int i = 0; i < tri.size()/9; ++i) {
+        os << " facet normal 0 0 0\n  outer loop\n";
+        for (int v = 0; v < 3; ++v) {
+            os << "   vertex " << tri[9*i+3*v] << ' ' << tri[9*i+3*v+1] << ' ' << tri[9*i+3*v+2] << '\n';
+        }
+        os << "  endloop\n endfacet\n";
+    }
+    os << "endsolid sphere\n";
+}
+
+}
+
+// Compare the STLIF of a triangulated sphere with the sphere: reading
+// binary and ASCII files, the sign and the signed distance at random
+// points, the truncation, bound(), and the volume fractions of EB2::Build.
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 64, max_grid_size = 32, nth = 100, npoints = 20000;
+        Real radius = 0.3;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("radius", radius);
+            pp.query("nth", nth);
+            pp.query("npoints", npoints);
+        }
+
+        const RealArray center {0.5, 0.5, 0.5};
+        const Vector<Real> tri = triangulateSphere(nth, radius, center);
+        if (ParallelDescriptor::IOProcessor()) {
+            writeBinarySTL("sphere_binary.stl", tri);
+            writeAsciiSTL("sphere_ascii.stl", tri);
+        }
+        ParallelDescriptor::Barrier();
+
+        const Vector<Real> binary = EB2::STLIF::readSTL("sphere_binary.stl");
+        const Vector<Real> ascii  = EB2::STLIF::readSTL("sphere_ascii.stl");
+        AMREX_ALWAYS_ASSERT(binary.size() == tri.size() && ascii.size() == tri.size());
+        for (int i = 0; i < tri.size(); ++i) {
+            AMREX_ALWAYS_ASSERT(binary[i] == static_cast<float>(tri[i]));
+            AMREX_ALWAYS_ASSERT(ascii[i] == tri[i]);
+        }
+
+        const EB2::STLIF stl("sphere_binary.stl", false);
+        const Real max_distance = 0.05;
+        const EB2::STLIF truncated(binary, false, max_distance);
+
+        // The facets are within the chord error of the sphere, and the
+        // float vertices within a rounding error.
+        const Real facet_err = radius*(1.0 - std::cos(M_PI/nth)) + 1.e-6;
+
+        std::mt19937 gen(11);
+        std::uniform_real_distribution<Real> point(0.0, 1.0);
+        for (int i = 0; i < npoints; ++i)
+        {
+            const RealArray p {point(gen), point(gen), point(gen)};
+            const Real r = std::sqrt((p[0]-center[0])*(p[0]-center[0])
+                                   + (p[1]-center[1])*(p[1]-center[1])
+                                   + (p[2]-center[2])*(p[2]-center[2]));
+            const Real exact = radius - r;  // > 0 inside the body
+            const Real d = stl(p);
+            AMREX_ALWAYS_ASSERT(std::abs(exact) <= facet_err || (d > 0.0) == (exact > 0.0));
+            AMREX_ALWAYS_ASSERT(std::abs(d - exact) <= facet_err);
+
+            const Real expect = std::max(-max_distance, std::min(max_distance, d));
+            AMREX_ALWAYS_ASSERT(std::abs(truncated(p) - expect) <= 1.e-12);
+        }
+
+        // bound() contains the values at the corners and at the center.
+        std::uniform_real_distribution<Real> size(0.0, 0.1);
+        for (int i = 0; i < npoints/10; ++i)
+        {
+            RealArray lo, hi;
+            for (int d = 0; d < 3; ++d) {
+                lo[d] = point(gen);
+                hi[d] = lo[d] + size(gen);
+            }
+            const EB2::IFInterval b = stl.bound(lo, hi);
+            for (int corner = 0; corner < 9; ++corner) {
+                RealArray p;
+                for (int d = 0; d < 3; ++d) {
+                    p[d] = (corner == 8) ? 0.5*(lo[d]+hi[d]) : (((corner >> d) & 1) ? hi[d] : lo[d]);
+                }
+                const Real v = stl(p);
+                AMREX_ALWAYS_ASSERT(v >= b.lo && v <= b.hi);
+            }
+        }
+
+        // EB2::Build with the STL surface and with the sphere
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        RealBox rb({0.,0.,0.}, {1.,1.,1.});
+        Geometry geom(domain, &rb);
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        EB2::Build(EB2::makeShop(stl), geom, 0, 0);
+        auto stl_factory = makeEBFabFactory(geom, ba, dm, {1,1,1}, EBSupport::volume);
+        EB2::SphereIF sphere(radius, center, false);
+        EB2::Build(EB2::makeShop(sphere), geom, 0, 0);
+        auto sphere_factory = makeEBFabFactory(geom, ba, dm, {1,1,1}, EBSupport::volume);
+
+        MultiFab vfrac(ba, dm, 1, 0);
+        MultiFab::Copy(vfrac, stl_factory->getVolFrac(), 0, 0, 1, 0);
+        const Real stl_volume = vfrac.sum();
+        MultiFab::Subtract(vfrac, sphere_factory->getVolFrac(), 0, 0, 1, 0);
+        // a cell is cut by facets within facet_err of the sphere
+        AMREX_ALWAYS_ASSERT(vfrac.norm0() <= 4.0*facet_err*n_cell);
+        AMREX_ALWAYS_ASSERT(std::abs(vfrac.sum()) <= 1.e-3*stl_volume);
+
+        amrex::Print() << "passed!" << std::endl;
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,114 @@
+
+#include <cmath>
+
+#include <AMReX.H>
+#include <AMReX_FabArrayExpr.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_iMultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+// Compare fused element-wise updates written with expression templates
+// with the same updates done by the MultiFab operations, and time both.
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 64, max_grid_size = 32, nsteps = 10;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("nsteps", nsteps);
+        }
+
+        BoxArray ba(Box(IntVect(0), IntVect(n_cell-1)));
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        const int ncomp = 5, ngrow = 2;
+        MultiFab  U(ba, dm, ncomp, ngrow), U0(ba, dm, ncomp, ngrow), U1(ba, dm, ncomp, ngrow);
+        MultiFab  L(ba, dm, ncomp+1, ngrow), R(ba, dm, ncomp, ngrow);
+        iMultiFab mask(ba, dm, 1, ngrow);
+
+        for (MFIter mfi(U0); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.fabbox();
+            for (BoxIterator bi(bx); bi.ok(); ++bi)
+            {
+                const IntVect& iv = bi();
+                for (int n = 0; n < ncomp; ++n) {
+                    U0[mfi](iv,n) = std::sin(0.1*iv[0] + n);
+                    U1[mfi](iv,n) = std::cos(0.2*iv[1] - n);
+                }
+                for (int n = 0; n <= ncomp; ++n) {
+                    L[mfi](iv,n) = 0.01*(n+1)*iv[2];
+                }
+                mask[mfi](iv) = (iv[0] + iv[1]) % 2;
+            }
+        }
+
+        // A Runge-Kutta stage, U = a U0 + b U1 + c dt L, with L shifted by
+        // one component, including the ghost cells.
+        const Real a = 0.75, b = 0.25, c = 0.25, dt = 0.1;
+        MultiFab::LinComb(R, a, U0, 0, b, U1, 0, 0, ncomp, ngrow);
+        MultiFab::Saxpy(R, c*dt, L, 1, 0, ncomp, ngrow);
+        Assign(U, 0, ncomp, ngrow, a*Expr(U0) + b*Expr(U1) + (c*dt)*Expr(L,1));
+        MultiFab::Subtract(R, U, 0, 0, ncomp, ngrow);
+        for (int n = 0; n < ncomp; ++n) {
+            AMREX_ALWAYS_ASSERT(R.norm0(n, ngrow) <= 1.e-12);
+        }
+
+        // A masked update in place, with negation and division.
+        MultiFab V(ba, dm, ncomp, ngrow);
+        MultiFab::Copy(V, U0, 0, 0, ncomp, ngrow);
+        Assign(V, 0, ncomp, 0, Where(ExprComp(mask,0), Expr(V) + 2.0*Expr(U1),
+                                     -Expr(V) / (ExprComp(L,0) + 1.0)));
+        for (MFIter mfi(V); mfi.isValid(); ++mfi)
+        {
+            for (BoxIterator bi(mfi.validbox()); bi.ok(); ++bi)
+            {
+                const IntVect& iv = bi();
+                for (int n = 0; n < ncomp; ++n)
+                {
+                    const Real expect = (mask[mfi](iv))
+                        ?  U0[mfi](iv,n) + 2.0*U1[mfi](iv,n)
+                        : -U0[mfi](iv,n) / (L[mfi](iv,0) + 1.0);
+                    AMREX_ALWAYS_ASSERT(std::abs(V[mfi](iv,n) - expect) <= 1.e-12);
+                }
+            }
+        }
+
+        // A BaseFab over part of its box.
+        const Box fbx(IntVect(0), IntVect(7));
+        const Box sub(IntVect(1), IntVect(6));
+        FArrayBox f(fbx, 2), g(fbx, 2);
+        f.setVal(3.0);
+        g.setVal(1.0);
+        Assign(g, sub, 0, 2, Expr(f)*Expr(f) - Expr(g));
+        for (BoxIterator bi(fbx); bi.ok(); ++bi) {
+            for (int n = 0; n < 2; ++n) {
+                AMREX_ALWAYS_ASSERT(g(bi(),n) == (sub.contains(bi()) ? 8.0 : 1.0));
+            }
+        }
+
+        Real t_ops = amrex::second();
+        for (int step = 0; step < nsteps; ++step) {
+            MultiFab::LinComb(R, a, U0, 0, b, U1, 0, 0, ncomp, 0);
+            MultiFab::Saxpy(R, c*dt, L, 1, 0, ncomp, 0);
+        }
+        t_ops = (amrex::second() - t_ops) / nsteps;
+
+        Real t_expr = amrex::second();
+        for (int step = 0; step < nsteps; ++step) {
+            Assign(U, 0, ncomp, 0, a*Expr(U0) + b*Expr(U1) + (c*dt)*Expr(L,1));
+        }
+        t_expr = (amrex::second() - t_expr) / nsteps;
+
+        amrex::Print() << "LinComb and Saxpy " << t_ops << " s, expression " << t_expr << " s\n";
+        amrex::Print() << "passed!" << std::endl;
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,140 @@
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include <AMReX.H>
+#include <AMReX_FabConv.H>
+#include <AMReX_FPC.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+// IEEE float or double in the given byte order (1 based, as in FPC).
+RealDescriptor
+ieeeDescriptor (int nbytes, const int* order)
+{
+    return RealDescriptor(nbytes == 4 ? FPC::ieee_float : FPC::ieee_double, order, nbytes);
+}
+
+// The values in the format rd, written by hand rather than converted.
+std::vector<char>
+writeValues (const std::vector<double>& values, const RealDescriptor& rd, const int* native_order)
+{
+    const int nbytes = rd.numBytes();
+    std::vector<char> native(values.size()*nbytes);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        if (nbytes == 4) {
+            const float x = static_cast<float>(values[i]);
+            std::memcpy(&native[i*4], &x, 4);
+        } else {
+            std::memcpy(&native[i*8], &values[i], 8);
+        }
+    }
+    // both orders put byte k of a number at position order[k]-1
+    std::vector<char> bytes(native.size());
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        for (int k = 0; k < nbytes; ++k) {
+            bytes[i*nbytes + rd.order()[k]-1] = native[i*nbytes + native_order[k]-1];
+        }
+    }
+    return bytes;
+}
+
+// Check that the IEEE float and double conversions give the same bytes
+// as the general conversion, which is PD_fconvert and PD_fixdenormals
+// between float and double, for all 16 pairs of float and double in the
+// native and the swapped byte orders.  The values are exact in float, or
+// are denormals, zeros, or out of the float range, so the rounding of
+// PD_fconvert does not matter.  PD_fconvert does not keep NaNs, and turns
+// a float inf into a finite double, so there are none of those.
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        // the threaded conversion too
+        RealDescriptor::SetConvertThreadMin(100);
+
+        const bool native_is_reverse = FPC::Native32RealDescriptor().order()[0] == 4;
+        const int* float_order[2]  = {FPC::normal_float_order,  FPC::reverse_float_order};
+        const int* double_order[2] = {FPC::normal_double_order, FPC::reverse_double_order};
+
+        std::vector<double> special = {
+            0.0, -0.0, 1.0, -1.5, 3.0e10, -2.5e-20,
+            std::ldexp(1.0,-126), -std::ldexp(1.0,-126),        // smallest normal float
+            std::ldexp(1.0,-127), -std::ldexp(3.0,-140),        // denormal floats
+            std::ldexp(1.0,-149), -std::ldexp(1.0,-149),
+            std::ldexp(1.0,-150), std::ldexp(1.0,-200),         // below the floats
+            std::ldexp(1.0,-1022), -std::ldexp(1.0,-1030),      // and denormal doubles
+            std::ldexp(1.0,-1074), std::numeric_limits<float>::max(),
+        };
+        std::vector<double> beyond_float = {1.0e300, -1.0e300, 1.0e39, -std::ldexp(1.0,128)};
+
+        std::vector<double> float_values, double_values;
+        for (int i = 0; i < 1000; ++i)
+        {
+            const double s = special[i % special.size()];
+            const double r = static_cast<float>(std::sin(1.0+i) * std::pow(10.0, i%77 - 38));
+            float_values.push_back(i % 3 ? r : s);
+            double_values.push_back(i % 5 == 4 ? beyond_float[i % beyond_float.size()]
+                                               : float_values.back());
+        }
+
+        int npairs = 0;
+        for (int osize : {4, 8}) {
+        for (int oswap = 0; oswap < 2; ++oswap) {
+        for (int isize : {4, 8}) {
+        for (int iswap = 0; iswap < 2; ++iswap)
+        {
+            const int* const* oorders = (osize == 4) ? float_order : double_order;
+            const int* const* iorders = (isize == 4) ? float_order : double_order;
+            const RealDescriptor od = ieeeDescriptor(osize, oorders[oswap != native_is_reverse]);
+            const RealDescriptor id = ieeeDescriptor(isize, iorders[iswap != native_is_reverse]);
+            // same format, in an order without a fast path
+            const RealDescriptor wd = ieeeDescriptor(isize, (isize == 4) ? FPC::reverse_float_order_2
+                                                                         : FPC::reverse_double_order_2);
+
+            const std::vector<double>& values = (isize == 4) ? float_values : double_values;
+            const long n = values.size();
+            const int* native_order = iorders[native_is_reverse];
+            const std::vector<char> in  = writeValues(values, id, native_order);
+            const std::vector<char> win = writeValues(values, wd, native_order);
+            std::vector<char> out(n*osize), ref(n*osize);
+
+            RealDescriptor::convert(out.data(), od, in.data(), id, n);
+            RealDescriptor::convert(ref.data(), od, win.data(), wd, n);
+
+            for (long i = 0; i < n; ++i) {
+                AMREX_ALWAYS_ASSERT(std::memcmp(&out[i*osize], &ref[i*osize], osize) == 0);
+            }
+
+            // and inside a parallel region, which does not thread
+#ifdef _OPENMP
+#pragma omp parallel num_threads(2)
+#endif
+            {
+                std::vector<char> out2(n*osize);
+                RealDescriptor::convert(out2.data(), od, in.data(), id, n);
+                AMREX_ALWAYS_ASSERT(out2 == out);
+            }
+
+            // denormals and zeros are +0 between float and double
+            if (osize != isize) {
+                const std::vector<char> zero(osize, 0);
+                for (long i = 0; i < n; ++i) {
+                    const float f = static_cast<float>(values[i]);
+                    if (std::abs(f) < std::numeric_limits<float>::min()) {
+                        AMREX_ALWAYS_ASSERT(std::memcmp(&out[i*osize], zero.data(), osize) == 0);
+                    }
+                }
+            }
+            ++npairs;
+        }}}}
+        AMREX_ALWAYS_ASSERT(npairs == 16);
+
+        amrex::Print() << "passed!" << std::endl;
+    }
+    amrex::Finalize();
+}
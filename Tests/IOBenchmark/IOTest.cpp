@@ -11,6 +11,8 @@
 #include <AMReX_ParallelDescriptor.H>
 #include <AMReX_Utility.H>
 #include <AMReX_NFiles.H>
+#include <AMReX_FabConv.H>
+#include <AMReX_FPC.H>
 
 #include <iostream>
 #include <sstream>
@@ -20,6 +22,7 @@
 #include <iomanip>
 #include <cerrno>
 #include <deque>
+#include <limits>
 
 #include <unistd.h>
 #include <string.h>
@@ -614,6 +617,70 @@ ParallelDescriptor::Barrier();
 }
 
 
+// -------------------------------------------------------------
+void ConvertTests(long nitems, int ntimes, bool mb2) {
+  if(mb2) {
+    bytesPerMB = pow(2.0, 20);
+  }
+
+  Vector<Real> rData(nitems), rBack(nitems);
+  for(long i(0); i < nitems; ++i) {
+    rData[i] = (i % 1021) * 1.0e-3 - 0.5 + i * 1.0e-9;
+  }
+  Vector<char> buffer(nitems * sizeof(double));
+
+  struct RD { const char *name; const RealDescriptor *rd; };
+  const RD rds[] = { { "native 32",      &FPC::Native32RealDescriptor() },
+                     { "ieee32 normal",  &FPC::Ieee32NormalRealDescriptor() },
+                     { "ieee64 normal",  &FPC::Ieee64NormalRealDescriptor() },
+                     { "native",         &FPC::NativeRealDescriptor() } };
+  const Real mbytes(nitems * sizeof(Real) / bytesPerMB);
+
+  if(ParallelDescriptor::IOProcessor()) {
+    cout << "  converting " << nitems << " Reals (" << mbytes << " MB), MB/s of Reals" << endl;
+    cout << "  format           threaded   fromNative     toNative   errors" << endl;
+  }
+
+  for(const RD &rd : rds) {
+    for(int threaded(0); threaded <= 1; ++threaded) {
+      RealDescriptor::SetConvertThreadMin(threaded ? 65536 : std::numeric_limits<long>::max());
+
+      double tFrom(0.0), tTo(0.0);
+      for(int i(0); i < ntimes; ++i) {
+        double t0(ParallelDescriptor::second());
+        RealDescriptor::convertFromNativeFormat(buffer.dataPtr(), nitems, rData.dataPtr(), *rd.rd);
+        double t1(ParallelDescriptor::second());
+        RealDescriptor::convertToNativeFormat(rBack.dataPtr(), nitems, buffer.dataPtr(), *rd.rd);
+        double t2(ParallelDescriptor::second());
+        tFrom += t1 - t0;
+        tTo   += t2 - t1;
+      }
+
+      long nErrors(0);
+      for(long i(0); i < nitems; ++i) {
+        Real expected(rd.rd->numBytes() == 4 ? static_cast<Real>(static_cast<float>(rData[i]))
+                                             : rData[i]);
+        if(rBack[i] != expected) {
+          ++nErrors;
+        }
+      }
+
+      ParallelDescriptor::ReduceRealMax(tFrom);
+      ParallelDescriptor::ReduceRealMax(tTo);
+      ParallelDescriptor::ReduceLongSum(nErrors);
+      if(ParallelDescriptor::IOProcessor()) {
+        cout << "  " << std::left << std::setw(17) << rd.name << std::right
+             << std::setw(8) << threaded
+             << std::setw(13) << ntimes * mbytes / tFrom
+             << std::setw(13) << ntimes * mbytes / tTo
+             << std::setw(9) << nErrors << endl;
+      }
+    }
+  }
+  RealDescriptor::SetConvertThreadMin(65536);
+}
+
+
 // -------------------------------------------------------------
 // -------------------------------------------------------------
 
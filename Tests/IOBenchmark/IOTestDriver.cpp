@@ -37,6 +37,7 @@ void TestReadMF(const std::string &mfName, bool useSyncReads,
 void NFileTests(int nOutFiles, const std::string &filePrefix);
 void DSSNFileTests(int nOutFiles, const std::string &filePrefix,
                    bool useIter);
+void ConvertTests(long nitems, int ntimes, bool mb2);
 
 
 // -------------------------------------------------------------
@@ -73,6 +74,8 @@ static void PrintUsage(const char *progName) {
     cout << "   [usesyncreads      = tf       ]" << '\n';
     cout << "   [nmultifabs        = nmf      ]" << '\n';
     cout << "   [dirname           = dirname  ]" << '\n';
+    cout << "   [converttest       = tf       ]" << '\n';
+    cout << "   [convertitems      = nitems   ]" << '\n';
     cout << '\n';
 }
 
@@ -98,7 +101,8 @@ int main(int argc, char *argv[]) {
   bool groupSets(false), setBuf(true);
   bool nfileitertest(false), dssnfileitertest(false);
   bool filetests(false), dirtests(false);
-  bool testreadmf(false);
+  bool testreadmf(false), converttest(false);
+  long convertItems(1 << 24);
   bool useSingleRead(false), useSingleWrite(false);
   bool checkFPositions(false), pIFStreams(false);
   bool checkmf(false);
@@ -161,6 +165,9 @@ int main(int argc, char *argv[]) {
   pp.query("nreadstreams", nReadStreams);
   nReadStreams = std::max(1, nReadStreams);
   pp.query("dirname", dirName);
+  pp.query("converttest", converttest);
+  pp.query("convertitems", convertItems);
+  convertItems = std::max(1L, convertItems);
 
 
   if(ParallelDescriptor::IOProcessor()) {
@@ -199,6 +206,8 @@ int main(int argc, char *argv[]) {
     cout << "usesyncreads      = " << useSyncReads << '\n';
     cout << "nmultifabs        = " << nMultiFabs << '\n';
     cout << "dirName           = " << dirName << '\n';
+    cout << "converttest       = " << converttest << '\n';
+    cout << "convertitems      = " << convertItems << '\n';
 
     cout << '\n';
     cout << "sizeof(int) = " << sizeof(int) << '\n';
@@ -372,6 +381,21 @@ int main(int argc, char *argv[]) {
   }
 
 
+  if(converttest) {
+    if(ParallelDescriptor::IOProcessor()) {
+      cout << endl << "--------------------------------------------------" << endl;
+      cout << "Testing RealDescriptor Conversions" << endl;
+    }
+
+    ConvertTests(convertItems, ntimes, mb2);
+
+    if(ParallelDescriptor::IOProcessor()) {
+      cout << "==================================================" << endl;
+      cout << endl;
+    }
+  }
+
+
   if(filetests) {
     for(int itimes(0); itimes < ntimes; ++itimes) {
       if(ParallelDescriptor::IOProcessor()) {
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <random>
+
+#include <AMReX.H>
+#include <AMReX_Print.H>
+#include <AMReX_BoxArray.H>
+#include <AMReX_BoxList.H>
+
+using namespace amrex;
+
+void compare (const BoxArray& impl, const BoxArray& expl, std::mt19937& gen);
+long numPts (const BoxList& bl);
+Box randomBox (const Box& domain, std::mt19937& gen);
+
+// Compare BoxArrays that maxSize stores implicitly with the same
+// BoxArrays stored explicitly: operator[], intersections, contains and
+// complementIn, for cell-centered, nodal and coarsened BoxArrays, and
+// domains that the chunks do not divide.
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        std::mt19937 gen(3);
+
+        const Vector<Box> domains {
+            Box(IntVect(0), IntVect(63)),
+            Box(IntVect(AMREX_D_DECL(-5,3,7)), IntVect(AMREX_D_DECL(40,70,30))),
+            Box(IntVect(AMREX_D_DECL(0,0,0)), IntVect(AMREX_D_DECL(127,15,33)))
+        };
+        const Vector<IntVect> chunks {
+            IntVect(16), IntVect(AMREX_D_DECL(8,12,32)), IntVect(AMREX_D_DECL(64,5,7))
+        };
+
+        for (const auto& domain : domains)
+        {
+            for (const auto& chunk : chunks)
+            {
+                BoxArray::implicit_min_boxes = 0;
+                BoxArray expl(domain);
+                expl.maxSize(chunk);
+
+                BoxArray::implicit_min_boxes = 1;
+                BoxArray impl(domain);
+                impl.maxSize(chunk);
+
+                AMREX_ALWAYS_ASSERT(impl == expl);
+
+                compare(impl, expl, gen);
+                compare(amrex::convert(impl, IntVect::TheNodeVector()),
+                        amrex::convert(expl, IntVect::TheNodeVector()), gen);
+                compare(amrex::coarsen(impl, 2), amrex::coarsen(expl, 2), gen);
+
+                // Modifying the Boxes stores them explicitly.
+                BoxArray grown = impl;
+                grown.grow(1);
+                AMREX_ALWAYS_ASSERT(grown == BoxArray(expl).grow(1));
+                AMREX_ALWAYS_ASSERT(impl == expl);
+
+                amrex::Print() << domain << " chunk " << chunk << ": "
+                               << impl.size() << " boxes match\n";
+            }
+        }
+        BoxArray::implicit_min_boxes = 0;
+
+        amrex::Print() << "passed!" << std::endl;
+    }
+    amrex::Finalize();
+}
+
+void
+compare (const BoxArray& impl, const BoxArray& expl, std::mt19937& gen)
+{
+    AMREX_ALWAYS_ASSERT(impl.size() == expl.size());
+    AMREX_ALWAYS_ASSERT(impl.ixType() == expl.ixType());
+    for (int i = 0; i < impl.size(); ++i) {
+        AMREX_ALWAYS_ASSERT(impl[i] == expl[i]);
+    }
+
+    const Box domain = expl.minimalBox();
+    AMREX_ALWAYS_ASSERT(impl.minimalBox() == domain);
+    AMREX_ALWAYS_ASSERT(impl.numPts() == expl.numPts());
+
+    // Boxes partly inside, inside and outside the domain
+    for (int n = 0; n < 200; ++n)
+    {
+        const Box bx = amrex::convert(randomBox(domain, gen), expl.ixType());
+
+        for (int ng = 0; ng <= 2; ++ng)
+        {
+            auto a = impl.intersections(bx, false, ng);
+            auto b = expl.intersections(bx, false, ng);
+            std::sort(a.begin(), a.end());
+            std::sort(b.begin(), b.end());
+            AMREX_ALWAYS_ASSERT(a == b);
+
+            auto fa = impl.intersections(bx, true, ng);
+            auto fb = expl.intersections(bx, true, ng);
+            AMREX_ALWAYS_ASSERT(fa.size() == fb.size());
+            AMREX_ALWAYS_ASSERT(fa.empty() || std::count(b.begin(), b.end(), fa[0]) == 1);
+
+            AMREX_ALWAYS_ASSERT(impl.intersects(bx, ng) == expl.intersects(bx, ng));
+        }
+
+        AMREX_ALWAYS_ASSERT(impl.contains(bx) == expl.contains(bx));
+        AMREX_ALWAYS_ASSERT(impl.contains(bx.smallEnd()) == expl.contains(bx.smallEnd()));
+        AMREX_ALWAYS_ASSERT(impl.contains(bx.bigEnd()) == expl.contains(bx.bigEnd()));
+
+        // The complements may be chopped differently, but cover the same
+        // cells: the cells of bx outside the BoxArray.
+        const BoxList ca = impl.complementIn(bx);
+        const BoxList cb = expl.complementIn(bx);
+        AMREX_ALWAYS_ASSERT(numPts(ca) == numPts(cb));
+        for (const Box& c : ca) {
+            AMREX_ALWAYS_ASSERT(bx.contains(c) && !expl.intersects(c));
+        }
+    }
+}
+
+long
+numPts (const BoxList& bl)
+{
+    long n = 0;
+    for (const Box& b : bl) {
+        n += b.numPts();
+    }
+    return n;
+}
+
+Box
+randomBox (const Box& domain, std::mt19937& gen)
+{
+    IntVect lo, hi;
+    for (int idim = 0; idim < AMREX_SPACEDIM; ++idim)
+    {
+        const int len = domain.length(idim);
+        std::uniform_int_distribution<int> corner(domain.smallEnd(idim) - len/4,
+                                                  domain.bigEnd(idim) + len/4);
+        std::uniform_int_distribution<int> size(0, len/2);
+        lo[idim] = corner(gen);
+        hi[idim] = lo[idim] + size(gen);
+    }
+    return Box(lo, hi);
+}
@@ -0,0 +1,336 @@
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <utility>
+
+#include <AMReX.H>
+#include <AMReX_Amr.H>
+#include <AMReX_AmrLevel.H>
+#include <AMReX_InSituReduction.H>
+#include <AMReX_LevelBld.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_PhysBCFunct.H>
+#include <AMReX_Print.H>
+#include <AMReX_PROB_AMR_F.H>
+
+using namespace amrex;
+
+extern "C" {
+    void amrex_probinit (const int* init,
+                         const int* name,
+                         const int* namelen,
+                         const amrex_real* problo,
+                         const amrex_real* probhi)
+    {}
+
+    // phis = (2 phi, 3 phi)
+    void derive_phis (Real* data, const int* dlo, const int* dhi, const int* nvar,
+                      const Real* compdat, const int* clo, const int* chi, const int* ncomp,
+                      const int* lo, const int* hi,
+                      const int* domain_lo, const int* domain_hi,
+                      const Real* delta, const Real* xlo,
+                      const Real* time, const Real* dt,
+                      const int* bcrec, const int* level, const int* grid_no)
+    {
+        const long dnx = dhi[0]-dlo[0]+1, dny = dhi[1]-dlo[1]+1, dnz = dhi[2]-dlo[2]+1;
+        const long cnx = chi[0]-clo[0]+1, cny = chi[1]-clo[1]+1;
+        for (int k = lo[2]; k <= hi[2]; ++k) {
+        for (int j = lo[1]; j <= hi[1]; ++j) {
+        for (int i = lo[0]; i <= hi[0]; ++i) {
+            const Real phi = compdat[(i-clo[0]) + cnx*((j-clo[1]) + cny*(k-clo[2]))];
+            const long d = (i-dlo[0]) + dnx*((j-dlo[1]) + dny*(k-dlo[2]));
+            data[d]             = 2.0*phi;
+            data[d+dnx*dny*dnz] = 3.0*phi;
+        }}}
+    }
+}
+
+// The in-situ reductions of a linear field on a three-level hierarchy.
+// Each cell holds the value at its center, so every average of the
+// composite solution over a cell of the output is the value at the
+// center of the finest cell of the output level that has data there.
+
+namespace {
+
+Real phi (const RealVect& x)
+{
+    return 1.0 + x[0] + 2.0*x[1] + 3.0*x[2];
+}
+
+CpuBndryFuncFab cpu_bndry_func(nullptr);
+
+void test_bcfill (Box const& bx, FArrayBox& data, const int dcomp, const int numcomp,
+                  Geometry const& geom, const Real time, const Vector<BCRec>& bcr,
+                  const int bcomp, const int scomp)
+{
+    cpu_bndry_func(bx, data, dcomp, numcomp, geom, time, bcr, bcomp, scomp);
+}
+
+}
+
+class TestLevel
+    : public AmrLevel
+{
+public:
+
+    enum StateType { State_Type = 0 };
+
+    TestLevel () {}
+
+    TestLevel (Amr& papa, int lev, const Geometry& level_geom, const BoxArray& ba,
+               const DistributionMapping& dm, Real time)
+        : AmrLevel(papa, lev, level_geom, ba, dm, time) {}
+
+    static void variableSetUp ()
+    {
+        desc_lst.addDescriptor(State_Type, IndexType::TheCellType(), StateDescriptor::Point,
+                               0, 1, &cell_cons_interp);
+        BCRec bc;
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+            bc.setLo(idim, BCType::foextrap);
+            bc.setHi(idim, BCType::foextrap);
+        }
+        StateDescriptor::BndryFunc bndryfunc(test_bcfill);
+        desc_lst.setComponent(State_Type, 0, "phi", bc, bndryfunc);
+
+        Vector<std::string> names = {"phi2", "phi3"};
+        derive_lst.add("phis", IndexType::TheCellType(), 2, names, derive_phis, DeriveRec::TheSameBox);
+        derive_lst.addComponent("phis", desc_lst, State_Type, 0, 1);
+    }
+
+    static void variableCleanUp () { desc_lst.clear(); derive_lst.clear(); }
+
+    virtual void initData () override
+    {
+        MultiFab& S_new = get_new_data(State_Type);
+        const Real* dx = geom.CellSize();
+        for (MFIter mfi(S_new); mfi.isValid(); ++mfi) {
+            FArrayBox& fab = S_new[mfi];
+            for (BoxIterator bi(mfi.validbox()); bi.ok(); ++bi) {
+                RealVect x;
+                for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                    x[idim] = (bi()[idim] + 0.5)*dx[idim];
+                }
+                fab(bi(), 0) = phi(x);
+            }
+        }
+    }
+
+    virtual void init (AmrLevel& old) override {}
+    virtual void init () override {}
+
+    virtual Real advance (Real time, Real dt, int iteration, int ncycle) override { return dt; }
+
+    virtual void post_timestep (int iteration) override {}
+
+    virtual void computeInitialDt (int finest_level, int sub_cycle, Vector<int>& n_cycle,
+                                   const Vector<IntVect>& ref_ratio, Vector<Real>& dt_level,
+                                   Real stop_time) override
+    {
+        for (int lev = 0; lev <= finest_level; ++lev) {
+            dt_level[lev] = 1.0;
+        }
+    }
+
+    virtual void computeNewDt (int finest_level, int sub_cycle, Vector<int>& n_cycle,
+                               const Vector<IntVect>& ref_ratio, Vector<Real>& dt_min,
+                               Vector<Real>& dt_level, Real stop_time, int post_regrid_flag) override {}
+
+    virtual void errorEst (TagBoxArray& tags, int clearval, int tagval, Real time,
+                           int n_error_buf, int ngrow) override
+    {
+        // A corner of the domain, smaller on each level.
+        const Real* dx = geom.CellSize();
+        const Real xtag = 0.25/(level+1);
+        for (MFIter mfi(tags); mfi.isValid(); ++mfi) {
+            TagBox& tb = tags[mfi];
+            for (BoxIterator bi(mfi.validbox()); bi.ok(); ++bi) {
+                bool tag = true;
+                for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                    tag = tag && (bi()[idim] + 0.5)*dx[idim] < xtag;
+                }
+                if (tag) tb(bi()) = tagval;
+            }
+        }
+    }
+
+    virtual void post_regrid (int lbase, int new_finest) override {}
+    virtual void post_init (Real stop_time) override {}
+};
+
+class TestLevelBld
+    : public LevelBld
+{
+    virtual void variableSetUp () override { TestLevel::variableSetUp(); }
+    virtual void variableCleanUp () override { TestLevel::variableCleanUp(); }
+    virtual AmrLevel* operator() () override { return new TestLevel; }
+    virtual AmrLevel* operator() (Amr& papa, int lev, const Geometry& level_geom,
+                                  const BoxArray& ba, const DistributionMapping& dm,
+                                  Real time) override
+    {
+        return new TestLevel(papa, lev, level_geom, ba, dm, time);
+    }
+};
+
+TestLevelBld test_bld;
+
+LevelBld*
+getLevelBld ()
+{
+    return &test_bld;
+}
+
+namespace {
+
+// The records of <prefix><name>.bin, as (step, values).
+Vector<std::pair<int,Vector<Real> > > readRecords (const std::string& name)
+{
+    Vector<std::pair<int,Vector<Real> > > records;
+    std::ifstream is("insitu_test_" + name + ".bin", std::ios::binary);
+    std::int64_t step, n;
+    double time;
+    while (is.read(reinterpret_cast<char*>(&step), sizeof(step)))
+    {
+        is.read(reinterpret_cast<char*>(&time), sizeof(time));
+        is.read(reinterpret_cast<char*>(&n),    sizeof(n));
+        Vector<Real> value(n);
+        for (auto& v : value) {
+            double d;
+            is.read(reinterpret_cast<char*>(&d), sizeof(d));
+            v = d;
+        }
+        AMREX_ALWAYS_ASSERT(is.good());
+        records.emplace_back(step, value);
+    }
+    return records;
+}
+
+// The values of the only record of <prefix><name>.bin.
+Vector<Real> readRecord (const std::string& name)
+{
+    const auto records = readRecords(name);
+    AMREX_ALWAYS_ASSERT(records.size() == 1);
+    return records[0].second;
+}
+
+// The composite value at cell iv of level lev: the value at the center of
+// the cell, or of the finest coarser cell that has data.
+Real expected (const Amr& amr, int lev, const IntVect& iv)
+{
+    IntVect cv = iv;
+    for (int l = lev; l >= 0; --l)
+    {
+        if (l <= amr.finestLevel() && amr.boxArray(l).contains(cv))
+        {
+            RealVect x;
+            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                x[idim] = (cv[idim] + 0.5)*amr.Geom(l).CellSize(idim);
+            }
+            return phi(x);
+        }
+        if (l > 0) cv = amrex::coarsen(cv, amr.refRatio(l-1));
+    }
+    amrex::Abort("No data");
+    return 0.0;
+}
+
+bool near (Real value, Real expect)
+{
+    return std::abs(value - expect) <= 1.e-12*std::abs(expect);
+}
+
+// Check a field reduction of components factor[n]*phi over box of level lev,
+// coarsened by crse.
+void checkField (const Amr& amr, const std::string& name, int lev, const Box& box, int crse,
+                 const Vector<Real>& factor)
+{
+    const Vector<Real> value = readRecord(name);
+    AMREX_ALWAYS_ASSERT(value.size() == factor.size()*box.numPts());
+    long i = 0;
+    for (Real f : factor) {
+        for (IntVect ov = box.smallEnd(); ov <= box.bigEnd(); box.next(ov), ++i) {
+            // The center of the output cell is at the corner between the
+            // centers of its cells, so average the expected values.
+            const Box cells = amrex::refine(Box(ov,ov), crse);
+            Real expect = 0.0;
+            for (BoxIterator bi(cells); bi.ok(); ++bi) {
+                expect += expected(amr, lev, bi());
+            }
+            expect *= f / cells.numPts();
+            AMREX_ALWAYS_ASSERT(near(value[i], expect));
+        }
+    }
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        Amr amr;
+        amr.init(0.0, -1.0);
+        AMREX_ALWAYS_ASSERT(amr.finestLevel() == 2);
+
+        {
+            InSituReduction insitu(amr, false);
+            insitu.update(amr);
+        }
+
+        if (ParallelDescriptor::IOProcessor())
+        {
+            // minmax over [0,0.5]^3 of phi, 2 phi and 3 phi: the smallest
+            // cell center is that of the finest level at the origin, the
+            // largest that of level 0 at (0.5,0.5,0.5).
+            const Vector<Real> stats = readRecord("stats");
+            AMREX_ALWAYS_ASSERT(stats.size() == 9);
+            const Real dx2 = amr.Geom(2).CellSize(0);
+            const Real dx0 = amr.Geom(0).CellSize(0);
+            const Real pmin = phi(RealVect(AMREX_D_DECL(0.5*dx2, 0.5*dx2, 0.5*dx2)));
+            const Real pmax = phi(RealVect(AMREX_D_DECL(0.5-0.5*dx0, 0.5-0.5*dx0, 0.5-0.5*dx0)));
+            const Real pmean = phi(RealVect(AMREX_D_DECL(0.25, 0.25, 0.25)));
+            const Real factor[] = {1.0, 2.0, 3.0};
+            for (int n = 0; n < 3; ++n) {
+                AMREX_ALWAYS_ASSERT(near(stats[3*n],   factor[n]*pmin));
+                AMREX_ALWAYS_ASSERT(near(stats[3*n+1], factor[n]*pmax));
+                AMREX_ALWAYS_ASSERT(near(stats[3*n+2], factor[n]*pmean));
+            }
+
+            // The region of empty falls between cell centers.
+            for (Real v : readRecord("empty")) {
+                AMREX_ALWAYS_ASSERT(std::isnan(v));
+            }
+
+            // average of phis and phi onto level 0 coarsened by 2
+            checkField(amr, "avg", 0, amrex::coarsen(amr.Geom(0).Domain(), 2), 2, {2.0, 3.0, 1.0});
+
+            // slice of level 1 at y = 0.1
+            Box slice = amr.Geom(1).Domain();
+            slice.setRange(1, static_cast<int>(0.1/amr.Geom(1).CellSize(1)));
+            checkField(amr, "yslice", 1, slice, 1, {1.0});
+
+            // lineout along x on level 2 through (0.1,0.2,0.1)
+            Box line = amr.Geom(2).Domain();
+            line.setRange(1, static_cast<int>(0.2/amr.Geom(2).CellSize(1)));
+            line.setRange(2, static_cast<int>(0.1/amr.Geom(2).CellSize(2)));
+            checkField(amr, "line", 2, line, 1, {2.0, 3.0});
+        }
+        ParallelDescriptor::Barrier();
+
+        // As after a restart at this step: appending must not record the
+        // step again.
+        {
+            InSituReduction insitu(amr, true);
+            insitu.update(amr);
+        }
+        if (ParallelDescriptor::IOProcessor()) {
+            for (const std::string name : {"stats", "empty", "avg", "yslice", "line"}) {
+                AMREX_ALWAYS_ASSERT(readRecords(name).size() == 1);
+            }
+        }
+
+        amrex::Print() << "passed!" << std::endl;
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,143 @@
+
+#include <cmath>
+
+#include <AMReX.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+#include <AMReX_EB2.H>
+#include <AMReX_EB2_IF_Sphere.H>
+#include <AMReX_EBFabFactory.H>
+#include <AMReX_EBMultiFabUtil.H>
+#include <AMReX_MLEBABecLap.H>
+#include <AMReX_MLMG.H>
+
+using namespace amrex;
+
+// Compare MLEBABecLap with the precomputed cut-cell stencils with the
+// Fortran kernels around a sphere: the operator applied to the same
+// field, and the solutions of the same problem, which must also be
+// solutions of the other operator.
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 64, max_grid_size = 32, eb_dirichlet = 1;
+        Real radius = 0.25, tol_rel = 1.e-11;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("radius", radius);
+            pp.query("eb_dirichlet", eb_dirichlet);
+            pp.query("tol_rel", tol_rel);
+        }
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        RealBox rb({0.,0.,0.}, {1.,1.,1.});
+        Geometry geom(domain, &rb);
+        EB2::SphereIF sphere(radius, {0.5,0.5,0.5}, false);
+        EB2::Build(EB2::makeShop(sphere), geom, 0, 30);
+
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+        auto factory = makeEBFabFactory(geom, ba, dm, {2,2,2}, EBSupport::full);
+
+        // Variable coefficients, the boundary values and a right-hand side
+        MultiFab acoef(ba, dm, 1, 0, MFInfo(), *factory);
+        MultiFab beta (ba, dm, 1, 0, MFInfo(), *factory);
+        MultiFab bc   (ba, dm, 1, 1, MFInfo(), *factory);
+        MultiFab phi  (ba, dm, 1, 1, MFInfo(), *factory);
+        MultiFab rhs  (ba, dm, 1, 0, MFInfo(), *factory);
+        Array<MultiFab,AMREX_SPACEDIM> bcoef;
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+            bcoef[idim].define(amrex::convert(ba, IntVect::TheDimensionVector(idim)), dm, 1, 0,
+                               MFInfo(), *factory);
+        }
+        for (MFIter mfi(phi); mfi.isValid(); ++mfi)
+        {
+            for (BoxIterator bi(mfi.fabbox()); bi.ok(); ++bi)
+            {
+                const IntVect& iv = bi();
+                bc[mfi](iv)  = std::sin(0.3*iv[0]) + 0.1*iv[2];
+                phi[mfi](iv) = std::cos(0.2*iv[0]*iv[1]) + 0.01*iv[2]*iv[2];
+            }
+            for (BoxIterator bi(mfi.validbox()); bi.ok(); ++bi)
+            {
+                const IntVect& iv = bi();
+                acoef[mfi](iv) = 1.0 + 0.5*std::cos(iv[0]*iv[1] + iv[2]);
+                beta[mfi](iv)  = 1.0 + 0.3*std::sin(iv[0] + 2*iv[1] + 3*iv[2]);
+                rhs[mfi](iv)   = std::sin(0.1*iv[0]*iv[1]) + std::cos(0.2*iv[2]);
+            }
+            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim)
+            {
+                for (BoxIterator bi(bcoef[idim][mfi].box()); bi.ok(); ++bi)
+                {
+                    const IntVect& iv = bi();
+                    bcoef[idim][mfi](iv) = 1.0 + 0.4*std::cos(0.7*iv[0] + iv[1] - iv[2] + idim);
+                }
+            }
+        }
+        EB_set_covered(rhs, 0.0);
+
+        // Without (0) and with (1) the precomputed stencils
+        MLEBABecLap op0({geom}, {ba}, {dm}, LPInfo(), {factory.get()});
+        MLEBABecLap op1({geom}, {ba}, {dm}, LPInfo(), {factory.get()});
+        op0.setPrecomputeStencil(false);
+        op1.setPrecomputeStencil(true);
+        for (MLEBABecLap* op : {&op0, &op1})
+        {
+            op->setDomainBC({LinOpBCType::Dirichlet, LinOpBCType::Neumann,   LinOpBCType::Dirichlet},
+                            {LinOpBCType::Neumann,   LinOpBCType::Dirichlet, LinOpBCType::Dirichlet});
+            op->setLevelBC(0, &bc);
+            op->setScalars(0.7, 1.3);
+            op->setACoeffs(0, acoef);
+            op->setBCoeffs(0, amrex::GetArrOfConstPtrs(bcoef));
+            if (eb_dirichlet) {
+                op->setEBDirichlet(0, bc, beta);
+            }
+        }
+        MLMG mlmg0(op0), mlmg1(op1);
+
+        // The operator applied to the same field
+        MultiFab out0(ba, dm, 1, 0, MFInfo(), *factory);
+        MultiFab out1(ba, dm, 1, 0, MFInfo(), *factory);
+        mlmg0.apply({&out0}, {&phi});
+        mlmg1.apply({&out1}, {&phi});
+        const Real out_norm = out0.norm0();
+        MultiFab::Subtract(out1, out0, 0, 0, 1, 0);
+        AMREX_ALWAYS_ASSERT(out1.norm0() <= 1.e-12*out_norm);
+
+        // The solutions, and the residual of each under the other operator
+        MultiFab sol0(ba, dm, 1, 1, MFInfo(), *factory);
+        MultiFab sol1(ba, dm, 1, 1, MFInfo(), *factory);
+        sol0.setVal(0.0);
+        sol1.setVal(0.0);
+        mlmg0.solve({&sol0}, {&rhs}, tol_rel, 0.0);
+        mlmg1.solve({&sol1}, {&rhs}, tol_rel, 0.0);
+
+        // relative to the initial residual, as in MLMG
+        MultiFab zero(ba, dm, 1, 1, MFInfo(), *factory);
+        MultiFab res0(ba, dm, 1, 0, MFInfo(), *factory);
+        zero.setVal(0.0);
+        mlmg0.apply({&res0}, {&zero});
+        MultiFab::Subtract(res0, rhs, 0, 0, 1, 0);
+        const Real res0_norm = res0.norm0();
+        for (int p = 0; p < 2; ++p)
+        {
+            MultiFab res(ba, dm, 1, 0, MFInfo(), *factory);
+            (p == 0 ? mlmg1 : mlmg0).apply({&res}, {p == 0 ? &sol0 : &sol1});
+            MultiFab::Subtract(res, rhs, 0, 0, 1, 0);
+            AMREX_ALWAYS_ASSERT(res.norm0() <= 10.0*tol_rel*res0_norm);
+        }
+
+        const Real sol_norm = sol0.norm0();
+        MultiFab::Subtract(sol1, sol0, 0, 0, 1, 0);
+        AMREX_ALWAYS_ASSERT(sol1.norm0() <= 1.e3*tol_rel*sol_norm);
+
+        amrex::Print() << "passed!" << std::endl;
+    }
+    amrex::Finalize();
+}
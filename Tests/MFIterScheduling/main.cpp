@@ -0,0 +1,133 @@
+
+#include <cmath>
+#include <iomanip>
+
+#include <AMReX.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+namespace {
+
+// A cell costs its number of iterations, work or hot_work.
+void
+kernel (const Box& bx, FArrayBox& fab, const FArrayBox& nwork)
+{
+    const auto lo = amrex::lbound(bx);
+    const auto hi = amrex::ubound(bx);
+    for         (int k = lo.z; k <= hi.z; ++k) {
+        for     (int j = lo.y; j <= hi.y; ++j) {
+            for (int i = lo.x; i <= hi.x; ++i) {
+                const IntVect iv(AMREX_D_DECL(i,j,k));
+                const int n = static_cast<int>(nwork(iv));
+                Real x = fab(iv);
+                for (int m = 0; m < n; ++m) {
+                    x = std::sqrt(x*x + 1.e-3) * 0.999;
+                }
+                fab(iv) = x;
+            }
+        }
+    }
+}
+
+Real
+run (MultiFab& mf, const MultiFab& nwork, const MFItInfo& info, int nsteps)
+{
+    Real tavg = 0.0;
+    for (int step = 0; step <= nsteps; ++step)
+    {
+        Real t = amrex::second();
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        for (MFIter mfi(mf, info); mfi.isValid(); ++mfi)
+        {
+            kernel(mfi.tilebox(), mf[mfi], nwork[mfi]);
+        }
+        t = amrex::second() - t;
+        if (step > 0) tavg += t;  // step 0 is the warm up, and learns the tile costs
+    }
+    return tavg / nsteps;
+}
+
+}
+
+// Time an MFIter loop with static, dynamic and work stealing scheduling,
+// for uniform and skewed cell costs.
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 128, max_grid_size = 32, nsteps = 5;
+        int work = 10, hot_work = 200;
+        Real radius = 0.2;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("nsteps", nsteps);
+            pp.query("work", work);
+            pp.query("hot_work", hot_work);
+            pp.query("radius", radius);
+        }
+
+        BoxArray ba(Box(IntVect(0), IntVect(n_cell-1)));
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        MultiFab mf(ba, dm, 1, 0);
+        MultiFab nwork(ba, dm, 1, 0);
+
+        amrex::Print() << "n_cell " << n_cell << ", max_grid_size " << max_grid_size
+                       << ", tile size " << FabArrayBase::mfiter_tile_size
+#ifdef _OPENMP
+                       << ", threads " << omp_get_max_threads()
+#endif
+                       << "\n  workload   static    dynamic   stealing  stealing+tile cost\n";
+
+        for (int skewed = 0; skewed <= 1; ++skewed)
+        {
+            const Real r2 = radius*radius*n_cell*n_cell;
+            const Real c = 0.5*n_cell;
+            for (MFIter mfi(nwork); mfi.isValid(); ++mfi)
+            {
+                FArrayBox& fab = nwork[mfi];
+                const Box& bx = mfi.validbox();
+                for (BoxIterator bi(bx); bi.ok(); ++bi)
+                {
+                    const IntVect& iv = bi();
+                    Real d2 = 0.0;
+                    for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                        d2 += (iv[d]+0.5-c)*(iv[d]+0.5-c);
+                    }
+                    fab(iv) = (skewed && d2 < r2) ? hot_work : work;
+                }
+            }
+
+            Vector<Real> tile_cost;
+            MFItInfo info_static = MFItInfo().EnableTiling();
+            MFItInfo info_dynamic = MFItInfo().EnableTiling().SetDynamic(true);
+            MFItInfo info_steal = MFItInfo().EnableTiling().SetWorkStealing(true);
+            MFItInfo info_learn = MFItInfo().EnableTiling().SetWorkStealing(true).SetTileCost(&tile_cost);
+
+            mf.setVal(1.0);
+            const Real t_static = run(mf, nwork, info_static, nsteps);
+            mf.setVal(1.0);
+            const Real t_dynamic = run(mf, nwork, info_dynamic, nsteps);
+            mf.setVal(1.0);
+            const Real t_steal = run(mf, nwork, info_steal, nsteps);
+            mf.setVal(1.0);
+            const Real t_learn = run(mf, nwork, info_learn, nsteps);
+
+            amrex::Print() << "  " << std::left << std::setw(9) << (skewed ? "skewed" : "uniform")
+                           << std::right << std::scientific << std::setprecision(3)
+                           << std::setw(10) << t_static
+                           << std::setw(11) << t_dynamic
+                           << std::setw(11) << t_steal
+                           << std::setw(13) << t_learn << "\n";
+        }
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,132 @@
+
+#include <algorithm>
+#include <cmath>
+
+#include <AMReX.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_MultiFabReducer.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+namespace {
+
+bool
+near (Real value, Real expect)
+{
+    return std::abs(value - expect) <= 1.e-10*std::max(1.0, std::abs(expect));
+}
+
+}
+
+// Compare the reductions of a MultiFabReducer, over MultiFabs on two
+// BoxArrays with ghost cells and masks, with the separate MultiFab
+// reductions, and time both.
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv);
+    {
+        int n_cell = 64, max_grid_size = 16, nred = 30, nsteps = 5;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("nred", nred);
+            pp.query("nsteps", nsteps);
+        }
+
+        const Box domain(IntVect(0), IntVect(n_cell-1));
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+        BoxArray ba2(domain);
+        ba2.maxSize(2*max_grid_size);
+        DistributionMapping dm2(ba2);
+
+        MultiFab  a(ba, dm, 3, 2);
+        MultiFab  b(ba, dm, 2, 2);
+        MultiFab  c(ba2, dm2, 1, 0);
+        iMultiFab mask(ba, dm, 1, 2);
+
+        for (MFIter mfi(a); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.fabbox();
+            for (BoxIterator bi(bx); bi.ok(); ++bi)
+            {
+                const IntVect& iv = bi();
+                for (int n = 0; n < 3; ++n) {
+                    a[mfi](iv,n) = std::sin(0.1*iv[0] + 0.2*(n+1)*iv[1] - 0.05*iv[2]);
+                }
+                for (int n = 0; n < 2; ++n) {
+                    b[mfi](iv,n) = std::cos(0.07*(n+1)*iv[0] + 0.3*iv[2]);
+                }
+                mask[mfi](iv) = (iv[0] + iv[1] + iv[2]) % 3 != 0;
+            }
+        }
+        c.setVal(0.5);
+
+        MultiFabReducer r;
+        const int isum   = r.addSum(a, 0);
+        const int imin   = r.addMin(a, 1, 2);
+        const int imax   = r.addMax(b, 1, 1);
+        const int inorm0 = r.addNorm0(a, 2);
+        const int inorm1 = r.addNorm1(b, 0, 2);
+        const int inorm2 = r.addNorm2(a, 1);
+        const int idot   = r.addDot(a, 0, b, 1, 1);
+        const int imdot  = r.addDot(a, 2, b, 0, 0, &mask);
+        const int isumc  = r.addSum(c, 0);
+        const int imnorm = r.addNorm0(a, 0, 0, &mask);
+        r.eval();
+
+        AMREX_ALWAYS_ASSERT(near(r[isum], a.sum(0)));
+        AMREX_ALWAYS_ASSERT(near(r[imin], a.min(1, 2)));
+        AMREX_ALWAYS_ASSERT(near(r[imax], b.max(1, 1)));
+        AMREX_ALWAYS_ASSERT(near(r[inorm0], a.norm0(2)));
+        AMREX_ALWAYS_ASSERT(near(r[inorm1], b.norm1(0, 2)));
+        AMREX_ALWAYS_ASSERT(near(r[inorm2], a.norm2(1)));
+        AMREX_ALWAYS_ASSERT(near(r[idot], MultiFab::Dot(a, 0, b, 1, 1, 1)));
+        AMREX_ALWAYS_ASSERT(near(r[imdot], MultiFab::Dot(mask, a, 2, b, 0, 1, 0)));
+        AMREX_ALWAYS_ASSERT(near(r[isumc], c.sum(0)));
+        AMREX_ALWAYS_ASSERT(near(r[imnorm], a.norm0(mask, 0, 0)));
+
+        a.mult(2.0, 0, 1);
+        r.eval_nowait();
+        r.eval_finish();
+        AMREX_ALWAYS_ASSERT(near(r[isum], a.sum(0)));
+
+        // nred separate reductions against one MultiFabReducer
+        MultiFabReducer fused;
+        for (int i = 0; i < nred; ++i) {
+            if (i % 2 == 0) {
+                fused.addMax(a, i % 3);
+            } else {
+                fused.addSum(a, i % 3);
+            }
+        }
+
+        Real t_separate = amrex::second();
+        Vector<Real> separate(nred);
+        for (int step = 0; step < nsteps; ++step) {
+            for (int i = 0; i < nred; ++i) {
+                separate[i] = (i % 2 == 0) ? a.max(i % 3) : a.sum(i % 3);
+            }
+        }
+        t_separate = (amrex::second() - t_separate) / nsteps;
+
+        Real t_fused = amrex::second();
+        for (int step = 0; step < nsteps; ++step) {
+            fused.eval();
+        }
+        t_fused = (amrex::second() - t_fused) / nsteps;
+
+        for (int i = 0; i < nred; ++i) {
+            AMREX_ALWAYS_ASSERT(near(fused[i], separate[i]));
+        }
+
+        amrex::Print() << nred << " reductions: separate " << t_separate
+                       << " s, fused " << t_fused << " s\n";
+        amrex::Print() << "passed!" << std::endl;
+    }
+    amrex::Finalize();
+}
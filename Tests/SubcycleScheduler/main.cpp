@@ -0,0 +1,393 @@
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include <AMReX.H>
+#include <AMReX_Amr.H>
+#include <AMReX_AmrLevel.H>
+#include <AMReX_LevelBld.H>
+#include <AMReX_MultiFabUtil.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_PhysBCFunct.H>
+#include <AMReX_Print.H>
+#include <AMReX_PROB_AMR_F.H>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace amrex;
+
+extern "C" {
+    void amrex_probinit (const int* init,
+                         const int* name,
+                         const int* namelen,
+                         const amrex_real* problo,
+                         const amrex_real* probhi)
+    {}
+}
+
+// Diffusion on an AmrLevel that implements the grid advance of the
+// task-graph subcycling scheduler.  The scheduler must give the same
+// answer as the recursive one, and the fine level must not wait for the
+// coarse grids away from it.
+
+namespace {
+
+struct Record
+{
+    int  level;
+    int  grid;
+    Real start;
+    Real stop;
+};
+
+Vector<Record> trace;
+bool recording = false;
+int crse_delay = 40;
+int fine_delay = 5;
+
+CpuBndryFuncFab cpu_bndry_func(nullptr);
+
+void test_bcfill (Box const& bx, FArrayBox& data, const int dcomp, const int numcomp,
+                  Geometry const& geom, const Real time, const Vector<BCRec>& bcr,
+                  const int bcomp, const int scomp)
+{
+    cpu_bndry_func(bx, data, dcomp, numcomp, geom, time, bcr, bcomp, scomp);
+}
+
+}
+
+class TestLevel
+    : public AmrLevel
+{
+public:
+
+    enum StateType { State_Type = 0 };
+
+    TestLevel () {}
+
+    TestLevel (Amr& papa, int lev, const Geometry& level_geom, const BoxArray& ba,
+               const DistributionMapping& dm, Real time)
+        : AmrLevel(papa, lev, level_geom, ba, dm, time) {}
+
+    static void variableSetUp ()
+    {
+        desc_lst.addDescriptor(State_Type, IndexType::TheCellType(), StateDescriptor::Point,
+                               0, 1, &cell_cons_interp);
+        BCRec bc;
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+            bc.setLo(idim, BCType::foextrap);
+            bc.setHi(idim, BCType::foextrap);
+        }
+        StateDescriptor::BndryFunc bndryfunc(test_bcfill);
+        desc_lst.setComponent(State_Type, 0, "phi", bc, bndryfunc);
+    }
+
+    static void variableCleanUp () { desc_lst.clear(); }
+
+    virtual void initData () override
+    {
+        MultiFab& S_new = get_new_data(State_Type);
+        const Real* dx = geom.CellSize();
+        for (MFIter mfi(S_new); mfi.isValid(); ++mfi) {
+            FArrayBox& fab = S_new[mfi];
+            for (BoxIterator bi(mfi.validbox()); bi.ok(); ++bi) {
+                Real r2 = 0.0;
+                for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                    const Real x = (bi()[idim] + 0.5)*dx[idim] - 0.2;
+                    r2 += x*x;
+                }
+                fab(bi(), 0) = std::exp(-20.0*r2);
+            }
+        }
+    }
+
+    virtual void init (AmrLevel& old) override
+    {
+        const Real cur_time = old.get_state_data(State_Type).curTime();
+        const Real dt_old   = cur_time - old.get_state_data(State_Type).prevTime();
+        setTimeLevel(cur_time, dt_old, 0.0);
+        MultiFab& S_new = get_new_data(State_Type);
+        FillPatch(old, S_new, 0, cur_time, State_Type, 0, 1);
+    }
+
+    virtual void init () override
+    {
+        const Real cur_time = getLevel(level-1).get_state_data(State_Type).curTime();
+        const Real dt_old   = cur_time - getLevel(level-1).get_state_data(State_Type).prevTime();
+        setTimeLevel(cur_time, dt_old/parent->nCycle(level), 0.0);
+        FillCoarsePatch(get_new_data(State_Type), 0, cur_time, State_Type, 0, 1);
+    }
+
+    virtual bool supportsGridAdvance () const override { return true; }
+
+    virtual int advanceGhostCells () const override { return 1; }
+
+    virtual void advanceBegin (Real time, Real dt, int iteration, int ncycle) override
+    {
+        state[State_Type].allocOldData();
+        state[State_Type].swapTimeLevels(dt);
+        Sborder.define(grids, dmap, 1, 1);
+        FillPatch(*this, Sborder, 1, time, State_Type, 0, 1);
+    }
+
+    virtual void advanceGrid (Real time, Real dt, int iteration, int ncycle, int grid) override
+    {
+        const Real start = amrex::second();
+
+        const Real* dx = geom.CellSize();
+        const FArrayBox& sold = Sborder[grid];
+        FArrayBox& snew = get_new_data(State_Type)[grid];
+        for (BoxIterator bi(grids[grid]); bi.ok(); ++bi) {
+            const IntVect& iv = bi();
+            Real lap = 0.0;
+            for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                const IntVect e = IntVect::TheDimensionVector(idim);
+                lap += (sold(iv+e) - 2.0*sold(iv) + sold(iv-e)) / (dx[idim]*dx[idim]);
+            }
+            snew(iv) = sold(iv) + dt*diff_coef*lap;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(level == 0 ? crse_delay : fine_delay));
+
+        if (recording) {
+#ifdef _OPENMP
+#pragma omp critical (test_trace)
+#endif
+            trace.push_back(Record{level, grid, start, amrex::second()});
+        }
+    }
+
+    virtual Real advanceEnd (Real time, Real dt, int iteration, int ncycle) override
+    {
+        Sborder.clear();
+        return dt;
+    }
+
+    virtual Real advance (Real time, Real dt, int iteration, int ncycle) override
+    {
+        advanceBegin(time, dt, iteration, ncycle);
+        for (MFIter mfi(Sborder); mfi.isValid(); ++mfi) {
+            advanceGrid(time, dt, iteration, ncycle, mfi.index());
+        }
+        return advanceEnd(time, dt, iteration, ncycle);
+    }
+
+    virtual void post_timestep (int iteration) override
+    {
+        if (level < parent->finestLevel()) {
+            average_down(getLevel(level+1).get_new_data(State_Type), get_new_data(State_Type),
+                         0, 1, parent->refRatio(level));
+        }
+    }
+
+    virtual void computeInitialDt (int finest_level, int sub_cycle, Vector<int>& n_cycle,
+                                   const Vector<IntVect>& ref_ratio, Vector<Real>& dt_level,
+                                   Real stop_time) override
+    {
+        computeDt(finest_level, n_cycle, dt_level);
+    }
+
+    virtual void computeNewDt (int finest_level, int sub_cycle, Vector<int>& n_cycle,
+                               const Vector<IntVect>& ref_ratio, Vector<Real>& dt_min,
+                               Vector<Real>& dt_level, Real stop_time, int post_regrid_flag) override
+    {
+        computeDt(finest_level, n_cycle, dt_level);
+    }
+
+    virtual void errorEst (TagBoxArray& tags, int clearval, int tagval, Real time,
+                           int n_error_buf, int ngrow) override
+    {
+        // A corner of the domain, smaller on each level.
+        const Real* dx = geom.CellSize();
+        const Real xtag = 0.25/(level+1);
+        for (MFIter mfi(tags); mfi.isValid(); ++mfi) {
+            TagBox& tb = tags[mfi];
+            for (BoxIterator bi(mfi.validbox()); bi.ok(); ++bi) {
+                bool tag = true;
+                for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+                    tag = tag && (bi()[idim] + 0.5)*dx[idim] < xtag;
+                }
+                if (tag) tb(bi()) = tagval;
+            }
+        }
+    }
+
+    virtual void post_regrid (int lbase, int new_finest) override {}
+    virtual void post_init (Real stop_time) override {}
+
+private:
+
+    TestLevel& getLevel (int lev) { return static_cast<TestLevel&>(parent->getLevel(lev)); }
+
+    void computeDt (int finest_level, Vector<int>& n_cycle, Vector<Real>& dt_level)
+    {
+        const Real dx0 = parent->Geom(0).CellSize(0);
+        dt_level[0] = 0.02*dx0*dx0/diff_coef;
+        for (int lev = 1; lev <= finest_level; ++lev) {
+            n_cycle[lev]  = parent->refRatio(lev-1)[0];
+            dt_level[lev] = dt_level[lev-1]/n_cycle[lev];
+        }
+    }
+
+    static constexpr Real diff_coef = 0.1;
+
+    MultiFab Sborder;
+};
+
+class TestLevelBld
+    : public LevelBld
+{
+    virtual void variableSetUp () override { TestLevel::variableSetUp(); }
+    virtual void variableCleanUp () override { TestLevel::variableCleanUp(); }
+    virtual AmrLevel* operator() () override { return new TestLevel; }
+    virtual AmrLevel* operator() (Amr& papa, int lev, const Geometry& level_geom,
+                                  const BoxArray& ba, const DistributionMapping& dm,
+                                  Real time) override
+    {
+        return new TestLevel(papa, lev, level_geom, ba, dm, time);
+    }
+};
+
+TestLevelBld test_bld;
+
+LevelBld*
+getLevelBld ()
+{
+    return &test_bld;
+}
+
+namespace {
+
+struct Result
+{
+    Vector<BoxArray> grids;
+    Vector<std::unique_ptr<MultiFab> > data;
+};
+
+// Take max_step coarse steps, recording the tasks of the last one.
+Result run (int max_step, BoxArray& fine_grids)
+{
+    Result r;
+    Amr amr;
+    amr.init(0.0, -1.0);
+
+    for (int step = 1; step <= max_step; ++step)
+    {
+        recording = (step == max_step);
+        if (recording) {
+            trace.clear();
+            fine_grids = (amr.finestLevel() > 0) ? amr.boxArray(1) : BoxArray();
+        }
+        amr.coarseTimeStep(-1.0);
+    }
+    recording = false;
+
+    for (int lev = 0; lev <= amr.finestLevel(); ++lev)
+    {
+        const MultiFab& S = amr.getLevel(lev).get_new_data(TestLevel::State_Type);
+        r.grids.push_back(S.boxArray());
+        r.data.emplace_back(new MultiFab(S.boxArray(), S.DistributionMap(), 1, 0));
+        MultiFab::Copy(*r.data.back(), S, 0, 0, 1, 0);
+    }
+    return r;
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int max_step = 3;
+        {
+            ParmParse pp;
+            pp.query("max_step", max_step);
+            ParmParse ppt("test");
+            ppt.query("crse_delay", crse_delay);
+            ppt.query("fine_delay", fine_delay);
+        }
+
+        int nthreads = 1;
+#ifdef _OPENMP
+        nthreads = omp_get_max_threads();
+#endif
+
+        BoxArray fine_grids;
+
+        Real t0 = amrex::second();
+        Result recursive = run(max_step, fine_grids);
+        const Real t_recursive = amrex::second() - t0;
+
+        {
+            ParmParse pp("amr");
+            pp.add("subcycle_scheduler", std::string("taskgraph"));
+        }
+
+        t0 = amrex::second();
+        Result taskgraph = run(max_step, fine_grids);
+        const Real t_taskgraph = amrex::second() - t0;
+
+        // Same answer.
+        if (recursive.grids.size() != taskgraph.grids.size()) {
+            amrex::Abort("The schedulers built different hierarchies");
+        }
+        for (int lev = 0; lev < recursive.grids.size(); ++lev)
+        {
+            if (recursive.grids[lev] != taskgraph.grids[lev]) {
+                amrex::Abort("The schedulers built different grids");
+            }
+            MultiFab::Subtract(*taskgraph.data[lev], *recursive.data[lev], 0, 0, 1, 0);
+            const Real diff = taskgraph.data[lev]->norm0();
+            amrex::Print() << "level " << lev << ": max difference " << diff << "\n";
+            if (diff != 0.0) {
+                amrex::Abort("The schedulers disagree");
+            }
+        }
+
+        // The coarse grids away from the fine level, and when the fine
+        // level started and finished in the last step.
+        if (fine_grids.empty()) {
+            amrex::Abort("No fine level");
+        }
+        BoxArray under = amrex::coarsen(fine_grids, 2);
+        under.grow(2);
+        const BoxArray& crse_grids = taskgraph.grids[0];
+        Real fine_start = std::numeric_limits<Real>::max();
+        Real fine_stop  = std::numeric_limits<Real>::lowest();
+        for (const Record& rec : trace) {
+            if (rec.level > 0) {
+                fine_start = std::min(fine_start, rec.start);
+                fine_stop  = std::max(fine_stop,  rec.stop);
+            }
+        }
+        int nfar = 0, nafter_start = 0, nbefore_stop = 0;
+        for (const Record& rec : trace) {
+            if (rec.level == 0 && !under.intersects(crse_grids[rec.grid])) {
+                ++nfar;
+                if (rec.stop > fine_start) ++nafter_start;
+                if (rec.stop < fine_stop)  ++nbefore_stop;
+            }
+        }
+
+        amrex::Print() << "threads " << nthreads
+                       << ", recursive " << t_recursive << " s, taskgraph " << t_taskgraph << " s\n"
+                       << "coarse grids away from the fine level: " << nfar
+                       << ", finished after the fine level started: " << nafter_start
+                       << ", finished before the fine subcycles: " << nbefore_stop << "\n";
+
+        if (nfar == 0) {
+            amrex::Abort("No coarse grid away from the fine level");
+        }
+        // The fine level ran ahead of the coarse grids it does not need,
+        // and with threads they completed while it was subcycling.
+        if (nafter_start == 0 || (nthreads > 1 && nbefore_stop == 0)) {
+            amrex::Abort("The fine level waited for the coarse grids away from it");
+        }
+
+        amrex::Print() << "passed!" << std::endl;
+    }
+    amrex::Finalize();
+}